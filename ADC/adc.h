@@ -1110,6 +1110,150 @@
 
 #endif
 
+/*
+	Configuración automática del reloj de conversión y del tiempo de adquisición en tiempo de compilación.
+	Se activa si la aplicación define ADC_IMPEDANCIA_FUENTE_OHMS (p. ej. en pconfig.h). Opcionalmente puede definirse
+	ADC_MUESTRAS_POR_SEG para validar la tasa de conversión requerida.
+	Resultados:
+	- ADC_AUTO_FOSC:		Reloj de conversión más rápido que respeta TAD mínimo (macro ADC_FOSC_x)
+	- ADC_AUTO_TAD_NS:		TAD obtenido en [ns]
+	- ADC_AUTO_TACQ_NS:		Tiempo de adquisición requerido por la impedancia de la fuente en [ns]
+	- ADC_AUTO_ACQT:		Tiempo de adquisición programable mínimo que cubre ADC_AUTO_TACQ_NS (macro ADC_x_TAD)
+	- ADC_AUTO_TACQ_US:		Tiempo de adquisición en [us], para versiones sin ACQT (espera por software)
+	- ADC_AUTO_MUESTRA_NS:	Tiempo total por conversión (adquisición + conversión) en [ns]
+	- ADC_AUTO_CONFIG:		ADC_AUTO_FOSC | ADC_AUTO_ACQT, para combinar con la justificación en adc_init
+	Los parámetros eléctricos por defecto son los típicos de hoja de datos y pueden redefinirse antes de incluir adc.h.
+	Las operaciones se ordenan para no exceder 32 bits en el preprocesador.
+*/
+#if defined (ADC_IMPEDANCIA_FUENTE_OHMS) && !defined (ADC_V15) && !defined (ADC_V15_1)
+
+#if !defined (_XTAL_FREQ)
+#error "ADC_IMPEDANCIA_FUENTE_OHMS requiere _XTAL_FREQ"
+#endif
+
+#if defined (ADC_V13) || defined (ADC_V13_1) || defined (ADC_V13_2) || defined (ADC_V13_3)
+#define ADC_AUTO_BITS		12
+#else
+#define ADC_AUTO_BITS		10
+#endif
+
+#ifndef ADC_TAD_MIN_NS
+#if defined (ADC_V13) || defined (ADC_V13_1) || defined (ADC_V13_2) || defined (ADC_V13_3) ||\
+	defined (ADC_V14) || defined (ADC_V14_1) || defined (ADC_V14_2) || defined (ADC_V14_3)
+#define ADC_TAD_MIN_NS		1000		// TAD mínimo en [ns]
+#else
+#define ADC_TAD_MIN_NS		700			// TAD mínimo en [ns]
+#endif
+#endif
+#ifndef ADC_TAD_MAX_NS
+#define ADC_TAD_MAX_NS		25000		// TAD máximo en [ns]
+#endif
+#ifndef ADC_TAD_RC_NS
+#define ADC_TAD_RC_NS		4000		// TAD del oscilador RC interno, peor caso en [ns]
+#endif
+#ifndef ADC_TCONV_TAD
+#if (ADC_AUTO_BITS == 12)
+#define ADC_TCONV_TAD		14			// TAD por conversión de 12 bits
+#else
+#define ADC_TCONV_TAD		11			// TAD por conversión de 10 bits
+#endif
+#endif
+#ifndef ADC_CHOLD_PF
+#define ADC_CHOLD_PF		25			// Capacitor de retención en [pF]
+#endif
+#ifndef ADC_RIC_RSS_OHMS
+#define ADC_RIC_RSS_OHMS	3000		// Resistencia de interconexión (1k) más resistencia del switch de muestreo (2k)
+#endif
+#ifndef ADC_TAMP_NS
+#define ADC_TAMP_NS			200			// Tiempo de establecimiento del amplificador en [ns]
+#endif
+#ifndef ADC_TCOFF_NS
+#define ADC_TCOFF_NS		1200		// Coeficiente de temperatura a 85°C: (85 - 25) * 20[ns/°C]
+#endif
+
+/* ln(2^(N+1)) * 1000: error de carga menor a 1/2 LSB */
+#if (ADC_AUTO_BITS == 12)
+#define ADC_AUTO_LN_X1000	9011
+#else
+#define ADC_AUTO_LN_X1000	7625
+#endif
+
+/* TACQ = TAMP + TC + TCOFF, con TC = CHOLD * (RIC + RSS + RS) * ln(2^(N+1)) */
+#define ADC_AUTO_TC_NS		(((((ADC_RIC_RSS_OHMS) + (ADC_IMPEDANCIA_FUENTE_OHMS)) * (ADC_CHOLD_PF) + 999) / 1000 * ADC_AUTO_LN_X1000 + 999) / 1000)
+#define ADC_AUTO_TACQ_NS	((ADC_TAMP_NS) + ADC_AUTO_TC_NS + (ADC_TCOFF_NS))
+#define ADC_AUTO_TACQ_US	((ADC_AUTO_TACQ_NS + 999) / 1000)
+
+/* Divisor de Fosc válido si Fosc / d no excede 1 / TAD_MIN */
+#define _ADC_AUTO_DIV_OK(d)	((((_XTAL_FREQ) / 1000) * (ADC_TAD_MIN_NS)) <= ((d) * 1000000UL))
+#define _ADC_AUTO_TAD(d)	(((d) * 1000000UL + ((_XTAL_FREQ) / 1000) - 1) / ((_XTAL_FREQ) / 1000))
+
+#if ((((_XTAL_FREQ) / 1000) * (ADC_TAD_MAX_NS)) < (2 * 1000000UL))
+#define ADC_AUTO_FOSC		ADC_FOSC_RC		// Reloj del sistema tan lento que incluso Fosc/2 excede TAD máximo
+#define ADC_AUTO_TAD_NS		ADC_TAD_RC_NS
+#elif _ADC_AUTO_DIV_OK(2)
+#define ADC_AUTO_FOSC		ADC_FOSC_2
+#define ADC_AUTO_TAD_NS		_ADC_AUTO_TAD(2)
+#elif _ADC_AUTO_DIV_OK(4)
+#define ADC_AUTO_FOSC		ADC_FOSC_4
+#define ADC_AUTO_TAD_NS		_ADC_AUTO_TAD(4)
+#elif _ADC_AUTO_DIV_OK(8)
+#define ADC_AUTO_FOSC		ADC_FOSC_8
+#define ADC_AUTO_TAD_NS		_ADC_AUTO_TAD(8)
+#elif _ADC_AUTO_DIV_OK(16)
+#define ADC_AUTO_FOSC		ADC_FOSC_16
+#define ADC_AUTO_TAD_NS		_ADC_AUTO_TAD(16)
+#elif _ADC_AUTO_DIV_OK(32)
+#define ADC_AUTO_FOSC		ADC_FOSC_32
+#define ADC_AUTO_TAD_NS		_ADC_AUTO_TAD(32)
+#elif _ADC_AUTO_DIV_OK(64)
+#define ADC_AUTO_FOSC		ADC_FOSC_64
+#define ADC_AUTO_TAD_NS		_ADC_AUTO_TAD(64)
+#else
+#error "_XTAL_FREQ demasiado alta: ningún divisor de Fosc cumple TAD mínimo"
+#endif
+
+#if defined (ADC_V1) || defined (ADC_V2)
+/* Sin tiempo de adquisición programable: la espera se realiza por software tras cada cambio de canal */
+#define ADC_AUTO_ACQT		0
+#define ADC_AUTO_MUESTRA_NS	(ADC_AUTO_TACQ_US * 1000UL + ADC_TCONV_TAD * ADC_AUTO_TAD_NS)
+#else
+#if (2 * ADC_AUTO_TAD_NS >= ADC_AUTO_TACQ_NS)
+#define ADC_AUTO_ACQT		ADC_2_TAD
+#define ADC_AUTO_ACQT_TAD	2
+#elif (4 * ADC_AUTO_TAD_NS >= ADC_AUTO_TACQ_NS)
+#define ADC_AUTO_ACQT		ADC_4_TAD
+#define ADC_AUTO_ACQT_TAD	4
+#elif (6 * ADC_AUTO_TAD_NS >= ADC_AUTO_TACQ_NS)
+#define ADC_AUTO_ACQT		ADC_6_TAD
+#define ADC_AUTO_ACQT_TAD	6
+#elif (8 * ADC_AUTO_TAD_NS >= ADC_AUTO_TACQ_NS)
+#define ADC_AUTO_ACQT		ADC_8_TAD
+#define ADC_AUTO_ACQT_TAD	8
+#elif (12 * ADC_AUTO_TAD_NS >= ADC_AUTO_TACQ_NS)
+#define ADC_AUTO_ACQT		ADC_12_TAD
+#define ADC_AUTO_ACQT_TAD	12
+#elif (16 * ADC_AUTO_TAD_NS >= ADC_AUTO_TACQ_NS)
+#define ADC_AUTO_ACQT		ADC_16_TAD
+#define ADC_AUTO_ACQT_TAD	16
+#elif (20 * ADC_AUTO_TAD_NS >= ADC_AUTO_TACQ_NS)
+#define ADC_AUTO_ACQT		ADC_20_TAD
+#define ADC_AUTO_ACQT_TAD	20
+#else
+#error "ADC_IMPEDANCIA_FUENTE_OHMS demasiado alta: el tiempo de adquisición excede 20 TAD"
+#endif
+#define ADC_AUTO_MUESTRA_NS	((ADC_AUTO_ACQT_TAD + ADC_TCONV_TAD) * ADC_AUTO_TAD_NS)
+#endif
+
+#define ADC_AUTO_CONFIG		(ADC_AUTO_FOSC | ADC_AUTO_ACQT)
+
+#if defined (ADC_MUESTRAS_POR_SEG)
+#if (ADC_AUTO_MUESTRA_NS > (1000000000UL / (ADC_MUESTRAS_POR_SEG)))
+#error "ADC_MUESTRAS_POR_SEG no alcanzable con _XTAL_FREQ y ADC_IMPEDANCIA_FUENTE_OHMS"
+#endif
+#endif
+
+#endif
+
 /*
 	Definición de prototipos de funciones:
 	- adc_init
@@ -1144,7 +1288,7 @@ void adc_init ( uint8_t param_config , uint8_t param_config2 , uint16_t param_co
 
 void adc_init( uint8_t param_config, uint8_t param_config2,	
 uint8_t param_config3, uint8_t param_config4,
-uint8_t param_config5, uint8_t param_config6 uint8_t param_config7, uint8_t param_config8);
+uint8_t param_config5, uint8_t param_config6, uint8_t param_config7, uint8_t param_config8);
 		   
 #endif
 
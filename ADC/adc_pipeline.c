@@ -0,0 +1,310 @@
+/**
+ * @file adc_pipeline.c
+ * @brief Cadena de procesamiento de muestras ADC en flujo continuo: sobremuestreo y diezmado, promedio por bloques (boxcar), estadísticas mín/máx/RMS y anillos de salida por canal. Aritmética entera en punto fijo para núcleos de 8 bits.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "adc_pipeline.h"
+
+#define ADC_PIPELINE_MASCARA_ANILLO	(ADC_PIPELINE_TAM_ANILLO - 1)
+#define ADC_PIPELINE_TAM_BOXCAR		(1 << ADC_PIPELINE_MAX_LOG2_BOXCAR)
+
+/*
+    Límite de muestras en los acumuladores estadísticos. Con 256 muestras de 12 bits la suma de cuadrados
+    aún cabe en 32 bits; al alcanzarlo se dividen entre 2 todos los acumuladores (ponderación exponencial).
+*/
+#define ADC_PIPELINE_STATS_MAX_N	256
+
+#if (ADC_PIPELINE_TAM_ANILLO & ADC_PIPELINE_MASCARA_ANILLO) != 0
+#error "ADC_PIPELINE_TAM_ANILLO debe ser potencia de 2"
+#endif
+
+/*
+    Estado de la cadena de procesamiento de un canal
+*/
+typedef struct adc_pipeline_canal_t {
+	// Diezmado (integrador y volcado)
+	uint8_t log2_diezmado;
+	uint8_t desplazamiento;							// log2_diezmado - bits_extra
+	uint8_t cuenta;									// Muestras acumuladas en el bloque en curso
+	uint24_t acumulador;
+	// Promedio móvil
+	uint8_t log2_boxcar;
+	uint8_t pos_boxcar;								// Posición de escritura en la historia
+	uint8_t llenado_boxcar;							// Salidas en la historia (hasta llenar la ventana)
+	uint24_t suma_boxcar;
+	uint16_t historia[ADC_PIPELINE_TAM_BOXCAR];
+	// Anillo de salida
+	uint16_t anillo[ADC_PIPELINE_TAM_ANILLO];
+	volatile uint8_t cabeza;						// Índice de escritura (interrupción)
+	volatile uint8_t cola;							// Índice de lectura (programa principal)
+	uint16_t overruns;
+	// Estadísticas de muestras crudas
+	uint16_t minimo;
+	uint16_t maximo;
+	uint24_t suma;
+	uint32_t suma_cuadrados;
+	uint16_t n;
+} adc_pipeline_canal_t;
+
+static adc_pipeline_canal_t _adc_pipeline[ADC_PIPELINE_CANALES];
+
+/*
+    Reinicio de acumuladores estadísticos de un canal
+*/
+static void _adc_pipeline_resetStats(adc_pipeline_canal_t *c)
+{
+	c->minimo = 0xFFFF;
+	c->maximo = 0;
+	c->suma = 0;
+	c->suma_cuadrados = 0;
+	c->n = 0;
+}
+
+/*
+    Reinicio del diezmador, del promedio móvil y del anillo de salida de un canal
+*/
+static void _adc_pipeline_resetEtapas(adc_pipeline_canal_t *c)
+{
+	uint8_t i;
+	c->cuenta = 0;
+	c->acumulador = 0;
+	c->pos_boxcar = 0;
+	c->llenado_boxcar = 0;
+	c->suma_boxcar = 0;
+	for(i = 0; i < ADC_PIPELINE_TAM_BOXCAR; i++)
+	{
+		c->historia[i] = 0;
+	}
+	c->cabeza = 0;
+	c->cola = 0;
+}
+
+/*
+    Raíz cuadrada entera de 32 bits por el método bit a bit (sin multiplicaciones)
+*/
+static uint16_t _adc_pipeline_isqrt(uint32_t x)
+{
+	uint32_t resultado = 0;
+	uint32_t bit = 1UL << 30;
+	while(bit > x)
+	{
+		bit >>= 2;
+	}
+	while(bit != 0)
+	{
+		if(x >= resultado + bit)
+		{
+			x -= resultado + bit;
+			resultado = (resultado >> 1) + bit;
+		}
+		else
+		{
+			resultado >>= 1;
+		}
+		bit >>= 2;
+	}
+	return (uint16_t)resultado;
+}
+
+/*
+    Inserción de una salida en el anillo del canal
+*/
+static void _adc_pipeline_push(adc_pipeline_canal_t *c, uint16_t valor)
+{
+	uint8_t siguiente = (c->cabeza + 1) & ADC_PIPELINE_MASCARA_ANILLO;
+	if(siguiente == c->cola)
+	{
+		c->overruns++;	// Anillo lleno: se descarta la salida nueva
+		return;
+	}
+	c->anillo[c->cabeza] = valor;
+	c->cabeza = siguiente;
+}
+
+void adc_pipeline_init(void)
+{
+	uint8_t i;
+	uint8_t ie = PIE1bits.ADIE;
+	PIE1bits.ADIE = 0;
+	for(i = 0; i < ADC_PIPELINE_CANALES; i++)
+	{
+		adc_pipeline_canal_t *c = &_adc_pipeline[i];
+		c->log2_diezmado = 0;
+		c->desplazamiento = 0;
+		c->log2_boxcar = 0;
+		c->overruns = 0;
+		_adc_pipeline_resetEtapas(c);
+		_adc_pipeline_resetStats(c);
+	}
+	PIE1bits.ADIE = ie;
+}
+
+bool adc_pipeline_config(uint8_t canal, uint8_t log2_diezmado, uint8_t bits_extra, uint8_t log2_boxcar)
+{
+	adc_pipeline_canal_t *c;
+	uint8_t ie;
+	if(canal >= ADC_PIPELINE_CANALES || log2_diezmado > ADC_PIPELINE_MAX_LOG2_DIEZMADO ||
+		bits_extra > ADC_PIPELINE_MAX_BITS_EXTRA || log2_boxcar > ADC_PIPELINE_MAX_LOG2_BOXCAR)
+	{
+		return false;
+	}
+	if(log2_diezmado < (bits_extra << 1))
+	{
+		return false;	// Cada bit efectivo adicional requiere 4 veces más muestras
+	}
+	c = &_adc_pipeline[canal];
+	ie = PIE1bits.ADIE;
+	PIE1bits.ADIE = 0;
+	c->log2_diezmado = log2_diezmado;
+	c->desplazamiento = log2_diezmado - bits_extra;
+	c->log2_boxcar = log2_boxcar;
+	_adc_pipeline_resetEtapas(c);
+	PIE1bits.ADIE = ie;
+	return true;
+}
+
+void adc_pipeline_feed(const uint16_t *muestras, uint8_t n_canales)
+{
+	uint8_t i;
+	if(n_canales > ADC_PIPELINE_CANALES)
+	{
+		n_canales = ADC_PIPELINE_CANALES;
+	}
+	for(i = 0; i < n_canales; i++)
+	{
+		adc_pipeline_canal_t *c = &_adc_pipeline[i];
+		uint16_t muestra = muestras[i];
+		uint16_t salida;
+
+		// Estadísticas sobre la muestra cruda
+		if(muestra < c->minimo)
+		{
+			c->minimo = muestra;
+		}
+		if(muestra > c->maximo)
+		{
+			c->maximo = muestra;
+		}
+		if(c->n == ADC_PIPELINE_STATS_MAX_N)
+		{
+			c->suma >>= 1;
+			c->suma_cuadrados >>= 1;
+			c->n >>= 1;
+		}
+		c->suma += muestra;
+		c->suma_cuadrados += (uint32_t)muestra * muestra;
+		c->n++;
+
+		// Diezmado: integrador y volcado cada 2^log2_diezmado muestras
+		c->acumulador += muestra;
+		if(++c->cuenta < (uint8_t)(1 << c->log2_diezmado))
+		{
+			continue;
+		}
+		salida = (uint16_t)(c->acumulador >> c->desplazamiento);
+		c->acumulador = 0;
+		c->cuenta = 0;
+
+		// Promedio móvil sobre las salidas del diezmador
+		if(c->log2_boxcar != 0)
+		{
+			uint8_t ventana = (uint8_t)(1 << c->log2_boxcar);
+			c->suma_boxcar += salida;
+			c->suma_boxcar -= c->historia[c->pos_boxcar];
+			c->historia[c->pos_boxcar] = salida;
+			c->pos_boxcar = (c->pos_boxcar + 1) & (ventana - 1);
+			if(c->llenado_boxcar < ventana)
+			{
+				c->llenado_boxcar++;
+				if(c->llenado_boxcar < ventana)
+				{
+					continue;	// Ventana incompleta
+				}
+			}
+			salida = (uint16_t)(c->suma_boxcar >> c->log2_boxcar);
+		}
+		_adc_pipeline_push(c, salida);
+	}
+}
+
+uint8_t adc_pipeline_available(uint8_t canal)
+{
+	adc_pipeline_canal_t *c;
+	if(canal >= ADC_PIPELINE_CANALES)
+	{
+		return 0;
+	}
+	c = &_adc_pipeline[canal];
+	return (c->cabeza - c->cola) & ADC_PIPELINE_MASCARA_ANILLO;
+}
+
+bool adc_pipeline_read(uint8_t canal, uint16_t *valor)
+{
+	adc_pipeline_canal_t *c;
+	uint8_t cola;
+	if(canal >= ADC_PIPELINE_CANALES)
+	{
+		return false;
+	}
+	c = &_adc_pipeline[canal];
+	cola = c->cola;
+	if(cola == c->cabeza)
+	{
+		return false;
+	}
+	*valor = c->anillo[cola];
+	c->cola = (cola + 1) & ADC_PIPELINE_MASCARA_ANILLO;
+	return true;
+}
+
+uint16_t adc_pipeline_getOverruns(uint8_t canal)
+{
+	uint16_t n;
+	uint8_t ie;
+	if(canal >= ADC_PIPELINE_CANALES)
+	{
+		return 0;
+	}
+	ie = PIE1bits.ADIE;
+	PIE1bits.ADIE = 0;
+	n = _adc_pipeline[canal].overruns;
+	PIE1bits.ADIE = ie;
+	return n;
+}
+
+void adc_pipeline_getStats(uint8_t canal, adc_pipeline_stats_t *stats, bool reiniciar)
+{
+	adc_pipeline_canal_t *c;
+	uint24_t suma;
+	uint32_t suma_cuadrados;
+	uint8_t ie;
+	if(canal >= ADC_PIPELINE_CANALES)
+	{
+		return;
+	}
+	c = &_adc_pipeline[canal];
+	ie = PIE1bits.ADIE;
+	PIE1bits.ADIE = 0;
+	stats->minimo = c->minimo;
+	stats->maximo = c->maximo;
+	stats->n = c->n;
+	suma = c->suma;
+	suma_cuadrados = c->suma_cuadrados;
+	if(reiniciar)
+	{
+		_adc_pipeline_resetStats(c);
+	}
+	PIE1bits.ADIE = ie;
+	// Las divisiones y la raíz se calculan fuera de la sección crítica
+	if(stats->n == 0)
+	{
+		stats->minimo = 0;
+		stats->media = 0;
+		stats->rms = 0;
+		return;
+	}
+	stats->media = (uint16_t)(suma / stats->n);
+	stats->rms = _adc_pipeline_isqrt(suma_cuadrados / stats->n);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file adc_pipeline.h
+ * @brief Cadena de procesamiento de muestras ADC en flujo continuo: sobremuestreo y diezmado, promedio por bloques (boxcar), estadísticas mín/máx/RMS y anillos de salida por canal. Aritmética entera en punto fijo para núcleos de 8 bits.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef ADC_PIPELINE_H
+#define	ADC_PIPELINE_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../pconfig.h"
+#include "adc_scan.h"
+
+/**
+ * @brief Número de canales procesados. Corresponde a las posiciones de la lista de barrido de adc_scan.
+ */
+#ifndef ADC_PIPELINE_CANALES
+#define ADC_PIPELINE_CANALES		ADC_SCAN_MAX_CANALES
+#endif
+
+/**
+ * @brief Número de muestras por anillo de salida de cada canal. Debe ser potencia de 2.
+ */
+#ifndef ADC_PIPELINE_TAM_ANILLO
+#define ADC_PIPELINE_TAM_ANILLO		8
+#endif
+
+/*
+    Límites de configuración de cada etapa
+*/
+#define ADC_PIPELINE_MAX_LOG2_DIEZMADO	6	// Diezmado máximo: 64 muestras por salida
+#define ADC_PIPELINE_MAX_BITS_EXTRA		3	// Bits efectivos adicionales máximos por sobremuestreo
+#define ADC_PIPELINE_MAX_LOG2_BOXCAR	3	// Ventana máxima de promedio móvil: 8 salidas
+
+/**
+ * @brief Estadísticas de muestras crudas de un canal, acumuladas desde el último reinicio
+ */
+typedef struct adc_pipeline_stats_t {
+	uint16_t minimo;		// Valor mínimo observado
+	uint16_t maximo;		// Valor máximo observado
+	uint16_t media;			// Media aritmética
+	uint16_t rms;			// Valor cuadrático medio
+	uint16_t n;				// Número de muestras acumuladas
+} adc_pipeline_stats_t;
+
+/**
+ * @brief Reinicia todas las etapas y anillos. Por defecto cada canal pasa las muestras sin procesar.
+ */
+void adc_pipeline_init(void);
+
+/**
+ * @brief Configura la cadena de procesamiento de un canal.
+ * La etapa de diezmado suma 2^log2_diezmado muestras (integrador y volcado, CIC de primer orden) y entrega
+ * el resultado con 10 + bits_extra bits. Para ganar N bits efectivos se requiere log2_diezmado >= 2N.
+ * La etapa boxcar promedia las últimas 2^log2_boxcar salidas del diezmador.
+ * @param canal Posición del canal en la lista de barrido
+ * @param log2_diezmado Logaritmo base 2 del factor de diezmado (0 a ADC_PIPELINE_MAX_LOG2_DIEZMADO)
+ * @param bits_extra Bits de resolución adicionales en la salida (0 a ADC_PIPELINE_MAX_BITS_EXTRA)
+ * @param log2_boxcar Logaritmo base 2 de la ventana de promedio móvil (0 a ADC_PIPELINE_MAX_LOG2_BOXCAR)
+ * @return (bool) true si la configuración es válida, false en caso contrario
+ */
+bool adc_pipeline_config(uint8_t canal, uint8_t log2_diezmado, uint8_t bits_extra, uint8_t log2_boxcar);
+
+/**
+ * @brief Alimenta la cadena con un barrido completo. Compatible con adc_scan_callback_t, por lo que puede
+ * registrarse directamente con adc_scan_setCallback(adc_pipeline_feed). Se ejecuta en contexto de interrupción.
+ * @param muestras Muestras del barrido, en el orden de la lista de canales
+ * @param n_canales Número de muestras
+ */
+void adc_pipeline_feed(const uint16_t *muestras, uint8_t n_canales);
+
+/**
+ * @brief Número de salidas pendientes de leer en el anillo de un canal
+ * @param canal Posición del canal en la lista de barrido
+ * @return (uint8_t) Número de salidas disponibles
+ */
+uint8_t adc_pipeline_available(uint8_t canal);
+
+/**
+ * @brief Extrae la salida más antigua del anillo de un canal
+ * @param canal Posición del canal en la lista de barrido
+ * @param valor Apuntador a variable destino
+ * @return (bool) true si se extrajo un valor, false si el anillo está vacío
+ */
+bool adc_pipeline_read(uint8_t canal, uint16_t *valor);
+
+/**
+ * @brief Número de salidas descartadas por anillo lleno en un canal
+ * @param canal Posición del canal en la lista de barrido
+ * @return (uint16_t) Número de salidas descartadas
+ */
+uint16_t adc_pipeline_getOverruns(uint8_t canal);
+
+/**
+ * @brief Obtiene las estadísticas de muestras crudas de un canal
+ * @param canal Posición del canal en la lista de barrido
+ * @param stats Apuntador a estructura destino
+ * @param reiniciar true para reiniciar los acumuladores tras la lectura
+ */
+void adc_pipeline_getStats(uint8_t canal, adc_pipeline_stats_t *stats, bool reiniciar);
+
+#endif	/* ADC_PIPELINE_H */
@@ -0,0 +1,267 @@
+/**
+ * @file adc_scan.c
+ * @brief Motor de barrido multicanal del módulo ADC por interrupciones, con disparo por temporizador o evento especial CCP y búfer doble de muestras, para microcontroladores PIC de 8 bits.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "adc_scan.h"
+
+#if defined (ADC_SCAN_DISPONIBLE)
+
+static uint8_t _adc_scan_n = 0;									// Número de canales por barrido
+static uint16_t _adc_scan_buffer[2][ADC_SCAN_MAX_CANALES];		// Búfer doble: uno se llena mientras el otro se lee
+static volatile uint8_t _adc_scan_escritura = 0;				// Índice del búfer en llenado
+static volatile uint8_t _adc_scan_lectura = 1;					// Índice del último búfer completo
+static volatile bool _adc_scan_listo = false;					// Barrido completo sin leer
+static volatile uint16_t _adc_scan_overruns = 0;				// Barridos sobrescritos sin leer
+static adc_scan_callback_t _adc_scan_callback = NULL;			// Notificación de barrido completo
+
+#if defined (ADC_SCAN_HW)
+static bool _adc_scan_alternado = false;						// Búfer de hardware dividido en dos mitades
+#else
+/*
+    Inicio de conversión. En ADC_V9 el bit GO comparte dirección con WDTCON<DEVCFG>
+*/
+#if defined (ADC_V9) || defined (ADC_V9_1)
+#define _adc_scan_go()		do{ WDTCONbits.DEVCFG = 0; ADCON0bits.GO = 1; }while(0)
+#else
+#define _adc_scan_go()		ADCON0bits.GO = 1
+#endif
+
+static uint8_t _adc_scan_canales[ADC_SCAN_MAX_CANALES];			// Lista de canales a convertir
+static uint8_t _adc_scan_disparo = ADC_SCAN_TRIG_SOFTWARE;		// Fuente de disparo
+static volatile uint8_t _adc_scan_indice = 0;					// Posición en la lista de canales del barrido en curso
+static volatile bool _adc_scan_en_curso = false;				// Barrido por software en curso
+static volatile uint16_t _adc_scan_omitidos = 0;				// Disparos descartados
+#endif
+
+/*
+    Reinicio del búfer doble y de los contadores
+*/
+static void _adc_scan_reset(void)
+{
+	_adc_scan_escritura = 0;
+	_adc_scan_lectura = 1;
+	_adc_scan_listo = false;
+	_adc_scan_overruns = 0;
+}
+
+/*
+    Cierre de un barrido: intercambio de búferes y notificación. Se ejecuta en contexto de interrupción.
+*/
+static void _adc_scan_completo(uint8_t escritura)
+{
+	_adc_scan_lectura = escritura;
+	_adc_scan_escritura = escritura ^ 1;
+	if(_adc_scan_listo)
+	{
+		_adc_scan_overruns++;
+	}
+	_adc_scan_listo = true;
+	if(_adc_scan_callback != NULL)
+	{
+		_adc_scan_callback(_adc_scan_buffer[escritura], _adc_scan_n);
+	}
+}
+
+#if defined (ADC_SCAN_HW)
+
+bool adc_scan_init(uint32_t mascara, bool alternado)
+{
+	uint8_t n = 0;
+	uint32_t m = mascara;
+	while(m != 0)
+	{
+		n += (uint8_t)(m & 1);
+		m >>= 1;
+	}
+	if(n == 0 || n > ADC_SCAN_MAX_CANALES || n > ADC_SCAN_TAM_BUFFER_HW)
+	{
+		return false;
+	}
+	if(alternado && n > (ADC_SCAN_TAM_BUFFER_HW >> 1))
+	{
+		return false;
+	}
+	PIE1bits.ADIE = 0;
+	ADCSS0L = make8(mascara, 0);
+	ADCSS0H = make8(mascara, 1);
+	ADCSS1L = make8(mascara, 2);
+	ADCSS1H = make8(mascara, 3);
+	// Barrido de entradas con búfer en modo FIFO: los resultados quedan contiguos desde ADCBUF0 (o desde la mitad activa)
+	ADCON2H = (ADCON2H & ~ADC_SCAN_MASCARA_SCAN) | ADC_SCAN_ON | ADC_BUF_REG_DISABLE;
+	// Una interrupción cada n conversiones (SMPI = n - 1) y selección de búfer alternado
+	ADCON2L = (ADCON2L & ~(ADC_SCAN_MASCARA_SMPI | ADC_ALT_BUF_ON)) | ((uint8_t)(n - 1) << 2) | (alternado ? ADC_ALT_BUF_ON : ADC_ALT_BUF_OFF);
+	_adc_scan_n = n;
+	_adc_scan_alternado = alternado;
+	_adc_scan_reset();
+	return true;
+}
+
+void adc_scan_start(void)
+{
+	PIR1bits.ADIF = 0;
+	PIE1bits.ADIE = 1;
+	INTCONbits.PEIE = 1;
+	ADCON1L |= ADC_AUTO_SAMPLING_ON;
+}
+
+void adc_scan_stop(void)
+{
+	ADCON1L &= ~ADC_AUTO_SAMPLING_ON;
+	PIE1bits.ADIE = 0;
+	PIR1bits.ADIF = 0;
+}
+
+void adc_scan_interruptHandler(void)
+{
+	const volatile uint16_t *origen = &ADCBUF0;
+	uint16_t *destino;
+	uint8_t escritura;
+	uint8_t i;
+	if(!(PIR1bits.ADIF && PIE1bits.ADIE))
+	{
+		return;
+	}
+	PIR1bits.ADIF = 0;
+	// Con búfer alternado, BUFS = 1 indica que el hardware llena la mitad superior y la inferior está disponible
+	if(_adc_scan_alternado && !ADCON2Lbits.BUFS)
+	{
+		origen += (ADC_SCAN_TAM_BUFFER_HW >> 1);
+	}
+	escritura = _adc_scan_escritura;
+	destino = _adc_scan_buffer[escritura];
+	for(i = 0; i < _adc_scan_n; i++)
+	{
+		destino[i] = origen[i];
+	}
+	_adc_scan_completo(escritura);
+}
+
+#else
+
+bool adc_scan_init(const uint8_t *canales, uint8_t n_canales, uint8_t disparo)
+{
+	uint8_t i;
+	if(canales == NULL || n_canales == 0 || n_canales > ADC_SCAN_MAX_CANALES)
+	{
+		return false;
+	}
+	if(disparo != ADC_SCAN_TRIG_SOFTWARE && disparo != ADC_SCAN_TRIG_CCP)
+	{
+		return false;
+	}
+	PIE1bits.ADIE = 0;
+	for(i = 0; i < n_canales; i++)
+	{
+		_adc_scan_canales[i] = canales[i];
+	}
+	_adc_scan_n = n_canales;
+	_adc_scan_disparo = disparo;
+	_adc_scan_indice = 0;
+	_adc_scan_en_curso = false;
+	_adc_scan_omitidos = 0;
+	_adc_scan_reset();
+	adc_setChannel(_adc_scan_canales[0]);	// El primer canal queda en adquisición a la espera del disparo
+	return true;
+}
+
+void adc_scan_start(void)
+{
+	PIR1bits.ADIF = 0;
+	PIE1bits.ADIE = 1;
+	INTCONbits.PEIE = 1;
+}
+
+void adc_scan_stop(void)
+{
+	PIE1bits.ADIE = 0;
+	while(ADCON0bits.GO){}	// Espera a que termine la conversión en curso
+	PIR1bits.ADIF = 0;
+	_adc_scan_indice = 0;
+	_adc_scan_en_curso = false;
+	adc_setChannel(_adc_scan_canales[0]);
+}
+
+void adc_scan_trigger(void)
+{
+	if(_adc_scan_disparo != ADC_SCAN_TRIG_SOFTWARE)
+	{
+		return;
+	}
+	if(_adc_scan_en_curso)
+	{
+		_adc_scan_omitidos++;
+		return;
+	}
+	_adc_scan_en_curso = true;
+	_adc_scan_go();
+}
+
+uint16_t adc_scan_getMissedTriggers(void)
+{
+	uint16_t n;
+	uint8_t ie = PIE1bits.ADIE;
+	PIE1bits.ADIE = 0;
+	n = _adc_scan_omitidos;
+	PIE1bits.ADIE = ie;
+	return n;
+}
+
+void adc_scan_interruptHandler(void)
+{
+	uint8_t escritura;
+	if(!(PIR1bits.ADIF && PIE1bits.ADIE))
+	{
+		return;
+	}
+	PIR1bits.ADIF = 0;
+	escritura = _adc_scan_escritura;
+	_adc_scan_buffer[escritura][_adc_scan_indice] = make16(ADRESH, ADRESL);
+	if(++_adc_scan_indice < _adc_scan_n)
+	{
+		// Siguiente canal de la lista. En versiones con ACQT el hardware inserta el tiempo de adquisición al poner GO
+		adc_setChannel(_adc_scan_canales[_adc_scan_indice]);
+		#if defined (ADC_SCAN_ADQUISICION_SW)
+		__delay_us(ADC_SCAN_TACQ_US);
+		#endif
+		_adc_scan_go();
+		return;
+	}
+	// Barrido completo: el primer canal adquiere hasta el siguiente disparo
+	adc_setChannel(_adc_scan_canales[0]);
+	_adc_scan_indice = 0;
+	_adc_scan_en_curso = false;
+	_adc_scan_completo(escritura);
+}
+
+#endif
+
+void adc_scan_setCallback(adc_scan_callback_t callback)
+{
+	_adc_scan_callback = callback;
+}
+
+bool adc_scan_ready(void)
+{
+	return _adc_scan_listo;
+}
+
+const uint16_t *adc_scan_getBuffer(void)
+{
+	_adc_scan_listo = false;
+	return _adc_scan_buffer[_adc_scan_lectura];
+}
+
+uint16_t adc_scan_getOverruns(void)
+{
+	uint16_t n;
+	uint8_t ie = PIE1bits.ADIE;
+	PIE1bits.ADIE = 0;
+	n = _adc_scan_overruns;
+	PIE1bits.ADIE = ie;
+	return n;
+}
+
+#endif
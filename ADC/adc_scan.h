@@ -0,0 +1,168 @@
+/**
+ * @file adc_scan.h
+ * @brief Motor de barrido multicanal del módulo ADC por interrupciones, con disparo por temporizador o evento especial CCP y búfer doble de muestras, para microcontroladores PIC de 8 bits.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef ADC_SCAN_H
+#define	ADC_SCAN_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../pconfig.h"
+#include "adc.h"
+
+/**
+ * @brief Versiones del módulo ADC con bit GO y selección de canal por ADCON0 soportadas por el motor de barrido.
+ * ADC_V7 y ADC_V7_1 tienen secuenciador propio y ADC_V15 cuenta con barrido automático por hardware.
+ */
+#if defined (ADC_V1) || defined (ADC_V2) || defined (ADC_V3) ||\
+    defined (ADC_V4) || defined (ADC_V5) || defined (ADC_V6) || defined (ADC_V8) ||\
+    defined (ADC_V9) || defined (ADC_V9_1) || defined (ADC_V10) || defined (ADC_V11) ||\
+	defined (ADC_V11_1) || defined (ADC_V12) || defined (ADC_V13) || defined (ADC_V13_1) ||\
+	defined (ADC_V13_2) || defined (ADC_V13_3) || defined (ADC_V14) || defined (ADC_V14_1) ||\
+	defined (ADC_V14_2) || defined (ADC_V14_3)
+#define ADC_SCAN_DISPONIBLE
+#endif
+
+/**
+ * @brief En ADC_V15 y ADC_V15_1 el barrido lo realiza el hardware (CSCNA) sobre una máscara de canales y los
+ * resultados se depositan en ADCBUF0..15; se genera una sola interrupción por barrido y el búfer se copia en ráfaga.
+ */
+#if defined (ADC_V15) || defined (ADC_V15_1)
+#define ADC_SCAN_DISPONIBLE
+#define ADC_SCAN_HW
+#ifndef ADC_SCAN_TAM_BUFFER_HW
+#define ADC_SCAN_TAM_BUFFER_HW	16		// Palabras del búfer de resultados ADCBUFx
+#endif
+#ifndef ADC_SCAN_MAX_CANALES
+#define ADC_SCAN_MAX_CANALES	ADC_SCAN_TAM_BUFFER_HW
+#endif
+#define ADC_SCAN_MASCARA_SMPI	0b01111100	// Bits SMPI<4:0> de ADCON2L
+#define ADC_SCAN_MASCARA_SCAN	(ADC_SCAN_ON | ADC_BUF_REG_ENABLE)	// Bits CSCNA y BUFREGEN de ADCON2H
+#endif
+
+/**
+ * @brief Versiones sin tiempo de adquisición programable (bits ACQT). En ellas el tiempo de adquisición
+ * tras el cambio de canal se espera por software dentro de la interrupción.
+ */
+#if defined (ADC_V1) || defined (ADC_V2)
+#define ADC_SCAN_ADQUISICION_SW
+#ifndef ADC_SCAN_TACQ_US
+#if defined (ADC_AUTO_TACQ_US)
+#define ADC_SCAN_TACQ_US	ADC_AUTO_TACQ_US	// Calculado a partir de ADC_IMPEDANCIA_FUENTE_OHMS
+#else
+#define ADC_SCAN_TACQ_US	5		// Tiempo de adquisición en microsegundos tras cambio de canal
+#endif
+#endif
+#endif
+
+/**
+ * @brief Número máximo de canales en la lista de barrido. Puede redefinirse en pconfig.h
+ */
+#ifndef ADC_SCAN_MAX_CANALES
+#define ADC_SCAN_MAX_CANALES	8
+#endif
+
+/*
+    Fuentes de disparo del barrido
+*/
+#define ADC_SCAN_TRIG_SOFTWARE	0	// Cada barrido inicia con adc_scan_trigger(), típicamente desde la interrupción de un temporizador
+#define ADC_SCAN_TRIG_CCP		1	// Cada barrido inicia con el evento especial de un módulo CCP en modo CCP_COMPARE_RESET_TIMER
+
+/**
+ * @brief Función de notificación de barrido completo. Se ejecuta en contexto de interrupción.
+ * @param muestras Apuntador al búfer recién completado
+ * @param n_canales Número de muestras en el búfer
+ */
+typedef void (*adc_scan_callback_t)(const uint16_t *muestras, uint8_t n_canales);
+
+#if defined (ADC_SCAN_HW)
+
+/**
+ * @brief Configura el barrido automático por hardware. El módulo ADC debe haberse configurado previamente con adc_init,
+ * incluyendo la fuente de disparo (ADC_TRIG_*) y el muestreo automático. Los resultados se entregan en orden ascendente
+ * de número de canal analógico.
+ * @param mascara Máscara de canales a barrer: bit n corresponde a ANn (registros ADCSS0L..ADCSS1H)
+ * @param alternado true para dividir ADCBUFx en dos mitades: el hardware llena una mientras la interrupción copia la otra
+ * @return (bool) true si la configuración es válida (1 a 16 canales, o 1 a 8 en modo alternado), false en caso contrario
+ */
+bool adc_scan_init(uint32_t mascara, bool alternado);
+
+#elif defined (ADC_SCAN_DISPONIBLE)
+
+/**
+ * @brief Inicializa el motor de barrido. El módulo ADC debe haberse configurado previamente con adc_init.
+ * En modo ADC_SCAN_TRIG_CCP el módulo CCP se configura aparte con compareN_init(CCP_COMPARE_RESET_TIMER) y el periodo de muestreo en CCPRx.
+ * @param canales Lista de canales a convertir (macros ADC_CHx de la versión en uso)
+ * @param n_canales Número de canales en la lista (1 a ADC_SCAN_MAX_CANALES)
+ * @param disparo Fuente de disparo: ADC_SCAN_TRIG_SOFTWARE o ADC_SCAN_TRIG_CCP
+ * @return (bool) true si la configuración es válida, false en caso contrario
+ */
+bool adc_scan_init(const uint8_t *canales, uint8_t n_canales, uint8_t disparo);
+
+#endif
+
+#if defined (ADC_SCAN_DISPONIBLE)
+
+/**
+ * @brief Registra la función de notificación de barrido completo (NULL para deshabilitar)
+ * @param callback Función de notificación
+ */
+void adc_scan_setCallback(adc_scan_callback_t callback);
+
+/**
+ * @brief Habilita la interrupción del ADC y comienza a aceptar disparos. En ADC_V15 habilita además el muestreo automático.
+ */
+void adc_scan_start(void);
+
+/**
+ * @brief Deshabilita la interrupción del ADC. El barrido en curso se descarta.
+ */
+void adc_scan_stop(void);
+
+/**
+ * @brief Indica si hay un barrido completo sin leer
+ * @return (bool) true si hay un barrido nuevo disponible
+ */
+bool adc_scan_ready(void);
+
+/**
+ * @brief Obtiene el último barrido completo y limpia la bandera de disponibilidad.
+ * El búfer permanece válido hasta que se completa el siguiente barrido.
+ * @return (const uint16_t*) Apuntador a las muestras, en el orden de la lista de canales (ADC_V15: en orden ascendente de canal)
+ */
+const uint16_t *adc_scan_getBuffer(void);
+
+/**
+ * @brief Número de barridos completados sin haber leído el anterior
+ * @return (uint16_t) Número de barridos sobrescritos
+ */
+uint16_t adc_scan_getOverruns(void);
+
+#if !defined (ADC_SCAN_HW)
+
+/**
+ * @brief Disparo por software de un barrido. Si un barrido sigue en curso, el disparo se descarta y se contabiliza.
+ */
+void adc_scan_trigger(void);
+
+/**
+ * @brief Número de disparos descartados por llegar con un barrido en curso
+ * @return (uint16_t) Número de disparos descartados
+ */
+uint16_t adc_scan_getMissedTriggers(void);
+
+#endif
+
+/**
+ * @brief Función de manejo de interrupción del ADC. Debe llamarse desde la rutina de interrupción.
+ */
+void adc_scan_interruptHandler(void);
+
+#endif
+
+#endif	/* ADC_SCAN_H */
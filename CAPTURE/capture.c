@@ -0,0 +1,474 @@
+/**
+ * @file capture.c
+ * @brief Funciones para manejo de módulos CCP/ECCP en modo input capture en microcontroladores PIC de 8 bits: selección de
+ * flanco (cada flanco de bajada, de subida, cada 4o o cada 16o flanco de subida), marcas de tiempo de 32 bits extendidas con
+ * los desbordes del Timer1/3/5 asociado, buffer circular llenado desde la interrupción y cálculo de periodo, frecuencia
+ * y ciclo de trabajo.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "../../utils/utils.h"
+#include "capture.h"
+
+#define CAPTURE_MASCARA     (CAPTURE_BUFFER - 1)
+
+/*
+    Módulos disponibles en cada versión (los mismos que en compare.c)
+*/
+#if defined (CC_V1) || defined (CC_V2) || defined (CC_V3) || defined (CC_V4) || defined (CC_V5) || defined (CC_V6) || defined (CC_V7)
+#define _CAPTURE_CCP1
+#endif
+#if defined (CC_V2) || defined (CC_V3) || defined (CC_V4) || defined (CC_V6) || defined (CC_V7) || defined (CC_V8_2) || defined (CC_V8_5)
+#define _CAPTURE_CCP2
+#endif
+#if defined (CC_V3) || defined (CC_V4) || defined (CC_V8_2)
+#define _CAPTURE_CCP3
+#endif
+#if defined (CC_V4) || defined (CC_V8) || defined (CC_V8_1) || defined (CC_V8_2) || defined (CC_V8_3) || defined (CC_V8_4) ||\
+    defined (CC_V9) || defined (CC_V9_1)
+#define _CAPTURE_CCP4_5
+#endif
+#if defined (CC_V8) || defined (CC_V8_1) || defined (CC_V8_3) || defined (CC_V8_4)
+#define _CAPTURE_CCP6_8
+#endif
+#if defined (CC_V8) || defined (CC_V8_3)
+#define _CAPTURE_CCP9_10
+#endif
+#if defined (ECC_V5) || defined (ECC_V8) || defined (ECC_V8_1) || defined (ECC_V8_2) || defined (ECC_V8_3) ||\
+    defined (ECC_V8_4) || defined (ECC_V8_5) || defined (ECC_V9) || defined (ECC_V9_1)
+#define _CAPTURE_ECCP1
+#endif
+#if defined (ECC_V8) || defined (ECC_V8_1) || defined (ECC_V8_3) || defined (ECC_V8_4) || defined (ECC_V9) || defined (ECC_V9_1)
+#define _CAPTURE_ECCP2_3
+#endif
+
+/*
+    Operaciones sobre las banderas de interrupción de un módulo o temporizador
+*/
+#define _CAPTURE_ACTIVA         0   // Bandera e interrupción habilitada
+#define _CAPTURE_PENDIENTE      1   // Solo la bandera
+#define _CAPTURE_LIMPIAR        2
+#define _CAPTURE_HABILITAR      3
+#define _CAPTURE_DESHABILITAR   4
+
+#define _CAPTURE_BITS(IF, IE) \
+    switch(op) \
+    { \
+        case _CAPTURE_ACTIVA: return IF && IE; \
+        case _CAPTURE_PENDIENTE: return IF; \
+        case _CAPTURE_LIMPIAR: IF = 0; break; \
+        case _CAPTURE_HABILITAR: IE = 1; break; \
+        default: IE = 0; break; \
+    } \
+    return true;
+
+static capture_t *_capture_lista = NULL;                // Canales registrados
+static volatile uint16_t _capture_desbordes[3] = {0};   // Parte alta de Timer1, Timer3 y Timer5
+static uint8_t _capture_timers = 0;                     // Temporizadores en uso (bit 0: Timer1, 1: Timer3, 2: Timer5)
+
+static bool _capture_bits(uint8_t modulo, uint8_t op)
+{
+    switch(modulo)
+    {
+        #if defined (_CAPTURE_CCP1)
+        case CAPTURE_CCP1: _CAPTURE_BITS(CCP1IF, CCP1IE)
+        #endif
+        #if defined (_CAPTURE_CCP2)
+        case CAPTURE_CCP2: _CAPTURE_BITS(CCP2IF, CCP2IE)
+        #endif
+        #if defined (_CAPTURE_CCP3)
+        case CAPTURE_CCP3: _CAPTURE_BITS(CCP3IF, CCP3IE)
+        #endif
+        #if defined (_CAPTURE_CCP4_5)
+        case CAPTURE_CCP4: _CAPTURE_BITS(CCP4IF, CCP4IE)
+        case CAPTURE_CCP5: _CAPTURE_BITS(CCP5IF, CCP5IE)
+        #endif
+        #if defined (_CAPTURE_CCP6_8)
+        case CAPTURE_CCP6: _CAPTURE_BITS(CCP6IF, CCP6IE)
+        case CAPTURE_CCP7: _CAPTURE_BITS(CCP7IF, CCP7IE)
+        case CAPTURE_CCP8: _CAPTURE_BITS(CCP8IF, CCP8IE)
+        #endif
+        #if defined (_CAPTURE_CCP9_10)
+        case CAPTURE_CCP9: _CAPTURE_BITS(CCP9IF, CCP9IE)
+        case CAPTURE_CCP10: _CAPTURE_BITS(CCP10IF, CCP10IE)
+        #endif
+        #if defined (ECC_V5)
+        case CAPTURE_ECCP1: _CAPTURE_BITS(ECCP1IF, ECCP1IE)
+        #elif defined (_CAPTURE_ECCP1)
+        case CAPTURE_ECCP1: _CAPTURE_BITS(CCP1IF, CCP1IE)
+        #endif
+        #if defined (_CAPTURE_ECCP2_3)
+        case CAPTURE_ECCP2: _CAPTURE_BITS(CCP2IF, CCP2IE)
+        case CAPTURE_ECCP3: _CAPTURE_BITS(CCP3IF, CCP3IE)
+        #endif
+        default: return false;
+    }
+}
+
+static bool _capture_timerBits(uint8_t t, uint8_t op)
+{
+    switch(t)
+    {
+        case 0: _CAPTURE_BITS(TMR1IF, TMR1IE)
+        #if defined (CAPTURE_TIMER3)
+        case 1: _CAPTURE_BITS(TMR3IF, TMR3IE)
+        #endif
+        #if defined (CAPTURE_TIMER5)
+        case 2: _CAPTURE_BITS(TMR5IF, TMR5IE)
+        #endif
+        default: return false;
+    }
+}
+
+static uint16_t _capture_timerLeer(uint8_t t)
+{
+    switch(t)
+    {
+        #if defined (CAPTURE_TIMER3)
+        case 1: return get_timer3();
+        #endif
+        #if defined (CAPTURE_TIMER5)
+        case 2: return get_timer5();
+        #endif
+        default: return get_timer1();
+    }
+}
+
+/*
+    Configuración del módulo con la función de compare.c correspondiente, en modo de interrupción por software (no modifica
+    el pin) para que establezca la selección de temporizador; el modo de captura se escribe después.
+*/
+static bool _capture_modulo(capture_t *c, uint8_t modulo, uint8_t seleccion)
+{
+    uint8_t param = CCP_COMPARE_INT | seleccion;
+    switch(modulo)
+    {
+        #if defined (_CAPTURE_CCP1)
+        case CAPTURE_CCP1: compare1_init(param); c->con = &CCP1CON; c->ccprl = &CCPR1L; c->ccprh = &CCPR1H; break;
+        #endif
+        #if defined (_CAPTURE_CCP2)
+        case CAPTURE_CCP2: compare2_init(param); c->con = &CCP2CON; c->ccprl = &CCPR2L; c->ccprh = &CCPR2H; break;
+        #endif
+        #if defined (_CAPTURE_CCP3)
+        case CAPTURE_CCP3: compare3_init(param); c->con = &CCP3CON; c->ccprl = &CCPR3L; c->ccprh = &CCPR3H; break;
+        #endif
+        #if defined (_CAPTURE_CCP4_5)
+        case CAPTURE_CCP4: compare4_init(param); c->con = &CCP4CON; c->ccprl = &CCPR4L; c->ccprh = &CCPR4H; break;
+        case CAPTURE_CCP5: compare5_init(param); c->con = &CCP5CON; c->ccprl = &CCPR5L; c->ccprh = &CCPR5H; break;
+        #endif
+        #if defined (_CAPTURE_CCP6_8)
+        case CAPTURE_CCP6: compare6_init(param); c->con = &CCP6CON; c->ccprl = &CCPR6L; c->ccprh = &CCPR6H; break;
+        case CAPTURE_CCP7: compare7_init(param); c->con = &CCP7CON; c->ccprl = &CCPR7L; c->ccprh = &CCPR7H; break;
+        case CAPTURE_CCP8: compare8_init(param); c->con = &CCP8CON; c->ccprl = &CCPR8L; c->ccprh = &CCPR8H; break;
+        #endif
+        #if defined (_CAPTURE_CCP9_10)
+        case CAPTURE_CCP9: compare9_init(param); c->con = &CCP9CON; c->ccprl = &CCPR9L; c->ccprh = &CCPR9H; break;
+        case CAPTURE_CCP10: compare10_init(param); c->con = &CCP10CON; c->ccprl = &CCPR10L; c->ccprh = &CCPR10H; break;
+        #endif
+        #if defined (ECC_V5)
+        case CAPTURE_ECCP1: ecompare1_init(param); c->con = &ECCP1CON; c->ccprl = &ECCPR1L; c->ccprh = &ECCPR1H; break;
+        #elif defined (ECC_V8_3) || defined (ECC_V8_4) || defined (ECC_V8_5)
+        case CAPTURE_ECCP1: ecompare1_init(param); c->con = &CCP1CON; c->ccprl = &CCPR1L; c->ccprh = &CCPR1H; break;
+        #elif defined (_CAPTURE_ECCP1)
+        case CAPTURE_ECCP1: ecompare1_init(param); c->con = &ECCP1CON; c->ccprl = &CCPR1L; c->ccprh = &CCPR1H; break;
+        #endif
+        #if defined (ECC_V8_3) || defined (ECC_V8_4)
+        case CAPTURE_ECCP2: ecompare2_init(param); c->con = &CCP2CON; c->ccprl = &CCPR2L; c->ccprh = &CCPR2H; break;
+        #elif defined (_CAPTURE_ECCP2_3)
+        case CAPTURE_ECCP2: ecompare2_init(param); c->con = &ECCP2CON; c->ccprl = &CCPR2L; c->ccprh = &CCPR2H; break;
+        #endif
+        #if defined (_CAPTURE_ECCP2_3)
+        case CAPTURE_ECCP3: ecompare3_init(param); c->con = &CCP3CON; c->ccprl = &CCPR3L; c->ccprh = &CCPR3H; break;
+        #endif
+        default: return false;
+    }
+    return true;
+}
+
+/*
+    Marca de tiempo de 32 bits de la captura: si el desborde del temporizador aún no se atiende y el valor capturado está
+    en la mitad baja, la captura ocurrió después del desborde.
+*/
+static uint32_t _capture_marca(const capture_t *c)
+{
+    uint8_t l = *c->ccprl;
+    uint16_t valor = make16(*c->ccprh, l);
+    uint16_t alto = _capture_desbordes[c->temporizador];
+    if(_capture_timerBits(c->temporizador, _CAPTURE_PENDIENTE) && valor < 0x8000)
+    {
+        alto++;
+    }
+    return ((uint32_t)alto << 16) | valor;
+}
+
+/*
+    Registro de una captura: buffer circular, periodo y ancho de pulso
+*/
+static void _capture_registrar(capture_t *c)
+{
+    uint32_t marca = _capture_marca(c);
+    bool subida = true;
+    if(c->modo == CCP_CAPTURE_BOTH)
+    {
+        subida = c->subida;
+        c->subida = !subida;
+        *c->con = subida ? CCP_CAPTURE_FALLING : CCP_CAPTURE_RISING;
+        _capture_bits(c->modulo, _CAPTURE_LIMPIAR);     // El cambio de modo puede generar una captura falsa
+    }
+    if((uint8_t)(c->escritura - c->lectura) < CAPTURE_BUFFER)
+    {
+        c->marcas[c->escritura & CAPTURE_MASCARA] = marca;
+        c->escritura++;
+    }
+    else if(c->perdidas != 255)
+    {
+        c->perdidas++;
+    }
+    if(subida)
+    {
+        if(c->referencia)
+        {
+            c->periodo = marca - c->ultima;
+            c->alto_ciclo = c->alto;
+        }
+        c->ultima = marca;
+        c->referencia = true;
+    }
+    else if(c->referencia)
+    {
+        c->alto = marca - c->ultima;
+    }
+    c->flancos++;
+}
+
+bool capture_init(capture_t *c, uint8_t modulo, uint8_t modo, uint8_t temporizador, uint8_t seleccion)
+{
+    capture_t *p;
+    uint8_t t;
+    uint8_t gie;
+    switch(temporizador)
+    {
+        case 1: t = 0; break;
+        #if defined (CAPTURE_TIMER3)
+        case 3: t = 1; break;
+        #endif
+        #if defined (CAPTURE_TIMER5)
+        case 5: t = 2; break;
+        #endif
+        default: return false;
+    }
+    if(!_capture_bits(modulo, _CAPTURE_DESHABILITAR) || !_capture_modulo(c, modulo, seleccion))
+    {
+        return false;
+    }
+    c->modulo = modulo;
+    c->modo = modo;
+    c->temporizador = t;
+    c->escritura = 0;
+    c->lectura = 0;
+    c->perdidas = 0;
+    c->flancos = 0;
+    c->periodo = 0;
+    c->alto = 0;
+    c->alto_ciclo = 0;
+    c->referencia = false;
+    c->subida = true;
+    // El cambio de modo de captura (o de su preescala) se hace desde el módulo apagado
+    *c->con = 0;
+    *c->con = (modo == CCP_CAPTURE_BOTH) ? CCP_CAPTURE_RISING : (modo & 0x0F);
+    // La lista se recorre desde la interrupción: los apuntadores de 16 bits se modifican con interrupciones deshabilitadas
+    gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    for(p = _capture_lista; p != NULL && p != c; p = p->siguiente);
+    if(p == NULL)
+    {
+        c->siguiente = _capture_lista;
+        _capture_lista = c;
+    }
+    if(!(_capture_timers & (1 << t)))
+    {
+        _capture_timers |= (uint8_t)(1 << t);
+        _capture_desbordes[t] = 0;
+        _capture_timerBits(t, _CAPTURE_HABILITAR);
+    }
+    _capture_bits(modulo, _CAPTURE_LIMPIAR);
+    _capture_bits(modulo, _CAPTURE_HABILITAR);
+    INTCONbits.GIE = gie;
+    return true;
+}
+
+void capture_stop(capture_t *c)
+{
+    capture_t **p;
+    uint8_t gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    _capture_bits(c->modulo, _CAPTURE_DESHABILITAR);
+    *c->con = 0;
+    for(p = &_capture_lista; *p != NULL; p = &(*p)->siguiente)
+    {
+        if(*p == c)
+        {
+            *p = c->siguiente;
+            break;
+        }
+    }
+    INTCONbits.GIE = gie;
+}
+
+uint8_t capture_available(const capture_t *c)
+{
+    return (uint8_t)(c->escritura - c->lectura);
+}
+
+bool capture_read(capture_t *c, uint32_t *marca)
+{
+    uint8_t lectura = c->lectura;
+    if(lectura == c->escritura)
+    {
+        return false;
+    }
+    *marca = c->marcas[lectura & CAPTURE_MASCARA];
+    c->lectura = lectura + 1;
+    return true;
+}
+
+bool capture_getPeriod(const capture_t *c, uint32_t *periodo)
+{
+    uint8_t n;
+    uint32_t p;
+    // Lectura consistente sin deshabilitar interrupciones: se repite si ocurrió una captura durante la lectura
+    do
+    {
+        n = c->flancos;
+        p = c->periodo;
+    } while(n != c->flancos);
+    if(p == 0)
+    {
+        return false;
+    }
+    if(c->modo == CCP_CAPTURE_RISING_4)
+    {
+        p >>= 2;
+    }
+    else if(c->modo == CCP_CAPTURE_RISING_16)
+    {
+        p >>= 4;
+    }
+    *periodo = p;
+    return true;
+}
+
+uint32_t capture_getFrequency(const capture_t *c, uint32_t frecuencia_timer)
+{
+    uint8_t n;
+    uint32_t p;
+    uint32_t flancos = 1;
+    do
+    {
+        n = c->flancos;
+        p = c->periodo;
+    } while(n != c->flancos);
+    if(p == 0)
+    {
+        return 0;
+    }
+    // Con preescala de captura se conserva la resolución del periodo completo de 4 o 16 flancos
+    if(c->modo == CCP_CAPTURE_RISING_4)
+    {
+        flancos = 4;
+    }
+    else if(c->modo == CCP_CAPTURE_RISING_16)
+    {
+        flancos = 16;
+    }
+    return (uint32_t)(((uint64_t)frecuencia_timer * flancos + p / 2) / p);
+}
+
+bool capture_getPulseWidth(const capture_t *c, uint32_t *alto)
+{
+    uint8_t n;
+    uint32_t a;
+    do
+    {
+        n = c->flancos;
+        a = c->alto;
+    } while(n != c->flancos);
+    if(a == 0)
+    {
+        return false;
+    }
+    *alto = a;
+    return true;
+}
+
+uint16_t capture_getDuty(const capture_t *c)
+{
+    uint8_t n;
+    uint32_t p;
+    uint32_t a;
+    do
+    {
+        n = c->flancos;
+        p = c->periodo;
+        a = c->alto_ciclo;
+    } while(n != c->flancos);
+    if(p == 0 || a > p)
+    {
+        return 0;
+    }
+    return (uint16_t)(((uint64_t)a * 1000 + p / 2) / p);
+}
+
+uint32_t capture_now(const capture_t *c)
+{
+    uint16_t alto;
+    uint16_t valor;
+    bool pendiente;
+    do
+    {
+        alto = _capture_desbordes[c->temporizador];
+        valor = _capture_timerLeer(c->temporizador);
+        pendiente = _capture_timerBits(c->temporizador, _CAPTURE_PENDIENTE);
+    } while(alto != _capture_desbordes[c->temporizador]);
+    if(pendiente && valor < 0x8000)
+    {
+        alto++;
+    }
+    return ((uint32_t)alto << 16) | valor;
+}
+
+uint32_t capture_sinceLast(const capture_t *c)
+{
+    uint8_t n;
+    uint32_t ultima;
+    do
+    {
+        n = c->flancos;
+        ultima = c->ultima;
+    } while(n != c->flancos);
+    return capture_now(c) - ultima;
+}
+
+void capture_interruptHandler(void)
+{
+    capture_t *c;
+    uint8_t t;
+    // Capturas antes que desbordes, para que _capture_marca detecte el desborde pendiente
+    for(c = _capture_lista; c != NULL; c = c->siguiente)
+    {
+        if(_capture_bits(c->modulo, _CAPTURE_ACTIVA))
+        {
+            _capture_bits(c->modulo, _CAPTURE_LIMPIAR);
+            _capture_registrar(c);
+        }
+    }
+    for(t = 0; t < 3; t++)
+    {
+        if((_capture_timers & (1 << t)) && _capture_timerBits(t, _CAPTURE_ACTIVA))
+        {
+            _capture_timerBits(t, _CAPTURE_LIMPIAR);
+            _capture_desbordes[t]++;
+        }
+    }
+}
@@ -0,0 +1,186 @@
+/**
+ * @file capture.h
+ * @brief Funciones para manejo de módulos CCP/ECCP en modo input capture en microcontroladores PIC de 8 bits: selección de
+ * flanco (cada flanco de bajada, de subida, cada 4o o cada 16o flanco de subida), marcas de tiempo de 32 bits extendidas con
+ * los desbordes del Timer1/3/5 asociado, buffer circular llenado desde la interrupción y cálculo de periodo, frecuencia
+ * y ciclo de trabajo.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef CAPTURE_H
+#define	CAPTURE_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../pconfig.h"
+#include "../TIMERS/timers.h"
+#include "../COMPARE/compare.h"
+
+/*
+    Macros que definen modos de funcionamiento del módulo CCP en modo Input Capture (CCPxM<3:0>)
+*/
+#define CCP_CAPTURE_FALLING			0x04	//Captura en cada flanco de bajada
+#define CCP_CAPTURE_RISING			0x05	//Captura en cada flanco de subida
+#define CCP_CAPTURE_RISING_4		0x06	//Captura cada 4o flanco de subida
+#define CCP_CAPTURE_RISING_16		0x07	//Captura cada 16o flanco de subida
+//Captura alternada de flancos de subida y de bajada (modo por software) para medir ancho de pulso y ciclo de trabajo
+#define CCP_CAPTURE_BOTH			0xFF
+
+/*
+    Identificadores de módulo. Los módulos ECCP se distinguen de los CCP con el mismo número.
+*/
+#define CAPTURE_CCP1		0x01
+#define CAPTURE_CCP2		0x02
+#define CAPTURE_CCP3		0x03
+#define CAPTURE_CCP4		0x04
+#define CAPTURE_CCP5		0x05
+#define CAPTURE_CCP6		0x06
+#define CAPTURE_CCP7		0x07
+#define CAPTURE_CCP8		0x08
+#define CAPTURE_CCP9		0x09
+#define CAPTURE_CCP10		0x0A
+#define CAPTURE_ECCP1		0x11
+#define CAPTURE_ECCP2		0x12
+#define CAPTURE_ECCP3		0x13
+
+/*
+    Temporizadores de 16 bits que pueden servir de base de tiempo para la captura
+*/
+#if defined (TMR_V2) || defined (TMR_V4) || defined (TMR_V6) || defined (TMR_V7) || defined (TMR_V7_1) ||\
+    defined (TMR_V7_2) || defined (TMR_V7_3) || defined (TMR_V7_4) || defined (TMR_V7_5)
+#define CAPTURE_TIMER3
+#endif
+#if defined (TMR_V7) || defined (TMR_V7_1) || defined (TMR_V7_3) || defined (TMR_V7_4)
+#define CAPTURE_TIMER5
+#endif
+
+/**
+ * @brief Número de marcas de tiempo del buffer circular de cada canal (potencia de 2). Puede redefinirse en pconfig.h
+ */
+#ifndef CAPTURE_BUFFER
+#define CAPTURE_BUFFER		8
+#endif
+
+#if (CAPTURE_BUFFER & (CAPTURE_BUFFER - 1)) != 0 || (CAPTURE_BUFFER > 128)
+#error "CAPTURE_BUFFER debe ser potencia de 2 no mayor que 128"
+#endif
+
+/**
+ * @brief Canal de captura. La aplicación reserva la estructura (típicamente estática) y no debe modificar sus campos.
+ */
+typedef struct capture_t {
+    struct capture_t *siguiente;                // Lista de canales atendidos por capture_interruptHandler
+    volatile uint32_t marcas[CAPTURE_BUFFER];   // Buffer circular de marcas de tiempo
+    volatile uint8_t escritura;                 // Índices libres de desborde: solo la interrupción escribe 'escritura'
+    volatile uint8_t lectura;                   // y solo capture_read escribe 'lectura'
+    volatile uint8_t perdidas;                  // Marcas descartadas con el buffer lleno (satura en 255)
+    volatile uint8_t flancos;                   // Contador de capturas, para lectura consistente de periodo y alto
+    volatile uint32_t ultima;                   // Última marca de flanco de subida (o del flanco configurado)
+    volatile uint32_t periodo;                  // Cuentas entre las dos últimas marcas de subida
+    volatile uint32_t alto;                     // Cuentas en alto del último pulso (CCP_CAPTURE_BOTH)
+    volatile uint32_t alto_ciclo;               // Cuentas en alto del periodo en 'periodo' (CCP_CAPTURE_BOTH)
+    volatile uint8_t *con;                      // Registros del módulo
+    volatile uint8_t *ccprl;
+    volatile uint8_t *ccprh;
+    uint8_t modulo;
+    uint8_t modo;
+    uint8_t temporizador;
+    bool subida;                                // Flanco esperado en CCP_CAPTURE_BOTH
+    volatile bool referencia;                   // Existe una marca de subida previa en 'ultima'
+} capture_t;
+
+/**
+ * @brief Configura un módulo en modo captura y registra el canal para su atención en capture_interruptHandler.
+ * Habilita las interrupciones del módulo y de desborde del temporizador; la habilitación global queda a cargo de la
+ * aplicación. El temporizador debe inicializarse y encenderse por separado (timerx_init) y asociarse al módulo con
+ * setTimerCCPsource o con los bits de selección del parámetro seleccion, según la versión. El pin de captura debe
+ * estar configurado como entrada (y asignado por PPS en las versiones que lo requieren).
+ * @param c Canal de captura
+ * @param modulo Identificador del módulo (CAPTURE_CCPx o CAPTURE_ECCPx)
+ * @param modo Modo de captura (CCP_CAPTURE_x)
+ * @param temporizador Temporizador asociado al módulo (1, 3 o 5), cuyos desbordes extienden las marcas a 32 bits.
+ * La interrupción de desborde de este temporizador queda a cargo de capture_interruptHandler.
+ * @param seleccion Selección de temporizador en versiones con registro CCPTMRS (CCP_x_SEL_TMRxx o ECCP_x_SEL_TMRxx de
+ * compare.h); 0 en las demás
+ * @return (bool) true si el módulo y el temporizador existen en esta versión
+ */
+bool capture_init(capture_t *c, uint8_t modulo, uint8_t modo, uint8_t temporizador, uint8_t seleccion);
+
+/**
+ * @brief Deshabilita el módulo y retira el canal de la lista de atención
+ * @param c Canal de captura
+ */
+void capture_stop(capture_t *c);
+
+/**
+ * @brief Número de marcas de tiempo pendientes de leer en el buffer
+ * @param c Canal de captura
+ * @return (uint8_t) Marcas disponibles
+ */
+uint8_t capture_available(const capture_t *c);
+
+/**
+ * @brief Extrae la marca de tiempo más antigua del buffer
+ * @param c Canal de captura
+ * @param marca Marca de tiempo de 32 bits en cuentas del temporizador
+ * @return (bool) true si había una marca disponible
+ */
+bool capture_read(capture_t *c, uint32_t *marca);
+
+/**
+ * @brief Periodo de la señal: cuentas entre las dos últimas capturas de subida, divididas entre el número de flancos
+ * por captura (4 o 16 en CCP_CAPTURE_RISING_4/16)
+ * @param c Canal de captura
+ * @param periodo Periodo en cuentas del temporizador
+ * @return (bool) true si ya se capturaron dos flancos
+ */
+bool capture_getPeriod(const capture_t *c, uint32_t *periodo);
+
+/**
+ * @brief Frecuencia de la señal a partir del último periodo
+ * @param c Canal de captura
+ * @param frecuencia_timer Frecuencia de conteo del temporizador en [Hz] (p.ej. _XTAL_FREQ/4 sin preescala)
+ * @return (uint32_t) Frecuencia en [Hz] redondeada, 0 si aún no hay periodo
+ */
+uint32_t capture_getFrequency(const capture_t *c, uint32_t frecuencia_timer);
+
+/**
+ * @brief Ancho del último pulso en alto (solo en CCP_CAPTURE_BOTH)
+ * @param c Canal de captura
+ * @param alto Cuentas en alto
+ * @return (bool) true si ya se midió un pulso completo
+ */
+bool capture_getPulseWidth(const capture_t *c, uint32_t *alto);
+
+/**
+ * @brief Ciclo de trabajo del último periodo completo (solo en CCP_CAPTURE_BOTH)
+ * @param c Canal de captura
+ * @return (uint16_t) Ciclo de trabajo en décimas de porcentaje (0 a 1000), 0 si aún no hay periodo
+ */
+uint16_t capture_getDuty(const capture_t *c);
+
+/**
+ * @brief Valor actual del temporizador extendido a 32 bits, en la misma escala que las marcas de tiempo. Permite detectar
+ * la ausencia de señal comparando contra la última marca.
+ * @param c Canal de captura
+ * @return (uint32_t) Cuentas
+ */
+uint32_t capture_now(const capture_t *c);
+
+/**
+ * @brief Cuentas transcurridas desde la última captura de subida (p.ej. para considerar frecuencia cero si excede un límite)
+ * @param c Canal de captura
+ * @return (uint32_t) Cuentas
+ */
+uint32_t capture_sinceLast(const capture_t *c);
+
+/**
+ * @brief Función de manejo de interrupción de captura y de desborde de los temporizadores asociados. Debe llamarse desde
+ * la rutina de interrupción.
+ */
+void capture_interruptHandler(void);
+
+#endif	/* CAPTURE_H */
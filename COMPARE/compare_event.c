@@ -0,0 +1,374 @@
+/**
+ * @file compare_event.c
+ * @brief Cola de eventos de salida programados sobre un módulo CCP en modo output compare: lista ordenada por tiempo de
+ * acciones (poner en alto, en bajo, conmutar o solo notificar) que se encadenan desde la interrupción del CCP, con marcas
+ * de tiempo de 32 bits en la base de tiempo de uptime.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "compare_event.h"
+
+/*
+	Registros y funciones de compare.c del módulo seleccionado
+*/
+#if defined (COMPARE_EVENT_ECCP)
+#if (COMPARE_EVENT_ECCP == 1)
+#define _compare_event_init(p)		ecompare1_init(p)
+#define _compare_event_setPeriod(p)	ecompare1_setPeriod(p)
+#if defined (ECC_V5)
+#define _CE_IF		ECCP1IF
+#define _CE_IE		ECCP1IE
+#define _CE_CON		ECCP1CON
+#elif defined (ECC_V8_3) || defined (ECC_V8_4) || defined (ECC_V8_5)
+#define _CE_IF		CCP1IF
+#define _CE_IE		CCP1IE
+#define _CE_CON		CCP1CON
+#else
+#define _CE_IF		CCP1IF
+#define _CE_IE		CCP1IE
+#define _CE_CON		ECCP1CON
+#endif
+#elif (COMPARE_EVENT_ECCP == 2)
+#define _compare_event_init(p)		ecompare2_init(p)
+#define _compare_event_setPeriod(p)	ecompare2_setPeriod(p)
+#define _CE_IF		CCP2IF
+#define _CE_IE		CCP2IE
+#if defined (ECC_V8_3) || defined (ECC_V8_4)
+#define _CE_CON		CCP2CON
+#else
+#define _CE_CON		ECCP2CON
+#endif
+#elif (COMPARE_EVENT_ECCP == 3)
+#define _compare_event_init(p)		ecompare3_init(p)
+#define _compare_event_setPeriod(p)	ecompare3_setPeriod(p)
+#define _CE_IF		CCP3IF
+#define _CE_IE		CCP3IE
+#define _CE_CON		CCP3CON
+#else
+#error "COMPARE_EVENT_ECCP debe ser 1, 2 o 3"
+#endif
+
+#elif (COMPARE_EVENT_CCP == 1)
+#define _compare_event_init(p)		compare1_init(p)
+#define _compare_event_setPeriod(p)	compare1_setPeriod(p)
+#define _CE_IF		CCP1IF
+#define _CE_IE		CCP1IE
+#define _CE_CON		CCP1CON
+#elif (COMPARE_EVENT_CCP == 2)
+#define _compare_event_init(p)		compare2_init(p)
+#define _compare_event_setPeriod(p)	compare2_setPeriod(p)
+#define _CE_IF		CCP2IF
+#define _CE_IE		CCP2IE
+#define _CE_CON		CCP2CON
+#elif (COMPARE_EVENT_CCP == 3)
+#define _compare_event_init(p)		compare3_init(p)
+#define _compare_event_setPeriod(p)	compare3_setPeriod(p)
+#define _CE_IF		CCP3IF
+#define _CE_IE		CCP3IE
+#define _CE_CON		CCP3CON
+#elif (COMPARE_EVENT_CCP == 4)
+#define _compare_event_init(p)		compare4_init(p)
+#define _compare_event_setPeriod(p)	compare4_setPeriod(p)
+#define _CE_IF		CCP4IF
+#define _CE_IE		CCP4IE
+#define _CE_CON		CCP4CON
+#elif (COMPARE_EVENT_CCP == 5)
+#define _compare_event_init(p)		compare5_init(p)
+#define _compare_event_setPeriod(p)	compare5_setPeriod(p)
+#define _CE_IF		CCP5IF
+#define _CE_IE		CCP5IE
+#define _CE_CON		CCP5CON
+#elif (COMPARE_EVENT_CCP == 6)
+#define _compare_event_init(p)		compare6_init(p)
+#define _compare_event_setPeriod(p)	compare6_setPeriod(p)
+#define _CE_IF		CCP6IF
+#define _CE_IE		CCP6IE
+#define _CE_CON		CCP6CON
+#elif (COMPARE_EVENT_CCP == 7)
+#define _compare_event_init(p)		compare7_init(p)
+#define _compare_event_setPeriod(p)	compare7_setPeriod(p)
+#define _CE_IF		CCP7IF
+#define _CE_IE		CCP7IE
+#define _CE_CON		CCP7CON
+#elif (COMPARE_EVENT_CCP == 8)
+#define _compare_event_init(p)		compare8_init(p)
+#define _compare_event_setPeriod(p)	compare8_setPeriod(p)
+#define _CE_IF		CCP8IF
+#define _CE_IE		CCP8IE
+#define _CE_CON		CCP8CON
+#elif (COMPARE_EVENT_CCP == 9)
+#define _compare_event_init(p)		compare9_init(p)
+#define _compare_event_setPeriod(p)	compare9_setPeriod(p)
+#define _CE_IF		CCP9IF
+#define _CE_IE		CCP9IE
+#define _CE_CON		CCP9CON
+#elif (COMPARE_EVENT_CCP == 10)
+#define _compare_event_init(p)		compare10_init(p)
+#define _compare_event_setPeriod(p)	compare10_setPeriod(p)
+#define _CE_IF		CCP10IF
+#define _CE_IE		CCP10IE
+#define _CE_CON		CCP10CON
+#else
+#error "COMPARE_EVENT_CCP debe estar entre 1 y 10"
+#endif
+
+#define COMPARE_EVENT_MASCARA	(COMPARE_EVENT_COLA - 1)
+
+typedef struct compare_event_t {
+	uint32_t marca;
+	uint8_t accion;
+} compare_event_t;
+
+static compare_event_t _compare_event_cola[COMPARE_EVENT_COLA];		// Cola circular ordenada por marca de tiempo
+static volatile uint8_t _compare_event_cabeza = 0;
+static volatile uint8_t _compare_event_n = 0;
+static volatile bool _compare_event_armado = false;		// El evento de la cabeza está programado en el módulo
+static volatile bool _compare_event_nivel_armado;		// Nivel de la salida tras el evento programado
+static volatile bool _compare_event_nivel = false;		// Nivel actual de la salida (y de su LAT)
+static volatile uint8_t _compare_event_tardios = 0;
+static volatile uint8_t *_compare_event_lat = NULL;
+static uint8_t _compare_event_mascara = 0;
+static compare_event_callback_t _compare_event_callback = NULL;
+
+/*
+	Nivel de la salida tras una acción
+*/
+static bool _compare_event_resultado(uint8_t accion)
+{
+	switch(accion)
+	{
+		case COMPARE_EVENT_SET: return true;
+		case COMPARE_EVENT_CLR: return false;
+		case COMPARE_EVENT_TOGGLE: return !_compare_event_nivel;
+		default: return _compare_event_nivel;
+	}
+}
+
+/*
+	Actualización del LAT del pin para que coincida con la salida del módulo: así CCP_COMPARE_INT (el pin toma el valor
+	de LAT) sirve como estado neutro sin alterar la salida.
+*/
+static void _compare_event_setLat(bool nivel)
+{
+	if(nivel)
+	{
+		*_compare_event_lat |= _compare_event_mascara;
+	}
+	else
+	{
+		*_compare_event_lat &= (uint8_t)~_compare_event_mascara;
+	}
+}
+
+/*
+	El evento programado de la cabeza ya se ejecutó en el módulo: se retira de la cola y se notifica
+*/
+static void _compare_event_ejecutado(void)
+{
+	compare_event_t e = _compare_event_cola[_compare_event_cabeza];
+	_compare_event_cabeza = (_compare_event_cabeza + 1) & COMPARE_EVENT_MASCARA;
+	_compare_event_n--;
+	_compare_event_armado = false;
+	if(_compare_event_nivel_armado != _compare_event_nivel)
+	{
+		_compare_event_nivel = _compare_event_nivel_armado;
+		_compare_event_setLat(_compare_event_nivel);
+	}
+	if(_compare_event_callback != NULL)
+	{
+		_compare_event_callback(e.marca, e.accion);
+	}
+}
+
+/*
+	Programación del evento de la cabeza. Un evento a más de 0xFFFF cuentas no puede programarse aún en los 16 bits de
+	CCPRx: se carga su parte baja sin cambiar de modo, y la coincidencia de la vuelta anterior del temporizador (sin efecto
+	en la salida) vuelve a llamar esta función cuando faltan menos de 0x10000 cuentas.
+	Debe llamarse con la interrupción del módulo deshabilitada y con el módulo en estado neutro (sin acción pendiente).
+*/
+static void _compare_event_armar(void)
+{
+	const compare_event_t *e;
+	uint32_t ahora;
+	uint32_t objetivo;
+	int32_t restante;
+	bool nivel;
+	if(_compare_event_armado)
+	{
+		return;
+	}
+	if(_compare_event_n == 0)
+	{
+		_CE_IE = 0;
+		return;
+	}
+	e = &_compare_event_cola[_compare_event_cabeza];
+	ahora = uptime_getTicks32();
+	restante = (int32_t)(e->marca - ahora);
+	if(restante > 0xFFFFL)
+	{
+		// Si la coincidencia de la vuelta anterior está demasiado próxima, se revisa de nuevo a media vuelta
+		_compare_event_setPeriod((uint16_t)((restante >= 0x10000L + COMPARE_EVENT_MARGEN) ? e->marca : ahora + 0x8000));
+		_CE_IF = 0;
+		_CE_IE = 1;
+		return;
+	}
+	objetivo = e->marca;
+	if(restante < COMPARE_EVENT_MARGEN)
+	{
+		objetivo = ahora + COMPARE_EVENT_MARGEN;
+		if(_compare_event_tardios != 255)
+		{
+			_compare_event_tardios++;
+		}
+	}
+	// CCPRx primero: en estado neutro una coincidencia con el valor intermedio no altera la salida
+	_compare_event_setPeriod((uint16_t)objetivo);
+	nivel = _compare_event_resultado(e->accion);
+	if(nivel == _compare_event_nivel)
+	{
+		_CE_CON = CCP_COMPARE_INT;
+	}
+	else
+	{
+		// La escritura del modo inicializa el latch en el nivel opuesto al destino, que es el nivel actual
+		_CE_CON = nivel ? CCP_COMPARE_SET_ON_MATCH : CCP_COMPARE_CLR_ON_MATCH;
+	}
+	_compare_event_nivel_armado = nivel;
+	_compare_event_armado = true;
+	_CE_IF = 0;
+	_CE_IE = 1;
+}
+
+/*
+	Retiro del evento programado para poder programar otro anterior. Si el módulo ya lo ejecutó, el evento sigue en la
+	cabeza como programado y con _CE_IF activa: solo se actualiza el LAT para que el estado neutro conserve la salida, y
+	la siguiente llamada a compare_event_interruptHandler lo retira y lo notifica en contexto de interrupción.
+*/
+static void _compare_event_desarmar(void)
+{
+	if(!_CE_IF)
+	{
+		_CE_CON = CCP_COMPARE_INT;		// Estado neutro: la salida toma el valor de LAT, igual al nivel actual
+		if(!_CE_IF)
+		{
+			_compare_event_armado = false;
+			return;
+		}
+	}
+	if(_compare_event_nivel_armado != _compare_event_nivel)
+	{
+		_compare_event_nivel = _compare_event_nivel_armado;
+		_compare_event_setLat(_compare_event_nivel);
+	}
+	_CE_CON = CCP_COMPARE_INT;			// LAT ya actualizado: la salida conserva el nivel que dejó el evento
+}
+
+void compare_event_init(uint8_t seleccion, volatile uint8_t *lat, uint8_t mascara, bool nivel_inicial)
+{
+	_CE_IE = 0;
+	_compare_event_lat = lat;
+	_compare_event_mascara = mascara;
+	_compare_event_nivel = nivel_inicial;
+	_compare_event_setLat(nivel_inicial);
+	_compare_event_cabeza = 0;
+	_compare_event_n = 0;
+	_compare_event_armado = false;
+	_compare_event_tardios = 0;
+	_compare_event_init(CCP_COMPARE_INT | seleccion);
+	_CE_CON = CCP_COMPARE_INT;
+	_CE_IF = 0;
+}
+
+bool compare_event_schedule(uint32_t marca, uint8_t accion)
+{
+	uint8_t i;
+	uint8_t minimo;
+	bool ie = _CE_IE;
+	_CE_IE = 0;
+	if(_compare_event_n == COMPARE_EVENT_COLA)
+	{
+		_CE_IE = ie;
+		return false;
+	}
+	if(_compare_event_armado && (int32_t)(marca - _compare_event_cola[_compare_event_cabeza].marca) < 0)
+	{
+		_compare_event_desarmar();
+	}
+	// Inserción ordenada desde el final; el evento programado en el módulo (o ya ejecutado y sin notificar) conserva su lugar
+	minimo = _compare_event_armado ? 1 : 0;
+	i = _compare_event_n;
+	while(i > minimo &&
+		(int32_t)(marca - _compare_event_cola[(_compare_event_cabeza + i - 1) & COMPARE_EVENT_MASCARA].marca) < 0)
+	{
+		_compare_event_cola[(_compare_event_cabeza + i) & COMPARE_EVENT_MASCARA] =
+			_compare_event_cola[(_compare_event_cabeza + i - 1) & COMPARE_EVENT_MASCARA];
+		i--;
+	}
+	_compare_event_cola[(_compare_event_cabeza + i) & COMPARE_EVENT_MASCARA].marca = marca;
+	_compare_event_cola[(_compare_event_cabeza + i) & COMPARE_EVENT_MASCARA].accion = accion;
+	_compare_event_n++;
+	if(_compare_event_armado)
+	{
+		_CE_IE = 1;
+	}
+	else
+	{
+		_compare_event_armar();
+	}
+	return true;
+}
+
+bool compare_event_scheduleIn(uint32_t retardo, uint8_t accion)
+{
+	return compare_event_schedule(uptime_getTicks32() + retardo, accion);
+}
+
+void compare_event_clear(void)
+{
+	_CE_IE = 0;
+	if(_compare_event_armado)
+	{
+		_compare_event_desarmar();		// Un evento ya ejecutado se descarta sin notificar
+	}
+	_compare_event_n = 0;
+	_compare_event_armado = false;
+}
+
+uint8_t compare_event_pending(void)
+{
+	return _compare_event_n;
+}
+
+bool compare_event_getLevel(void)
+{
+	return _compare_event_nivel;
+}
+
+uint8_t compare_event_getLate(void)
+{
+	return _compare_event_tardios;
+}
+
+void compare_event_setCallback(compare_event_callback_t callback)
+{
+	bool ie = _CE_IE;
+	_CE_IE = 0;
+	_compare_event_callback = callback;
+	_CE_IE = ie;
+}
+
+void compare_event_interruptHandler(void)
+{
+	if(!(_CE_IF && _CE_IE))
+	{
+		return;
+	}
+	_CE_IF = 0;
+	if(_compare_event_armado)
+	{
+		_compare_event_ejecutado();
+	}
+	_compare_event_armar();
+}
@@ -0,0 +1,129 @@
+/**
+ * @file compare_event.h
+ * @brief Cola de eventos de salida programados sobre un módulo CCP en modo output compare: lista ordenada por tiempo de
+ * acciones (poner en alto, en bajo, conmutar o solo notificar) que se encadenan desde la interrupción del CCP, con marcas
+ * de tiempo de 32 bits en la base de tiempo de uptime.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef COMPARE_EVENT_H
+#define	COMPARE_EVENT_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../pconfig.h"
+#include "../TIMERS/uptime.h"
+#include "compare.h"
+
+/*
+	Módulo utilizado, definido en pconfig.h: COMPARE_EVENT_CCP con el número de módulo CCP (1 a 10) o COMPARE_EVENT_ECCP
+	con el número de módulo ECCP (1 a 3). El módulo debe tener como base de tiempo el temporizador de uptime (UPTIME_TIMER).
+*/
+#if !defined (COMPARE_EVENT_CCP) && !defined (COMPARE_EVENT_ECCP)
+#define COMPARE_EVENT_CCP		1
+#endif
+
+/**
+ * @brief Número de eventos de la cola (potencia de 2). Puede redefinirse en pconfig.h
+ */
+#ifndef COMPARE_EVENT_COLA
+#define COMPARE_EVENT_COLA		16
+#endif
+
+/**
+ * @brief Anticipación mínima en cuentas para programar un evento. Un evento con menos anticipación (o ya vencido) se
+ * ejecuta COMPARE_EVENT_MARGEN cuentas después de programarse y se contabiliza como tardío. Debe cubrir la duración de
+ * la programación desde la interrupción.
+ */
+#ifndef COMPARE_EVENT_MARGEN
+#define COMPARE_EVENT_MARGEN	128
+#endif
+
+#if (COMPARE_EVENT_COLA & (COMPARE_EVENT_COLA - 1)) != 0 || (COMPARE_EVENT_COLA > 128)
+#error "COMPARE_EVENT_COLA debe ser potencia de 2 no mayor que 128"
+#endif
+
+/*
+	Acciones de un evento
+*/
+#define COMPARE_EVENT_SET		0	// Salida en alto (CCP_COMPARE_SET_ON_MATCH)
+#define COMPARE_EVENT_CLR		1	// Salida en bajo (CCP_COMPARE_CLR_ON_MATCH)
+#define COMPARE_EVENT_TOGGLE	2	// Conmutación de la salida
+#define COMPARE_EVENT_NOTIFY	3	// Solo notificación (CCP_COMPARE_INT), la salida no cambia
+
+/**
+ * @brief Función de notificación de evento ejecutado. Se ejecuta en contexto de interrupción y puede programar nuevos
+ * eventos (p.ej. para recargar la cola de una rampa de aceleración).
+ * @param marca Marca de tiempo programada del evento
+ * @param accion Acción del evento
+ */
+typedef void (*compare_event_callback_t)(uint32_t marca, uint8_t accion);
+
+/**
+ * @brief Configura el módulo CCP en modo comparación y vacía la cola. Las acciones de alto y bajo usan los modos
+ * CCP_COMPARE_SET_ON_MATCH y CCP_COMPARE_CLR_ON_MATCH; la conmutación se resuelve a uno de ellos según el nivel actual,
+ * ya que la escritura de CCPxCON reinicia el latch de comparación. En reposo el módulo queda en CCP_COMPARE_INT y el pin
+ * toma el valor de su LAT, que esta cola mantiene igual al nivel de la salida. El pin debe configurarse como salida
+ * (TRIS y PPS) por la aplicación, y uptime_init debe haberse llamado.
+ * @param seleccion Selección de temporizador en versiones con registro CCPTMRS (CCP_x_SEL_TMRxx o ECCP_x_SEL_TMRxx); 0 en las demás
+ * @param lat Registro LAT del pin del módulo (p.ej. &LATC)
+ * @param mascara Bit del pin en el registro LAT (p.ej. 0x04 para RC2)
+ * @param nivel_inicial Nivel inicial de la salida
+ */
+void compare_event_init(uint8_t seleccion, volatile uint8_t *lat, uint8_t mascara, bool nivel_inicial);
+
+/**
+ * @brief Agrega un evento en orden de tiempo. Eventos con la misma marca se ejecutan en orden de llegada.
+ * @param marca Marca de tiempo absoluta en cuentas de uptime_getTicks32
+ * @param accion Acción (COMPARE_EVENT_x)
+ * @return (bool) true si el evento cabe en la cola
+ */
+bool compare_event_schedule(uint32_t marca, uint8_t accion);
+
+/**
+ * @brief Agrega un evento relativo al instante actual
+ * @param retardo Cuentas a partir de ahora (UPTIME_US y UPTIME_MS convierten desde [us] y [ms])
+ * @param accion Acción (COMPARE_EVENT_x)
+ * @return (bool) true si el evento cabe en la cola
+ */
+bool compare_event_scheduleIn(uint32_t retardo, uint8_t accion);
+
+/**
+ * @brief Descarta los eventos pendientes. La salida conserva su nivel actual; un evento ya ejecutado por el módulo pero
+ * aún no atendido por compare_event_interruptHandler se descarta sin llamar a la función de notificación.
+ */
+void compare_event_clear(void);
+
+/**
+ * @brief Número de eventos pendientes
+ * @return (uint8_t) Eventos en la cola
+ */
+uint8_t compare_event_pending(void);
+
+/**
+ * @brief Nivel actual de la salida (tras el último evento ejecutado)
+ * @return (bool) true si la salida está en alto
+ */
+bool compare_event_getLevel(void);
+
+/**
+ * @brief Número de eventos ejecutados después de su marca por falta de anticipación (satura en 255)
+ * @return (uint8_t) Eventos tardíos
+ */
+uint8_t compare_event_getLate(void);
+
+/**
+ * @brief Registra la función de notificación de eventos ejecutados
+ * @param callback Función de notificación (NULL para ninguna)
+ */
+void compare_event_setCallback(compare_event_callback_t callback);
+
+/**
+ * @brief Función de manejo de interrupción del módulo CCP. Debe llamarse desde la rutina de interrupción.
+ */
+void compare_event_interruptHandler(void);
+
+#endif	/* COMPARE_EVENT_H */
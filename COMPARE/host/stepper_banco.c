@@ -0,0 +1,307 @@
+/**
+ * @file stepper_banco.c
+ * @brief Banco de pruebas de stepper.c en la PC: compara las tablas de stepper_planTrapezoid y stepper_planSCurve con la
+ * recurrencia de Leib y con la integración de la curva S en punto flotante, simula dos ejes sobre un modelo del
+ * temporizador y de los módulos CCP (posiciones, intervalo mínimo, aceleración, paro en crucero) y mide la duración de
+ * stepper_interruptHandler. Regresa 0 si todas las verificaciones pasan.
+ * Se compila desde el directorio COMPARE:
+ * gcc -std=c99 -O2 -I host/stub/lib/pic -o stepper_banco host/stepper_banco.c stepper.c -lm
+ * La duración de la interrupción se mide en la PC y solo sirve para comparar versiones; los ciclos en el PIC se miden con
+ * el cronómetro del simulador de MPLAB.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <math.h>
+#include <time.h>
+#include "../stepper.h"
+
+volatile uint8_t CCP1CON, CCPR1L, CCPR1H, PIR1, PIE1, LATB;
+volatile uint8_t CCP2CON, CCPR2L, CCPR2H, PIR2, PIE2;
+volatile INTCONbits_t INTCONbits;
+
+#define MAX_FLANCOS		200000
+
+static uint64_t _tiempo;				// Cuentas del temporizador simulado
+static int _fallas;
+
+uint16_t get_timer1(void)
+{
+	return (uint16_t)_tiempo;
+}
+
+/*
+	Modelo de un módulo CCP en modo comparación con conmutación
+*/
+typedef struct {
+	volatile uint8_t *con, *ccprl, *ccprh, *pir;
+	uint8_t mascara;
+	int pin;
+	int n;
+	uint64_t subidas[MAX_FLANCOS];		// Tiempos de los flancos de subida
+} ccp_t;
+
+static ccp_t _ccp1 = { .con = &CCP1CON, .ccprl = &CCPR1L, .ccprh = &CCPR1H, .pir = &PIR1, .mascara = 0x04 };
+static ccp_t _ccp2 = { .con = &CCP2CON, .ccprl = &CCPR2L, .ccprh = &CCPR2H, .pir = &PIR2, .mascara = 0x01 };
+
+static void _ccp_tick(ccp_t *c)
+{
+	if(*c->con != CCP_COMPARE_INT_AND_TOGGLE)
+	{
+		c->pin = 0;
+		return;
+	}
+	if((uint16_t)_tiempo == make16(*c->ccprh, *c->ccprl))
+	{
+		c->pin ^= 1;
+		*c->pir |= c->mascara;
+		if(c->pin && c->n < MAX_FLANCOS)
+			c->subidas[c->n++] = _tiempo;
+	}
+}
+
+static void _simular(uint64_t hasta, stepper_t *a, stepper_t *b)
+{
+	for(; _tiempo < hasta; _tiempo++)
+	{
+		_ccp_tick(&_ccp1);
+		_ccp_tick(&_ccp2);
+		if((PIR1 & PIE1 & 0x04) || (PIR2 & PIE2 & 0x01))
+			stepper_interruptHandler();
+		if(!stepper_isRunning(a) && (b == NULL || !stepper_isRunning(b)))
+			break;
+	}
+}
+
+static void _verificar(int condicion, const char *texto)
+{
+	printf("  %-58s %s\n", texto, condicion ? "ok" : "FALLA");
+	if(!condicion)
+		_fallas++;
+}
+
+/*
+	Trapezoidal: recurrencia de Leib en punto flotante, p' = p (1 - q + 1.5 q^2), q = a p^2 / F^2
+*/
+static void _banco_trapezoid(uint32_t f, uint16_t v0, uint16_t vmax, uint32_t a)
+{
+	static stepper_perfil_t perfil;
+	static double ref[0x10000];
+	double p = (double)f / v0, err_max = 0, err_cin = 0, e;
+	uint32_t n = 0, i;
+	char texto[96];
+
+	printf("Trapezoidal F=%lu v0=%u vmax=%u a=%lu\n", (unsigned long)f, v0, vmax, (unsigned long)a);
+	if(!stepper_planTrapezoid(&perfil, f, v0, vmax, a))
+	{
+		_verificar(0, "perfil aceptado");
+		return;
+	}
+	while(p > perfil.crucero && n < 0x10000)
+	{
+		double q = a * p * p / ((double)f * f);
+		ref[n++] = p;
+		p = p * (1 - q + 1.5 * q * q);
+	}
+	printf("  pasos %u (referencia %lu), desplazamiento %u, crucero %u\n", perfil.pasos, (unsigned long)n,
+		perfil.desplazamiento, perfil.crucero);
+	snprintf(texto, sizeof texto, "pasos de la rampa dentro de 1%% de la recurrencia");
+	_verificar(fabs((double)perfil.pasos - n) <= 2 + 0.01 * n, texto);
+	for(i = 0; (i << perfil.desplazamiento) < perfil.pasos && (i << perfil.desplazamiento) < n; i++)
+	{
+		uint32_t k = i << perfil.desplazamiento;
+
+		e = fabs(perfil.tabla[i] - ref[k]) / ref[k];
+		if(e > err_max)
+			err_max = e;
+		e = fabs(perfil.tabla[i] - f / sqrt((double)v0 * v0 + 2.0 * a * k)) * sqrt((double)v0 * v0 + 2.0 * a * k) / f;
+		if(e > err_cin)
+			err_cin = e;
+	}
+	printf("  error máximo de la tabla: %.3f%% contra Leib, %.3f%% contra la cinemática exacta\n", 100 * err_max,
+		100 * err_cin);
+	_verificar(err_max < 0.01, "tabla dentro de 1% de la recurrencia de Leib");
+}
+
+/*
+	Curva S: la misma integración por paso que stepper_planSCurve, en punto flotante
+*/
+static void _banco_scurve(uint32_t f, uint16_t v0, uint16_t vmax, uint32_t a, uint32_t j)
+{
+	static stepper_perfil_t perfil;
+	static double ref[0x10000];
+	double v = v0, acel = 0, e, err_max = 0;
+	uint32_t n = 0, i;
+	int bajando = 0;
+
+	printf("Curva S F=%lu v0=%u vmax=%u a=%lu j=%lu\n", (unsigned long)f, v0, vmax, (unsigned long)a, (unsigned long)j);
+	if(!stepper_planSCurve(&perfil, f, v0, vmax, a, j))
+	{
+		_verificar(0, "perfil aceptado");
+		return;
+	}
+	while(v < vmax && !(bajando && acel <= 0) && n < 0x10000)
+	{
+		ref[n++] = f / v;
+		if(!bajando && acel * acel / (2.0 * j) >= vmax - v)
+			bajando = 1;
+		acel = bajando ? fmax(acel - j / v, 0) : fmin(acel + j / v, a);
+		v += acel / v;
+	}
+	printf("  pasos %u (referencia %lu), desplazamiento %u, crucero %u\n", perfil.pasos, (unsigned long)n,
+		perfil.desplazamiento, perfil.crucero);
+	// Cerca de v_max la integración entera anula la aceleración unos pasos antes; el intervalo ya difiere en menos de una cuenta
+	_verificar(fabs((double)perfil.pasos - n) <= 2 + 0.03 * n, "pasos de la rampa dentro de 3% de la integración");
+	for(i = 0; (i << perfil.desplazamiento) < perfil.pasos && (i << perfil.desplazamiento) < n; i++)
+	{
+		e = fabs(perfil.tabla[i] - ref[i << perfil.desplazamiento]) / ref[i << perfil.desplazamiento];
+		if(e > err_max)
+			err_max = e;
+	}
+	printf("  error máximo de la tabla: %.3f%%\n", 100 * err_max);
+	_verificar(err_max < 0.02, "tabla dentro de 2% de la integración");
+}
+
+/*
+	Aceleración máxima de un eje simulado, con la velocidad media de ventanas de VENTANA pasos: entre pasos consecutivos
+	domina la cuantización de una cuenta del intervalo
+*/
+#define VENTANA		16
+
+/* La interpolación lineal del intervalo dentro del primer tramo de la tabla, donde el intervalo es más convexo, acelera
+   algo más que el perfil al final del tramo */
+#define ACEL_TOLERANCIA	1.25
+
+static double _aceleracion_max(const ccp_t *c, uint32_t f, int desde)
+{
+	double maxima = 0, v1, v2, acel;
+	int i;
+
+	for(i = desde + VENTANA; i + VENTANA < c->n; i++)
+	{
+		v1 = (double)VENTANA * f / (c->subidas[i] - c->subidas[i - VENTANA]);
+		v2 = (double)VENTANA * f / (c->subidas[i + VENTANA] - c->subidas[i]);
+		acel = fabs(v2 - v1) / ((double)(c->subidas[i + VENTANA] - c->subidas[i - VENTANA]) / 2 / f);
+		if(acel > maxima)
+			maxima = acel;
+	}
+	return maxima;
+}
+
+static uint64_t _intervalo_min(const ccp_t *c)
+{
+	uint64_t minimo = UINT64_MAX;
+	int i;
+
+	for(i = 1; i < c->n; i++)
+	{
+		if(c->subidas[i] - c->subidas[i - 1] < minimo)
+			minimo = c->subidas[i] - c->subidas[i - 1];
+	}
+	return minimo;
+}
+
+/*
+	Duración de la interrupción: una llamada dura menos que la resolución del reloj, de modo que se mide en lotes con el
+	eje 1 en un movimiento largo. El flanco de bajada incluye el cálculo del siguiente intervalo.
+*/
+static double _ahora(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+static void _medir_interrupcion(stepper_t *m)
+{
+	const long llamadas = 2000000;
+	double t0, subida = 0, bajada = 0, reloj = 0;
+	long i;
+
+	stepper_move(m, 0x7FFFFFFF);
+	for(i = 0; i < llamadas; i++)
+	{
+		PIR1 |= 0x04;
+		t0 = _ahora();
+		stepper_interruptHandler();
+		PIR1 |= 0x04;
+		subida += _ahora() - t0;
+		t0 = _ahora();
+		stepper_interruptHandler();
+		bajada += _ahora() - t0;
+	}
+	// Costo de leer el reloj, descontado
+	for(i = 0; i < llamadas; i++)
+	{
+		t0 = _ahora();
+		reloj += _ahora() - t0;
+	}
+	stepper_abort(m);
+	PIR1 |= 0x04;
+	stepper_interruptHandler();
+	PIR1 |= 0x04;
+	stepper_interruptHandler();
+	printf("Interrupción (PC, dos ejes registrados): subida %.1f ns, bajada %.1f ns por llamada\n",
+		(subida - reloj) / llamadas, (bajada - reloj) / llamadas);
+}
+
+int main(void)
+{
+	static stepper_perfil_t trapecio, curva;
+	static stepper_t m1, m2;
+	const stepper_hw_t h1 = { &CCP1CON, &CCPR1L, &CCPR1H, &PIR1, &PIE1, 0x04, &LATB, 0x01 };
+	const stepper_hw_t h2 = { &CCP2CON, &CCPR2L, &CCPR2H, &PIR2, &PIE2, 0x01, NULL, 0 };
+	const uint32_t f = 1250000;		// 40 MHz, Fosc/4, preescala 1:8
+	int previos;
+
+	_banco_trapezoid(f, 300, 5000, 20000);
+	_banco_trapezoid(2000000, 500, 8000, 50000);
+	_banco_trapezoid(250000, 100, 1000, 2000);
+	printf("Trapezoidal con q >= 1/4 en el primer paso\n");
+	_verificar(!stepper_planTrapezoid(&trapecio, f, 200, 5000, 20000), "perfil rechazado");
+	_banco_scurve(f, 200, 5000, 20000, 200000);
+	_banco_scurve(2000000, 500, 8000, 100000, 2000000);
+
+	printf("Simulación de dos ejes\n");
+	stepper_planTrapezoid(&trapecio, f, 300, 5000, 20000);
+	stepper_planSCurve(&curva, f, 200, 5000, 20000, 200000);
+	stepper_init(&m1, &h1);
+	stepper_init(&m2, &h2);
+	stepper_setProfile(&m1, &trapecio);
+	stepper_setProfile(&m2, &curva);
+	_tiempo = 12345;
+	stepper_move(&m1, 3000);
+	stepper_move(&m2, -400);
+	_simular(UINT64_MAX, &m1, &m2);
+	printf("  posiciones %ld y %ld, flancos %d y %d\n", (long)stepper_getPosition(&m1), (long)stepper_getPosition(&m2),
+		_ccp1.n, _ccp2.n);
+	_verificar(stepper_getPosition(&m1) == 3000 && _ccp1.n == 3000, "eje 1: 3000 pasos");
+	_verificar(stepper_getPosition(&m2) == -400 && _ccp2.n == 400, "eje 2: -400 pasos");
+	_verificar((LATB & 0x01) == 0x01, "pin de dirección del eje 1");
+	_verificar(_intervalo_min(&_ccp1) >= trapecio.crucero && _intervalo_min(&_ccp1) >= STEPPER_INTERVALO_MIN,
+		"intervalo mínimo del eje 1 igual al de crucero");
+	printf("  aceleración máxima: eje 1 %.0f, eje 2 %.0f pasos/s^2\n", _aceleracion_max(&_ccp1, f, 0),
+		_aceleracion_max(&_ccp2, f, 0));
+	_verificar(_aceleracion_max(&_ccp1, f, 0) < ACEL_TOLERANCIA * 20000, "aceleración del eje 1 acotada");
+	_verificar(_aceleracion_max(&_ccp2, f, 0) < ACEL_TOLERANCIA * 20000, "aceleración del eje 2 acotada");
+
+	printf("Paro en crucero\n");
+	_ccp1.n = 0;
+	stepper_move(&m1, 100000);
+	_simular(_tiempo + 3000000, &m1, NULL);
+	previos = _ccp1.n;
+	stepper_stop(&m1);
+	_simular(UINT64_MAX, &m1, NULL);
+	printf("  pasos antes del paro %d, pasos de frenado %d (rampa %u), desaceleración máxima %.0f pasos/s^2\n", previos,
+		_ccp1.n - previos, trapecio.pasos, _aceleracion_max(&_ccp1, f, previos - VENTANA));
+	_verificar(previos > trapecio.pasos && _ccp1.n - previos <= trapecio.pasos + 2, "frena dentro de la rampa");
+	_verificar(_aceleracion_max(&_ccp1, f, previos - VENTANA) < ACEL_TOLERANCIA * 20000, "desaceleración acotada");
+
+	_medir_interrupcion(&m1);
+	printf(_fallas ? "%d verificaciones fallaron\n" : "Todas las verificaciones pasaron\n", _fallas);
+	return _fallas != 0;
+}
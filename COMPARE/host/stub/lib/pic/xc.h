@@ -0,0 +1,24 @@
+/**
+ * @file xc.h
+ * @brief Registros del PIC como variables para compilar stepper.c en la PC. Se incluye con -I host/stub/lib/pic, de modo
+ * que las rutas "../../pconfig.h" y "../../utils/utils.h" de la librería lleguen a host/stub, igual que en un proyecto.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef XC_H
+#define XC_H
+
+#include <stdint.h>
+
+typedef uint32_t uint24_t;
+
+extern volatile uint8_t CCP1CON, CCPR1L, CCPR1H, PIR1, PIE1, LATB;
+extern volatile uint8_t CCP2CON, CCPR2L, CCPR2H, PIR2, PIE2;
+
+typedef struct {
+	unsigned GIE : 1;
+} INTCONbits_t;
+extern volatile INTCONbits_t INTCONbits;
+
+#endif	/* XC_H */
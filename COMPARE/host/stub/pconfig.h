@@ -0,0 +1,14 @@
+/**
+ * @file pconfig.h
+ * @brief Configuración del proyecto para compilar los bancos de pruebas en la PC (host/stepper_banco.c)
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef PCONFIG_H
+#define PCONFIG_H
+
+#define _XTAL_FREQ		40000000UL
+#define TMR_V6
+
+#endif	/* PCONFIG_H */
@@ -0,0 +1,16 @@
+/**
+ * @file utils.h
+ * @brief Macros de utils.h necesarias para compilar los bancos de pruebas en la PC
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef UTILS_H
+#define UTILS_H
+
+#include <stdint.h>
+
+#define make8(v, n)		((uint8_t)((v) >> (8 * (n))))
+#define make16(h, l)	((uint16_t)(((uint16_t)(h) << 8) | (l)))
+
+#endif	/* UTILS_H */
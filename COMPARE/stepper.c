@@ -0,0 +1,337 @@
+/**
+ * @file stepper.c
+ * @brief Generador de rampas para motores a pasos sobre módulos CCP en modo comparación con conmutación
+ * (CCP_COMPARE_INT_AND_TOGGLE): perfiles trapezoidal (aproximación entera de Leib) y curva S precalculados en tablas
+ * de intervalos, de modo que la interrupción solo consulta la tabla y suma el intervalo a CCPRx. Varios ejes en
+ * distintos módulos CCP comparten el mismo temporizador.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "../../utils/utils.h"
+#include "stepper.h"
+
+#if STEPPER_TIMER == 3
+#define _stepper_timer()	get_timer3()
+#elif STEPPER_TIMER == 5
+#define _stepper_timer()	get_timer5()
+#else
+#define _stepper_timer()	get_timer1()
+#endif
+
+/* Pasos máximos de una rampa */
+#define _STEPPER_PASOS_MAX	0xFFFF
+
+static stepper_t *_stepper_lista = NULL;		// Ejes registrados
+
+/*
+	Número de pasos de la rampa y desplazamiento de submuestreo que deja la tabla dentro de STEPPER_RAMPA entradas
+*/
+static bool _stepper_desplazamiento(stepper_perfil_t *perfil, uint32_t pasos)
+{
+	uint8_t s = 0;
+
+	if(pasos > _STEPPER_PASOS_MAX)
+		return false;
+	while(pasos != 0 && (pasos - 1) >> s >= STEPPER_RAMPA)
+		s++;
+	perfil->pasos = (uint16_t)pasos;
+	perfil->desplazamiento = s;
+	return true;
+}
+
+/*
+	Intervalos de inicio y de crucero en cuentas
+*/
+static bool _stepper_limites(stepper_perfil_t *perfil, uint32_t frecuencia_timer, uint16_t v_inicial, uint16_t v_max)
+{
+	uint32_t crucero;
+
+	if(v_inicial == 0 || v_max < v_inicial)
+		return false;
+	crucero = frecuencia_timer / v_max;
+	if(crucero < STEPPER_INTERVALO_MIN || frecuencia_timer / v_inicial > 0xFFFF)
+		return false;
+	perfil->crucero = (uint16_t)crucero;
+	return true;
+}
+
+bool stepper_planTrapezoid(stepper_perfil_t *perfil, uint32_t frecuencia_timer, uint16_t v_inicial, uint16_t v_max,
+	uint32_t aceleracion)
+{
+	uint32_t p, fin, i;
+	uint64_t p2, t, q, pq, pq2;
+	uint8_t pasada;
+
+	if(aceleracion == 0 || !_stepper_limites(perfil, frecuencia_timer, v_inicial, v_max))
+		return false;
+	// q = a p^2 / F^2 decrece con p: basta verificar q < 1/4 en el primer paso, lo que además acota a p^2 < 2^46
+	p = frecuencia_timer / v_inicial;
+	if(aceleracion > ((uint64_t)frecuencia_timer * frecuencia_timer / 4) / ((uint64_t)p * p))
+		return false;
+	fin = (uint32_t)perfil->crucero << 8;
+	perfil->pasos = 0;
+	// Primera pasada: cuenta los pasos de la rampa; segunda: llena la tabla submuestreada
+	for(pasada = 0; pasada < 2; pasada++)
+	{
+		p = (uint32_t)(((uint64_t)frecuencia_timer << 8) / v_inicial);	// Intervalo en Q8
+		for(i = 0; p > fin; i++)
+		{
+			if(pasada == 0 && i >= _STEPPER_PASOS_MAX)
+				return false;
+			if(pasada == 1 && (i & ((1UL << perfil->desplazamiento) - 1)) == 0)
+				perfil->tabla[i >> perfil->desplazamiento] = (uint16_t)(p >> 8);
+			// p' = p (1 - q + 1.5 q^2), q en Q24
+			p2 = ((uint64_t)p * p) >> 16;
+			t = ((uint64_t)aceleracion * p2 << 16) / frecuencia_timer;
+			q = (t << 8) / frecuencia_timer;
+			pq = ((uint64_t)p * q) >> 24;
+			pq2 = (pq * q) >> 24;
+			p = p - (uint32_t)pq + (uint32_t)((3 * pq2) >> 1);
+		}
+		if(pasada == 0 && !_stepper_desplazamiento(perfil, i))
+			return false;
+	}
+	return true;
+}
+
+bool stepper_planSCurve(stepper_perfil_t *perfil, uint32_t frecuencia_timer, uint16_t v_inicial, uint16_t v_max,
+	uint32_t aceleracion, uint32_t jerk)
+{
+	uint32_t v, fin, i;
+	uint32_t dv;
+	uint64_t a, a_max, j, dj;
+	uint8_t pasada;
+	bool bajando;
+
+	// Aceleración acotada a 2^20 pasos/s^2 para que a^2 en Q8 quepa en 64 bits
+	if(aceleracion == 0 || aceleracion > 0x100000UL || jerk == 0 ||
+		!_stepper_limites(perfil, frecuencia_timer, v_inicial, v_max))
+		return false;
+	a_max = (uint64_t)aceleracion << 8;
+	j = (uint64_t)jerk << 16;
+	fin = (uint32_t)v_max << 8;
+	perfil->pasos = 0;
+	for(pasada = 0; pasada < 2; pasada++)
+	{
+		// Velocidad y aceleración en Q8; cada paso dura 1/v: v += a/v, a += j/v
+		v = (uint32_t)v_inicial << 8;
+		a = 0;
+		bajando = false;
+		// La rampa termina al alcanzar v_max o al anularse la aceleración (el error de integración es menor a un paso)
+		for(i = 0; v < fin && !(bajando && a == 0); i++)
+		{
+			if(pasada == 0 && i >= _STEPPER_PASOS_MAX)
+				return false;
+			if(pasada == 1 && (i & ((1UL << perfil->desplazamiento) - 1)) == 0)
+				perfil->tabla[i >> perfil->desplazamiento] = (uint16_t)(((uint64_t)frecuencia_timer << 8) / v);
+			// Inicio de la fase de aceleración decreciente: llevar a a cero gana a^2 / 2j de velocidad
+			if(!bajando && ((a * a) >> 8) / (2 * (uint64_t)jerk) >= fin - v)
+				bajando = true;
+			dj = j / v;
+			if(bajando)
+				a = (a > dj) ? a - dj : 0;
+			else
+				a = (a + dj < a_max) ? a + dj : a_max;
+			dv = (uint32_t)((a << 8) / v);
+			v += dv ? dv : 1;
+		}
+		if(pasada == 0 && !_stepper_desplazamiento(perfil, i))
+			return false;
+	}
+	return true;
+}
+
+void stepper_init(stepper_t *m, const stepper_hw_t *hw)
+{
+	stepper_t *p;
+	uint8_t gie;
+
+	*hw->con = 0;
+	*hw->pie &= (uint8_t)~hw->mascara;
+	*hw->pir &= (uint8_t)~hw->mascara;
+	m->hw = *hw;
+	m->perfil = NULL;
+	m->restantes = 0;
+	m->ejecutados = 0;
+	m->posicion = 0;
+	m->activo = false;
+	// La lista se recorre desde la interrupción: los apuntadores de 16 bits se modifican con interrupciones deshabilitadas
+	gie = INTCONbits.GIE;
+	INTCONbits.GIE = 0;
+	for(p = _stepper_lista; p != NULL && p != m; p = p->siguiente);
+	if(p == NULL)
+	{
+		m->siguiente = _stepper_lista;
+		_stepper_lista = m;
+	}
+	INTCONbits.GIE = gie;
+}
+
+void stepper_setProfile(stepper_t *m, const stepper_perfil_t *perfil)
+{
+	m->perfil = perfil;
+}
+
+/*
+	Intervalo del siguiente paso: índice en la rampa de aceleración (pasos ejecutados) o en la de desaceleración (pasos
+	restantes), el menor de ambos; más allá de la rampa, el intervalo de crucero. Entre entradas de una tabla submuestreada
+	se interpola linealmente para no concentrar el cambio de velocidad de varios pasos en uno solo.
+*/
+static uint16_t _stepper_intervalo(const stepper_t *m)
+{
+	const stepper_perfil_t *perfil = m->perfil;
+	uint32_t k = m->restantes - 1;
+	uint16_t e, actual, siguiente;
+	uint8_t s = perfil->desplazamiento;
+
+	if(m->ejecutados < k)
+		k = m->ejecutados;
+	if(k >= perfil->pasos)
+		return perfil->crucero;
+	e = (uint16_t)k >> s;
+	actual = perfil->tabla[e];
+	if(s == 0)
+		return actual;
+	siguiente = ((uint32_t)(e + 1) << s < perfil->pasos) ? perfil->tabla[e + 1] : perfil->crucero;
+	return actual - (uint16_t)(((uint32_t)(actual - siguiente) * ((uint16_t)k & ((1U << s) - 1))) >> s);
+}
+
+static void _stepper_sumar(const stepper_t *m, uint16_t cuentas)
+{
+	uint16_t ccpr = make16(*m->hw.ccprh, *m->hw.ccprl) + cuentas;
+
+	*m->hw.ccprh = (uint8_t)(ccpr >> 8);
+	*m->hw.ccprl = (uint8_t)ccpr;
+}
+
+bool stepper_move(stepper_t *m, int32_t pasos)
+{
+	uint16_t ccpr;
+	uint8_t gie;
+
+	if(m->activo || m->perfil == NULL)
+		return false;
+	if(pasos == 0)
+		return true;
+	m->sentido = 1;
+	if(pasos < 0)
+	{
+		pasos = -pasos;
+		m->sentido = -1;
+	}
+	if(m->hw.dir_lat != NULL)
+	{
+		if(m->sentido > 0)
+			*m->hw.dir_lat |= m->hw.dir_mascara;
+		else
+			*m->hw.dir_lat &= (uint8_t)~m->hw.dir_mascara;
+	}
+	m->restantes = (uint32_t)pasos;
+	m->ejecutados = 0;
+	m->intervalo = _stepper_intervalo(m);
+	m->bajada = false;
+	m->activo = true;
+	// Borrar CCPxCON deja el latch de comparación en bajo; el primer flanco de subida ocurre STEPPER_MARGEN cuentas después
+	gie = INTCONbits.GIE;
+	INTCONbits.GIE = 0;
+	*m->hw.con = 0;
+	ccpr = _stepper_timer() + STEPPER_MARGEN;
+	*m->hw.ccprh = (uint8_t)(ccpr >> 8);
+	*m->hw.ccprl = (uint8_t)ccpr;
+	*m->hw.con = CCP_COMPARE_INT_AND_TOGGLE;
+	*m->hw.pir &= (uint8_t)~m->hw.mascara;
+	*m->hw.pie |= m->hw.mascara;
+	INTCONbits.GIE = gie;
+	return true;
+}
+
+void stepper_stop(stepper_t *m)
+{
+	uint32_t k;
+	uint8_t gie = INTCONbits.GIE;
+
+	INTCONbits.GIE = 0;
+	// La desaceleración inicia en el índice de rampa actual: restan tantos pasos como los ya acelerados, a lo más la rampa
+	// completa si el eje está en crucero
+	if(m->activo)
+	{
+		k = m->ejecutados;
+		if(k > m->perfil->pasos)
+			k = m->perfil->pasos;
+		k++;
+		if(m->restantes > k)
+			m->restantes = k;
+	}
+	INTCONbits.GIE = gie;
+}
+
+void stepper_abort(stepper_t *m)
+{
+	uint8_t gie = INTCONbits.GIE;
+
+	INTCONbits.GIE = 0;
+	if(m->activo)
+		m->restantes = 1;
+	INTCONbits.GIE = gie;
+}
+
+bool stepper_isRunning(const stepper_t *m)
+{
+	return m->activo;
+}
+
+int32_t stepper_getPosition(const stepper_t *m)
+{
+	int32_t posicion;
+	uint8_t gie = INTCONbits.GIE;
+
+	INTCONbits.GIE = 0;
+	posicion = m->posicion;
+	INTCONbits.GIE = gie;
+	return posicion;
+}
+
+void stepper_setPosition(stepper_t *m, int32_t posicion)
+{
+	uint8_t gie = INTCONbits.GIE;
+
+	INTCONbits.GIE = 0;
+	m->posicion = posicion;
+	INTCONbits.GIE = gie;
+}
+
+void stepper_interruptHandler(void)
+{
+	stepper_t *m;
+	uint16_t medio;
+
+	for(m = _stepper_lista; m != NULL; m = m->siguiente)
+	{
+		if(!(*m->hw.pir & m->hw.mascara) || !(*m->hw.pie & m->hw.mascara))
+			continue;
+		*m->hw.pir &= (uint8_t)~m->hw.mascara;
+		medio = m->intervalo >> 1;
+		if(!m->bajada)
+		{
+			// Flanco de subida: el pulso dura medio intervalo
+			_stepper_sumar(m, medio);
+			m->bajada = true;
+			continue;
+		}
+		// Flanco de bajada: paso completo
+		m->bajada = false;
+		m->posicion += m->sentido;
+		if(m->ejecutados < 0xFFFF)
+			m->ejecutados++;
+		if(--m->restantes == 0)
+		{
+			*m->hw.pie &= (uint8_t)~m->hw.mascara;
+			*m->hw.con = 0;
+			m->activo = false;
+			continue;
+		}
+		_stepper_sumar(m, m->intervalo - medio);
+		m->intervalo = _stepper_intervalo(m);
+	}
+}
@@ -0,0 +1,183 @@
+/**
+ * @file stepper.h
+ * @brief Generador de rampas para motores a pasos sobre módulos CCP en modo comparación con conmutación
+ * (CCP_COMPARE_INT_AND_TOGGLE): perfiles trapezoidal (aproximación entera de Leib) y curva S precalculados en tablas
+ * de intervalos, de modo que la interrupción solo consulta la tabla y suma el intervalo a CCPRx. Varios ejes en
+ * distintos módulos CCP comparten el mismo temporizador.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef STEPPER_H
+#define	STEPPER_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../pconfig.h"
+#include "../TIMERS/timers.h"
+#include "compare.h"
+
+/**
+ * @brief Temporizador de 16 bits de conteo libre asociado a los módulos CCP de los ejes (1, 3 o 5)
+ */
+#ifndef STEPPER_TIMER
+#define STEPPER_TIMER			1
+#endif
+
+/**
+ * @brief Entradas de la tabla de rampa. Rampas más largas se submuestrean: cada entrada cubre 2, 4, 8... pasos y la
+ * interrupción interpola linealmente entre entradas.
+ */
+#ifndef STEPPER_RAMPA
+#define STEPPER_RAMPA			64
+#endif
+
+/**
+ * @brief Intervalo mínimo entre pasos en cuentas del temporizador: cada paso requiere dos interrupciones (flanco de
+ * subida y de bajada), que deben atenderse dentro de medio intervalo.
+ */
+#ifndef STEPPER_INTERVALO_MIN
+#define STEPPER_INTERVALO_MIN	200
+#endif
+
+/* Cuentas entre el inicio de un movimiento y su primer flanco */
+#ifndef STEPPER_MARGEN
+#define STEPPER_MARGEN			64
+#endif
+
+/**
+ * @brief Perfil de velocidad: intervalos en cuentas del temporizador de los pasos de la rampa de aceleración. La rampa
+ * de desaceleración recorre la misma tabla en sentido inverso. Un perfil puede compartirse entre varios ejes.
+ */
+typedef struct stepper_perfil_t {
+	uint16_t tabla[STEPPER_RAMPA];
+	uint16_t pasos;				// Pasos de la rampa
+	uint8_t desplazamiento;		// log2 de los pasos por entrada de la tabla
+	uint16_t crucero;			// Intervalo a velocidad máxima
+} stepper_perfil_t;
+
+/**
+ * @brief Registros del módulo CCP de un eje y pin de dirección. Ejemplo para CCP1 con dirección en RB0:
+ * { &CCP1CON, &CCPR1L, &CCPR1H, &PIR1, &PIE1, 0x04, &LATB, 0x01 }
+ */
+typedef struct stepper_hw_t {
+	volatile uint8_t *con;
+	volatile uint8_t *ccprl;
+	volatile uint8_t *ccprh;
+	volatile uint8_t *pir;			// Registro de la bandera CCPxIF
+	volatile uint8_t *pie;			// Registro del bit CCPxIE
+	uint8_t mascara;				// Bit de CCPxIF/CCPxIE en PIR/PIE
+	volatile uint8_t *dir_lat;		// LAT del pin de dirección (NULL si no se utiliza)
+	uint8_t dir_mascara;
+} stepper_hw_t;
+
+/**
+ * @brief Eje. La aplicación reserva la estructura (típicamente estática) y no debe modificar sus campos.
+ */
+typedef struct stepper_t {
+	struct stepper_t *siguiente;			// Lista de ejes atendidos por stepper_interruptHandler
+	stepper_hw_t hw;
+	const stepper_perfil_t *perfil;
+	volatile uint32_t restantes;			// Pasos restantes del movimiento
+	volatile uint16_t ejecutados;			// Pasos ejecutados (saturado al final de la rampa)
+	volatile int32_t posicion;
+	uint16_t intervalo;						// Intervalo del paso en curso
+	int8_t sentido;
+	bool bajada;							// Siguiente conmutación: flanco de bajada (fin del paso)
+	volatile bool activo;
+} stepper_t;
+
+/**
+ * @brief Calcula un perfil trapezoidal con la aproximación de Leib: p' = p(1 - q + 1.5q^2), q = a p^2 / F^2, en
+ * aritmética entera. Se ejecuta fuera de la interrupción.
+ * @param perfil Perfil a calcular
+ * @param frecuencia_timer Frecuencia de conteo del temporizador en [Hz]
+ * @param v_inicial Velocidad inicial en [pasos/s]
+ * @param v_max Velocidad de crucero en [pasos/s]
+ * @param aceleracion Aceleración en [pasos/s^2]
+ * @return (bool) true si el perfil es válido: intervalos entre STEPPER_INTERVALO_MIN y 65535 cuentas y q < 1/4 en el
+ * primer paso (v_inicial^2 > 4 aceleracion), fuera de lo cual la aproximación de Leib pierde exactitud
+ */
+bool stepper_planTrapezoid(stepper_perfil_t *perfil, uint32_t frecuencia_timer, uint16_t v_inicial, uint16_t v_max,
+	uint32_t aceleracion);
+
+/**
+ * @brief Calcula un perfil de curva S (jerk limitado): la aceleración crece con jerk constante hasta aceleracion, se
+ * mantiene, y decrece con el mismo jerk para llegar a v_max con aceleración cero. Integración paso a paso en aritmética
+ * entera. Se ejecuta fuera de la interrupción.
+ * @param perfil Perfil a calcular
+ * @param frecuencia_timer Frecuencia de conteo del temporizador en [Hz]
+ * @param v_inicial Velocidad inicial en [pasos/s]
+ * @param v_max Velocidad de crucero en [pasos/s]
+ * @param aceleracion Aceleración máxima en [pasos/s^2]
+ * @param jerk Jerk en [pasos/s^3]
+ * @return (bool) true si el perfil es válido
+ */
+bool stepper_planSCurve(stepper_perfil_t *perfil, uint32_t frecuencia_timer, uint16_t v_inicial, uint16_t v_max,
+	uint32_t aceleracion, uint32_t jerk);
+
+/**
+ * @brief Registra un eje. El módulo CCP se configura antes con compareN_init(CCP_COMPARE_INT_AND_TOGGLE | seleccion),
+ * que establece el pin como salida y la selección de temporizador; el temporizador debe estar encendido en conteo libre.
+ * El LAT del pin de pasos debe estar en bajo.
+ * @param m Eje
+ * @param hw Registros del módulo (se copian)
+ */
+void stepper_init(stepper_t *m, const stepper_hw_t *hw);
+
+/**
+ * @brief Asigna el perfil de velocidad de los siguientes movimientos
+ * @param m Eje
+ * @param perfil Perfil calculado con stepper_planTrapezoid o stepper_planSCurve
+ */
+void stepper_setProfile(stepper_t *m, const stepper_perfil_t *perfil);
+
+/**
+ * @brief Inicia un movimiento relativo. Movimientos cortos no alcanzan la velocidad de crucero (perfil triangular).
+ * @param m Eje
+ * @param pasos Pasos con signo; el signo establece el pin de dirección
+ * @return (bool) true si el movimiento inició (false si el eje está en movimiento o no tiene perfil)
+ */
+bool stepper_move(stepper_t *m, int32_t pasos);
+
+/**
+ * @brief Detiene el movimiento desacelerando desde la velocidad actual
+ * @param m Eje
+ */
+void stepper_stop(stepper_t *m);
+
+/**
+ * @brief Detiene el movimiento de inmediato, al final del pulso en curso
+ * @param m Eje
+ */
+void stepper_abort(stepper_t *m);
+
+/**
+ * @brief Indica si el eje está en movimiento
+ * @param m Eje
+ * @return (bool) true si el eje está en movimiento
+ */
+bool stepper_isRunning(const stepper_t *m);
+
+/**
+ * @brief Posición absoluta en pasos
+ * @param m Eje
+ * @return (int32_t) Posición
+ */
+int32_t stepper_getPosition(const stepper_t *m);
+
+/**
+ * @brief Establece la posición absoluta (p.ej. tras una búsqueda de origen). Solo con el eje detenido.
+ * @param m Eje
+ * @param posicion Posición en pasos
+ */
+void stepper_setPosition(stepper_t *m, int32_t posicion);
+
+/**
+ * @brief Función de manejo de interrupción de los módulos CCP de los ejes. Debe llamarse desde la rutina de interrupción.
+ */
+void stepper_interruptHandler(void);
+
+#endif	/* STEPPER_H */
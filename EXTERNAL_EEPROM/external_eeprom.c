@@ -8,6 +8,8 @@
 
 #include "external_eeprom.h"
 
+#if (EXTERNAL_EEPROM_METODO_COM == EXTERNAL_EEPROM_METODO_I2C)
+
 /****************************************************************************************
 *    Nombre de función:  external_eeprom_init                              				*
 *    Valor de retorno:   Estado de bus si hay al menos una memoria serial en el bus		*
@@ -894,6 +896,233 @@ external_eeprom_status_t external_eeprom_read(void *datos, uint32_t addr, uint16
     
 }
 
+#else
+
+/*
+    Backend SPI para memorias EEPROM de la serie 25XX (25AA/25LC). Se utiliza el módulo SPI seleccionado mediante 
+    EXTERNAL_EEPROM_METODO_NUM, el cual debe inicializarse previamente en modo maestro (modo 0,0 o 1,1).
+*/
+#if defined (SPI_V1) || defined (SPI_V4)
+#define _external_eeprom_spi_xmit(dato)             spi_xmit(dato)
+#define _external_eeprom_spi_writeBuffer(buf,len)   spi_writeBuffer(buf,len)
+#define _external_eeprom_spi_readBuffer(buf,len)    spi_readBuffer(buf,len)
+#elif (EXTERNAL_EEPROM_METODO_NUM == 2)
+#define _external_eeprom_spi_xmit(dato)             spi2_xmit(dato)
+#define _external_eeprom_spi_writeBuffer(buf,len)   spi2_writeBuffer(buf,len)
+#define _external_eeprom_spi_readBuffer(buf,len)    spi2_readBuffer(buf,len)
+#else
+#define _external_eeprom_spi_xmit(dato)             spi1_xmit(dato)
+#define _external_eeprom_spi_writeBuffer(buf,len)   spi1_writeBuffer(buf,len)
+#define _external_eeprom_spi_readBuffer(buf,len)    spi1_readBuffer(buf,len)
+#endif
+
+/*
+    Lectura de registro de estado de la memoria SPI
+*/
+static uint8_t _external_eeprom_spiStatus(void)
+{
+    uint8_t status;
+    EXTERNAL_EEPROM_CS = 0;
+    _external_eeprom_spi_xmit(EXTERNAL_EEPROM_SPI_RDSR);
+    status = _external_eeprom_spi_xmit(0xFF);
+    EXTERNAL_EEPROM_CS = 1;
+    return status;
+}
+
+/*
+    Envío de instrucción y dirección de 16 o 24 bits. Al retornar, !CS permanece en estado bajo.
+*/
+static void _external_eeprom_spiCommand(uint8_t instruccion, uint32_t addr)
+{
+    EXTERNAL_EEPROM_CS = 0;
+    _external_eeprom_spi_xmit(instruccion);
+    if(_nAddrBytes == 3)
+        _external_eeprom_spi_xmit(make8(addr,2));
+    _external_eeprom_spi_xmit(make8(addr,1));
+    _external_eeprom_spi_xmit(make8(addr,0));
+}
+
+/********************************************************************************
+*    Nombre de función:  external_eeprom_waitReady                              *
+*    Valor de retorno:   Ninguno                                                *
+*    Parámetros: Ninguno                                                        *
+*    Descripción: Espera a que termine el ciclo interno de escritura pendiente, *
+*    verificando el bit WIP del registro de estado. Las funciones de escritura  *
+*    retornan sin esperar dicho ciclo; la espera se realiza al inicio de la     *
+*    siguiente operación o mediante esta función (p. ej. antes de SLEEP).       *
+********************************************************************************/
+void external_eeprom_waitReady(void)
+{
+    if(!_spiWriteBusy)
+        return;
+    while(_external_eeprom_spiStatus() & EXTERNAL_EEPROM_SPI_WIP){}
+    _spiWriteBusy = false;
+}
+
+/****************************************************************************************
+*    Nombre de función:  external_eeprom_init                              				*
+*    Valor de retorno:   Estado de memoria: 0-Error 1-OK 3-Configuración inválida        *
+*    Parámetros:                                                                		*
+*    - tipo_memoria:  Tipo de memoria serial SPI. Ej: MICROCHIP_25XX256          		*
+*    - n_dispositivos: Número de dispositivos. Solo se soporta una memoria SPI     		*
+*    Descripción: Inicialización de variables y pin !CS para memorias SPI 25XX           *
+****************************************************************************************/
+external_eeprom_status_t external_eeprom_init(external_eeprom_t tipo_memoria, uint8_t n_dispositivos)
+{
+    if(tipo_memoria < MICROCHIP_25XX080 || n_dispositivos != 1)
+        return EXTERNAL_EEPROM_CONFIG_ERR;
+    _deviceType = tipo_memoria;
+    _nDevices = n_dispositivos;
+    _pageSize = external_eeprom_tamano_pagina[tipo_memoria];
+    _deviceCapacity = external_eeprom_capacidad[tipo_memoria];
+    _totalCapacity = (_deviceCapacity * 1024UL)/8;
+    _maxAddress = _totalCapacity - 1;
+    _nAddrBytes = (_deviceCapacity > kibits_512)? 3:2;
+    _spiWriteBusy = false;
+
+    EXTERNAL_EEPROM_CS = 1;
+    EXTERNAL_EEPROM_CS_TRIS = 0;    //Pin !CS como salida, memoria deseleccionada
+
+    //Los bits 4..6 del registro de estado siempre se leen en 0; 0xFF indica que no hay memoria en el bus
+    return (_external_eeprom_spiStatus() == 0xFF)? EXTERNAL_EEPROM_ADDR_ERR:EXTERNAL_EEPROM_OK;
+}
+
+/************************************************************************************
+*    Nombre de función:  external_eeprom_write                                      *
+*    Valor de retorno:   Estado de escritura: 0-Error 1-OK                          *
+*    Parámetros:                                                                    *
+*    - datos:  Apuntador  datos a escribir en la memoria (incluso estructuras)      *
+*    - addr: Dirección de memoria a partir de la cual se desea escribir el buffer   *
+*    - len: Cantidad de bytes a escribir en la memoria                              *
+*    Descripción: Escritura de ´len´bytes en memoria EEPROM SPI, página por página  *
+*    mediante transferencias de bloque                                              *
+************************************************************************************/
+external_eeprom_status_t external_eeprom_write(void *datos, uint32_t addr, uint16_t len)
+{
+    if(len == 0)
+        return EXTERNAL_EEPROM_OK;
+    if( addr+len-1 > _maxAddress)
+        return EXTERNAL_EEPROM_ADDR_ERR;		//Error de direccionamiento, se excede la máxima dirección posible
+
+    const uint8_t *p = (const uint8_t*)datos;
+    while(len != 0)
+    {
+        uint16_t bloque = _pageSize - (uint16_t)(addr % _pageSize);    //Bytes restantes en la página actual
+        if(bloque > len)
+            bloque = len;
+        external_eeprom_waitReady();                        //Espera a escritura previa (bit WIP)
+        EXTERNAL_EEPROM_CS = 0;
+        _external_eeprom_spi_xmit(EXTERNAL_EEPROM_SPI_WREN);//Habilitación de escritura
+        EXTERNAL_EEPROM_CS = 1;
+        _external_eeprom_spiCommand(EXTERNAL_EEPROM_SPI_WRITE, addr);
+        _external_eeprom_spi_writeBuffer(p, bloque);        //Escritura de página en bloque
+        EXTERNAL_EEPROM_CS = 1;                             //Inicia ciclo interno de escritura
+        _spiWriteBusy = true;
+        p += bloque;
+        addr += bloque;
+        len -= bloque;
+    }
+    return EXTERNAL_EEPROM_OK;
+}
+
+/********************************************************************************
+*    Nombre de función:  external_eeprom_read                                   *
+*    Valor de retorno:   Estado de lectura: 0-Error 1-OK                        *
+*    Parámetros:                                                                *
+*    - buffer:  Apuntador a datos a leer desde la memoria (incluso estructuras) *
+*    - addr: Dirección de memoria a partir de la cual se desea leer             *
+*    - len: Cantidad de bytes a leer desde la memoria                           *
+*    Descripción: Lectura de 'len' bytes desde memoria EEPROM SPI en una sola   *
+*    transferencia de bloque (la lectura no está limitada a una página)         *
+********************************************************************************/
+external_eeprom_status_t external_eeprom_read(void *datos, uint32_t addr, uint16_t len)
+{
+    if(len == 0)
+        return EXTERNAL_EEPROM_OK;
+    if( addr+len-1 > _maxAddress)
+        return EXTERNAL_EEPROM_ADDR_ERR;		//Error de direccionamiento, se excede la máxima dirección posible
+    external_eeprom_waitReady();
+    _external_eeprom_spiCommand(EXTERNAL_EEPROM_SPI_READ, addr);
+    _external_eeprom_spi_readBuffer((uint8_t*)datos, len);
+    EXTERNAL_EEPROM_CS = 1;
+    return EXTERNAL_EEPROM_OK;
+}
+
+/*
+    Funciones de lectura/escritura de tipos específicos, implementadas sobre external_eeprom_write/read
+*/
+external_eeprom_status_t external_eeprom_writeBuffer(uint8_t *buffer, uint32_t addr, uint16_t len)
+{
+    return external_eeprom_write(buffer, addr, len);
+}
+
+external_eeprom_status_t external_eeprom_readBuffer(uint8_t *buffer, uint32_t addr, uint16_t len)
+{
+    return external_eeprom_read(buffer, addr, len);
+}
+
+external_eeprom_status_t external_eeprom_writeByte(uint8_t dato, uint32_t addr)
+{
+    return external_eeprom_write(&dato, addr, sizeof(uint8_t));
+}
+
+uint8_t external_eeprom_readByte(uint32_t addr)
+{
+    uint8_t retval;
+    external_eeprom_read(&retval, addr, sizeof(uint8_t));
+    return retval;
+}
+
+external_eeprom_status_t external_eeprom_writeInt16(uint16_t dato, uint32_t addr)
+{
+    return external_eeprom_write(&dato, addr, sizeof(uint16_t));
+}
+
+uint16_t external_eeprom_readInt16(uint32_t addr)
+{
+    uint16_t retval;
+    external_eeprom_read(&retval, addr, sizeof(uint16_t));
+    return retval;
+}
+
+external_eeprom_status_t external_eeprom_writeInt24(uint24_t dato, uint32_t addr)
+{
+    return external_eeprom_write(&dato, addr, sizeof(uint24_t));
+}
+
+uint24_t external_eeprom_readInt24(uint32_t addr)
+{
+    uint24_t retval;
+    external_eeprom_read(&retval, addr, sizeof(uint24_t));
+    return retval;
+}
+
+external_eeprom_status_t external_eeprom_writeInt32(uint32_t dato, uint32_t addr)
+{
+    return external_eeprom_write(&dato, addr, sizeof(uint32_t));
+}
+
+uint32_t external_eeprom_readInt32(uint32_t addr)
+{
+    uint32_t retval;
+    external_eeprom_read(&retval, addr, sizeof(uint32_t));
+    return retval;
+}
+
+external_eeprom_status_t external_eeprom_writeFloat(float dato, uint32_t addr)
+{
+    return external_eeprom_write(&dato, addr, sizeof(float));
+}
+
+float external_eeprom_readFloat(uint32_t addr)
+{
+    float retval;
+    external_eeprom_read(&retval, addr, sizeof(float));
+    return retval;
+}
+
+#endif
+
 /********************************************************************************
 *    Nombre de función:  external_eeprom_getDeviceCapacity                      *
 *    Valor de retorno:   uint32_t                                               *     
@@ -961,6 +1190,322 @@ const char* external_eeprom_getDeviceName()
         case MICROCHIP_24XX1025:    return "MICROCHIP_24XX1025";
         case MICROCHIP_24XX1026:    return "MICROCHIP_24XX1026";
         case ATMEL_AT24CM02:    return "ATMEL_AT24CM02";
+        case MICROCHIP_25XX080: return "MICROCHIP_25XX080";
+        case MICROCHIP_25XX160: return "MICROCHIP_25XX160";
+        case MICROCHIP_25XX320: return "MICROCHIP_25XX320";
+        case MICROCHIP_25XX640: return "MICROCHIP_25XX640";
+        case MICROCHIP_25XX128: return "MICROCHIP_25XX128";
+        case MICROCHIP_25XX256: return "MICROCHIP_25XX256";
+        case MICROCHIP_25XX512: return "MICROCHIP_25XX512";
+        case MICROCHIP_25XX1024:    return "MICROCHIP_25XX1024";
         default: break;
     }
-}
\ No newline at end of file
+}
+#if (EXTERNAL_EEPROM_METODO_COM == EXTERNAL_EEPROM_METODO_I2C)
+/*
+    Primitivas de bus para el modo distribuido (striping). El bus 0 corresponde al módulo i2c (o i2c1) y el bus 1
+    al módulo i2c2, cuando el microcontrolador cuenta con dos módulos MSSP.
+*/
+static void _external_eeprom_busStart(uint8_t bus)
+{
+#if defined (EXTERNAL_EEPROM_DOS_BUSES)
+    if(bus)
+        i2c2_start();
+    else
+        i2c1_start();
+#else
+    (void)bus;
+#if defined (I2C_V1) || defined (I2C_V4)
+    i2c_start();
+#else
+    i2c1_start();
+#endif
+#endif
+}
+
+static void _external_eeprom_busStop(uint8_t bus)
+{
+#if defined (EXTERNAL_EEPROM_DOS_BUSES)
+    if(bus)
+        i2c2_stop();
+    else
+        i2c1_stop();
+#else
+    (void)bus;
+#if defined (I2C_V1) || defined (I2C_V4)
+    i2c_stop();
+#else
+    i2c1_stop();
+#endif
+#endif
+}
+
+static void _external_eeprom_busRestart(uint8_t bus)
+{
+#if defined (EXTERNAL_EEPROM_DOS_BUSES)
+    if(bus)
+        i2c2_restart();
+    else
+        i2c1_restart();
+#else
+    (void)bus;
+#if defined (I2C_V1) || defined (I2C_V4)
+    i2c_restart();
+#else
+    i2c1_restart();
+#endif
+#endif
+}
+
+static i2c_status_t _external_eeprom_busWriteByte(uint8_t bus, uint8_t dato)
+{
+#if defined (EXTERNAL_EEPROM_DOS_BUSES)
+    return (bus)? i2c2_writeByte(dato):i2c1_writeByte(dato);
+#else
+    (void)bus;
+#if defined (I2C_V1) || defined (I2C_V4)
+    return i2c_writeByte(dato);
+#else
+    return i2c1_writeByte(dato);
+#endif
+#endif
+}
+
+static uint8_t _external_eeprom_busReadByte(uint8_t bus, uint8_t ack)
+{
+#if defined (EXTERNAL_EEPROM_DOS_BUSES)
+    return (bus)? i2c2_readByte(ack):i2c1_readByte(ack);
+#else
+    (void)bus;
+#if defined (I2C_V1) || defined (I2C_V4)
+    return i2c_readByte(ack);
+#else
+    return i2c1_readByte(ack);
+#endif
+#endif
+}
+
+/*
+    Cálculo de byte de control para una memoria individual del arreglo distribuido.
+    Parámetros:
+    - chip: Dirección de hardware de la memoria dentro de su bus (pines A2,A1,A0 disponibles)
+    - addr_fisica: Dirección dentro de la memoria individual
+    Retorno: Byte de control en modo escritura (R/!W = 0)
+*/
+static uint8_t _external_eeprom_stripedControlByte(uint8_t chip, uint32_t addr_fisica)
+{
+    uint8_t u = make8(addr_fisica,2);
+    switch(_deviceType)
+    {
+        case MICROCHIP_24XX16B:     //Sin pines de dirección, bits de bloque B2,B1,B0
+            return EXTERNAL_EEPROM_ADDRESS_WRITE | ((make8(addr_fisica,1) & 0x07) << 1);
+        case MICROCHIP_24XX1025:    //1010 B0 A1 A0 R/!W
+            return EXTERNAL_EEPROM_ADDRESS_WRITE | ((u & 0x01) << 3) | ((chip & 0x03) << 1);
+        case MICROCHIP_24XX1026:    //1010 A2 A1 A16 R/!W
+            return EXTERNAL_EEPROM_ADDRESS_WRITE | ((chip & 0x03) << 2) | ((u & 0x01) << 1);
+        case ATMEL_AT24CM02:        //1010 A2 A17 A16 R/!W
+            return EXTERNAL_EEPROM_ADDRESS_WRITE | ((chip & 0x01) << 3) | ((u & 0x03) << 1);
+        default:                    //1010 A2 A1 A0 R/!W
+            return EXTERNAL_EEPROM_ADDRESS_WRITE | ((chip & 0x07) << 1);
+    }
+}
+
+/*
+    Cantidad máxima de memorias por bus según los pines de dirección libres del tipo de memoria
+*/
+static uint8_t _external_eeprom_maxDevicesPerBus(external_eeprom_t tipo_memoria)
+{
+    switch(tipo_memoria)
+    {
+        case MICROCHIP_24XX16B: return 1;
+        case ATMEL_AT24CM02:    return 2;
+        case MICROCHIP_24XX1025: case MICROCHIP_24XX1026: return 4;
+        default:                return EXTERNAL_EEPROM_MAX_DISPOSITIVOS_BUS;
+    }
+}
+
+/*
+    Selección de memoria del arreglo distribuido: espera mediante ACK polling a que termine su ciclo interno de escritura
+    (solo si fue escrita previamente), y envía la dirección interna. Al retornar, la transacción queda abierta en el bus.
+    Retorno: Bus sobre el que quedó abierta la transacción
+*/
+static uint8_t _external_eeprom_stripedSelect(uint8_t dispositivo, uint32_t addr_fisica, uint8_t *control)
+{
+    uint8_t bus = dispositivo % _nBuses;
+    *control = _external_eeprom_stripedControlByte(dispositivo / _nBuses, addr_fisica);
+    while(true)
+    {
+        _external_eeprom_busStart(bus);                         //Condición START
+        if(_external_eeprom_busWriteByte(bus, *control) == I2C_ACK)
+            break;                                              //Memoria lista, se continúa con la misma transacción
+        _external_eeprom_busStop(bus);
+        __delay_us(5);
+    }
+    _stripedBusy &= ~(1U << dispositivo);
+    if (_nAddrBytes == 2)
+        _external_eeprom_busWriteByte(bus, make8(addr_fisica,1));  //Envío de byte alto de dirección
+    _external_eeprom_busWriteByte(bus, make8(addr_fisica,0));      //Envío de byte bajo de dirección
+    return bus;
+}
+
+/****************************************************************************************
+*    Nombre de función:  external_eeprom_stripedInit                                    *
+*    Valor de retorno:   Estado de inicialización: 0-Error 1-OK 3-Configuración inválida  *
+*    Parámetros:                                                                        *
+*    - tipo_memoria:  Tipo de memoria serial presente en el/los bus(es). Ej: 24LC512     *
+*    - dispositivos_por_bus: Número de memorias en cada bus (direcciones consecutivas   *
+*      a partir de A2,A1,A0 = 0)                                                         *
+*    - n_buses: Número de buses I²C a utilizar (1, o 2 si existen i2c1 e i2c2)          *
+*    Descripción: Inicialización del modo distribuido. Las páginas lógicas consecutivas *
+*    se asignan de forma alternada a cada memoria (y a cada bus), de modo que el ciclo  *
+*    interno de escritura de una memoria se traslape con la escritura de la siguiente.  *
+*    Nota: El espacio de direcciones distribuido no es compatible con el lineal de las  *
+*    funciones external_eeprom_write/read; no deben mezclarse sobre los mismos datos.   *
+****************************************************************************************/
+external_eeprom_status_t external_eeprom_stripedInit(external_eeprom_t tipo_memoria, uint8_t dispositivos_por_bus, uint8_t n_buses)
+{
+#if defined (EXTERNAL_EEPROM_DOS_BUSES)
+    if(n_buses == 0 || n_buses > 2)
+        return EXTERNAL_EEPROM_CONFIG_ERR;
+#else
+    if(n_buses != 1)
+        return EXTERNAL_EEPROM_CONFIG_ERR;
+#endif
+    if(dispositivos_por_bus == 0 || dispositivos_por_bus > _external_eeprom_maxDevicesPerBus(tipo_memoria))
+        return EXTERNAL_EEPROM_CONFIG_ERR;
+
+    _deviceType = tipo_memoria;
+    _nBuses = n_buses;
+    _nDevices = n_buses * dispositivos_por_bus;
+    _pageSize = external_eeprom_tamano_pagina[tipo_memoria];
+    _deviceCapacity = external_eeprom_capacidad[tipo_memoria];
+    _totalCapacity = (_nDevices * _deviceCapacity * 1024UL)/8;
+    _maxAddress = _totalCapacity - 1;
+    _nAddrBytes = (_deviceCapacity > kibits_16)? 2:1;
+    _stripedBusy = 0;
+
+    //Verificación de presencia de cada memoria del arreglo mediante su ACK
+    for(uint8_t d = 0; d != _nDevices; d++)
+    {
+        uint8_t bus = d % _nBuses;
+        _external_eeprom_busStart(bus);
+        i2c_status_t ack = _external_eeprom_busWriteByte(bus, _external_eeprom_stripedControlByte(d / _nBuses, 0));
+        _external_eeprom_busStop(bus);
+        if(ack != I2C_ACK)
+            return EXTERNAL_EEPROM_ADDR_ERR;
+    }
+    return EXTERNAL_EEPROM_OK;
+}
+
+/************************************************************************************
+*    Nombre de función:  external_eeprom_stripedWrite                               *
+*    Valor de retorno:   Estado de escritura: 0-Error 1-OK                          *
+*    Parámetros:                                                                    *
+*    - datos:  Apuntador a datos a escribir en el arreglo                           *
+*    - addr: Dirección lógica a partir de la cual se desea escribir                 *
+*    - len: Cantidad de bytes a escribir                                            *
+*    Descripción: Escritura distribuida. Cada página se envía a la siguiente memoria *
+*    del arreglo sin esperar el ciclo interno de escritura de la anterior; el ACK   *
+*    polling solo se realiza cuando se vuelve a una memoria que sigue ocupada.      *
+************************************************************************************/
+external_eeprom_status_t external_eeprom_stripedWrite(const void *datos, uint32_t addr, uint16_t len)
+{
+    if(len == 0)
+        return EXTERNAL_EEPROM_OK;
+    if( addr+len-1 > _maxAddress)
+        return EXTERNAL_EEPROM_ADDR_ERR;		//Error de direccionamiento, se excede la máxima dirección posible
+
+    const uint8_t *p = (const uint8_t*)datos;
+    uint8_t control;
+    while(len != 0)
+    {
+        uint32_t pagina = addr / _pageSize;                     //Página lógica
+        uint16_t offset = (uint16_t)(addr % _pageSize);         //Posición dentro de la página
+        uint16_t bloque = _pageSize - offset;                   //Bytes restantes en la página
+        if(bloque > len)
+            bloque = len;
+        uint8_t dispositivo = (uint8_t)(pagina % _nDevices);    //Memoria del arreglo que contiene la página
+        uint32_t addr_fisica = (pagina / _nDevices) * _pageSize + offset;
+
+        uint8_t bus = _external_eeprom_stripedSelect(dispositivo, addr_fisica, &control);
+        for(uint16_t i = 0; i != bloque; i++)
+            _external_eeprom_busWriteByte(bus, *(p++));         //Escritura secuencial dentro de la página
+        _external_eeprom_busStop(bus);                          //Inicia ciclo interno de escritura (tWC)
+        _stripedBusy |= (1U << dispositivo);
+
+        addr += bloque;
+        len -= bloque;
+    }
+    return EXTERNAL_EEPROM_OK;
+}
+
+/********************************************************************************
+*    Nombre de función:  external_eeprom_stripedRead                            *
+*    Valor de retorno:   Estado de lectura: 0-Error 1-OK                        *
+*    Parámetros:                                                                *
+*    - datos:  Apuntador a datos a leer desde el arreglo                        *
+*    - addr: Dirección lógica a partir de la cual se desea leer                 *
+*    - len: Cantidad de bytes a leer                                            *
+*    Descripción: Lectura distribuida, página por página                        *
+********************************************************************************/
+external_eeprom_status_t external_eeprom_stripedRead(void *datos, uint32_t addr, uint16_t len)
+{
+    if(len == 0)
+        return EXTERNAL_EEPROM_OK;
+    if( addr+len-1 > _maxAddress)
+        return EXTERNAL_EEPROM_ADDR_ERR;		//Error de direccionamiento, se excede la máxima dirección posible
+
+    uint8_t *p = (uint8_t*)datos;
+    uint8_t control;
+    while(len != 0)
+    {
+        uint32_t pagina = addr / _pageSize;
+        uint16_t offset = (uint16_t)(addr % _pageSize);
+        uint16_t bloque = _pageSize - offset;
+        if(bloque > len)
+            bloque = len;
+        uint8_t dispositivo = (uint8_t)(pagina % _nDevices);
+        uint32_t addr_fisica = (pagina / _nDevices) * _pageSize + offset;
+
+        uint8_t bus = _external_eeprom_stripedSelect(dispositivo, addr_fisica, &control);
+        _external_eeprom_busRestart(bus);                                           //Condición RESTART
+        _external_eeprom_busWriteByte(bus, control | EXTERNAL_EEPROM_ADDRESS_READ); //Byte de control en modo lectura (R/!W = 1)
+        for(uint16_t i = 0; i != bloque; i++)
+            *(p++) = _external_eeprom_busReadByte(bus, (i != (bloque-1))? 1:0);
+        _external_eeprom_busStop(bus);
+
+        addr += bloque;
+        len -= bloque;
+    }
+    return EXTERNAL_EEPROM_OK;
+}
+
+/********************************************************************************
+*    Nombre de función:  external_eeprom_stripedFlush                           *
+*    Valor de retorno:   Ninguno                                                *
+*    Parámetros: Ninguno                                                        *
+*    Descripción: Espera a que todas las memorias del arreglo distribuido       *
+*    terminen su ciclo interno de escritura. Útil antes de apagar el sistema o  *
+*    de entrar en modo SLEEP.                                                   *
+********************************************************************************/
+void external_eeprom_stripedFlush(void)
+{
+    for(uint8_t d = 0; d != _nDevices; d++)
+    {
+        if(!(_stripedBusy & (1U << d)))
+            continue;
+        uint8_t bus = d % _nBuses;
+        uint8_t control = _external_eeprom_stripedControlByte(d / _nBuses, 0);
+        while(true)
+        {
+            _external_eeprom_busStart(bus);
+            i2c_status_t ack = _external_eeprom_busWriteByte(bus, control);
+            _external_eeprom_busStop(bus);
+            if(ack == I2C_ACK)
+                break;
+            __delay_us(5);
+        }
+        _stripedBusy &= ~(1U << d);
+    }
+}
+#endif
@@ -15,6 +15,7 @@
 #include "../../pconfig.h"
 #include "../../peripherals/I2C/i2c.h"
 #include "../../emulated_protocols/I2C_SW/i2c_sw.h"
+#include "../../peripherals/SPI/spi.h"
 
 typedef enum EXTERNAL_EEPROM_METODO_COM_t
 {
@@ -27,9 +28,31 @@ typedef enum EXTERNAL_EEPROM_METODO_COM_t
     Macros para definición de módulo de comunicación con el que se utilizarán las memorias EEPROM. 
     Cambiar según necesidades de la aplicación
 */
-#define EXTERNAL_EEPROM_METODO_COM		EXTERNAL_EEPROM_I2C		//EXTERNAL_EEPROM_I2C o EXTERNAL_EEPROM_SPI
+#define EXTERNAL_EEPROM_METODO_I2C		0						//Valores de EXTERNAL_EEPROM_METODO_COM evaluables por el preprocesador
+#define EXTERNAL_EEPROM_METODO_SPI		1
+#ifndef EXTERNAL_EEPROM_METODO_COM
+#define EXTERNAL_EEPROM_METODO_COM		EXTERNAL_EEPROM_METODO_I2C		//EXTERNAL_EEPROM_METODO_I2C o EXTERNAL_EEPROM_METODO_SPI
+#endif
 #define EXTERNAL_EEPROM_METODO_NUM		1						// 1 o 2
 
+/*
+	Macros de pin de selección (!CS) para memorias EEPROM SPI (series 25XX/25AA/25LC). Cambiar según necesidades de la aplicación.
+	Referencia de rendimiento: con SPI a Fosc/4 (10[MHz] a 40[MHz]) una página de 64 bytes se transfiere en ~60[us], contra
+	~1.5[ms] en I²C a 400[kHz]. El fin del ciclo de escritura se detecta leyendo el bit WIP del registro de estado.
+*/
+#define EXTERNAL_EEPROM_CS			LATCbits.LATC2
+#define EXTERNAL_EEPROM_CS_TRIS		TRISCbits.TRISC2
+
+/*
+	Macros para el modo de escritura distribuida (striping). Las páginas lógicas consecutivas se reparten entre todas las 
+	memorias del arreglo, de modo que mientras una memoria realiza su ciclo interno de escritura (tWC) la siguiente página 
+	se envía a otra memoria. En microcontroladores con dos módulos MSSP (i2c1 e i2c2) pueden utilizarse ambos buses.
+*/
+#if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
+#define EXTERNAL_EEPROM_DOS_BUSES								//Existen dos módulos MSSP disponibles
+#endif
+#define EXTERNAL_EEPROM_MAX_DISPOSITIVOS_BUS	8				//Máximo de memorias por bus (pines A2,A1,A0)
+
 
 /**/
 typedef enum external_eeprom_t {
@@ -41,7 +64,16 @@ typedef enum external_eeprom_t {
 	MICROCHIP_24XX512  	= 5,		//Memoria: 512	Tamaño de página: 128
 	MICROCHIP_24XX1025 	= 6,		//Memoria: 1024	Tamaño de página: 128
 	MICROCHIP_24XX1026 	= 7,		//Memoria: 1024	Tamaño de página: 128
-	ATMEL_AT24CM02	   	= 8			//Memoria: 2048	Tamaño de página: 256
+	ATMEL_AT24CM02	   	= 8,		//Memoria: 2048	Tamaño de página: 256
+	//Memorias SPI
+	MICROCHIP_25XX080	= 9,		//Memoria: 8	Tamaño de página: 16
+	MICROCHIP_25XX160	= 10,		//Memoria: 16	Tamaño de página: 16
+	MICROCHIP_25XX320	= 11,		//Memoria: 32	Tamaño de página: 32
+	MICROCHIP_25XX640	= 12,		//Memoria: 64	Tamaño de página: 32
+	MICROCHIP_25XX128	= 13,		//Memoria: 128	Tamaño de página: 64
+	MICROCHIP_25XX256	= 14,		//Memoria: 256	Tamaño de página: 64
+	MICROCHIP_25XX512	= 15,		//Memoria: 512	Tamaño de página: 128
+	MICROCHIP_25XX1024	= 16		//Memoria: 1024	Tamaño de página: 256
 	//Agregar
 } external_eeprom_t;
 
@@ -64,8 +96,8 @@ typedef enum external_eeprom_size_t {
     kibits_2048 = 2048
 } external_eeprom_size_t;
 
-const uint16_t external_eeprom_capacidad[] = {16,32,64,128,256,512,1024,1024,2048};
-const uint16_t external_eeprom_tamano_pagina[] = {16,32,32,64,64,128,128,128,256};
+const uint16_t external_eeprom_capacidad[] = {16,32,64,128,256,512,1024,1024,2048,8,16,32,64,128,256,512,1024};
+const uint16_t external_eeprom_tamano_pagina[] = {16,32,32,64,64,128,128,128,256,16,16,32,32,64,64,128,256};
 
 /*
 	Enumeración para códigos de estado devueltos por ...
@@ -73,7 +105,8 @@ const uint16_t external_eeprom_tamano_pagina[] = {16,32,32,64,64,128,128,128,256
 typedef enum external_eeprom_status_t {
 	EXTERNAL_EEPROM_ADDR_ERR = 0,
 	EXTERNAL_EEPROM_OK		= 1,
-    EXTERNAL_EEPROM_UNKNOWN_ERROR = 2
+    EXTERNAL_EEPROM_UNKNOWN_ERROR = 2,
+	EXTERNAL_EEPROM_CONFIG_ERR = 3		//Configuración de arreglo no soportada por el tipo de memoria
 	//
 } external_eeprom_status_t;
 
@@ -83,6 +116,15 @@ typedef enum external_eeprom_status_t {
 #define EXTERNAL_EEPROM_ADDRESS_WRITE	0xA0
 #define EXTERNAL_EEPROM_ADDRESS_READ  	0xA1
 
+/*
+	Instrucciones y bits de registro de estado de memorias seriales eeprom SPI
+*/
+#define EXTERNAL_EEPROM_SPI_READ		0x03	//Lectura de datos
+#define EXTERNAL_EEPROM_SPI_WRITE		0x02	//Escritura de datos
+#define EXTERNAL_EEPROM_SPI_WREN		0x06	//Habilitación de escritura
+#define EXTERNAL_EEPROM_SPI_RDSR		0x05	//Lectura de registro de estado
+#define EXTERNAL_EEPROM_SPI_WIP			0x01	//Bit de escritura en progreso (Write In Progress)
+
 /*
 	Prototipos de funciones
 */
@@ -118,6 +160,18 @@ external_eeprom_status_t external_eeprom_write(void *datos, uint32_t addr, uint1
 external_eeprom_status_t external_eeprom_read(void *datos, uint32_t addr, uint16_t len);
 
 
+#if (EXTERNAL_EEPROM_METODO_COM == EXTERNAL_EEPROM_METODO_SPI)
+void external_eeprom_waitReady(void);
+#endif
+
+#if (EXTERNAL_EEPROM_METODO_COM == EXTERNAL_EEPROM_METODO_I2C)
+//Funciones de modo distribuido (striping) entre varias memorias y/o buses
+external_eeprom_status_t external_eeprom_stripedInit(external_eeprom_t tipo_memoria, uint8_t dispositivos_por_bus, uint8_t n_buses);
+external_eeprom_status_t external_eeprom_stripedWrite(const void *datos, uint32_t addr, uint16_t len);
+external_eeprom_status_t external_eeprom_stripedRead(void *datos, uint32_t addr, uint16_t len);
+void external_eeprom_stripedFlush(void);
+#endif
+
 uint32_t external_eeprom_getDeviceCapacity();
 uint32_t external_eeprom_getTotalCapacity();
 uint32_t external_eeprom_getMaxAddress();
@@ -136,5 +190,8 @@ static uint32_t _totalCapacity;	//Capacidad del conjunto de memorias en el bus,
 static uint32_t _maxAddress;	//Última dirección del arrelo de memorias
 static external_eeprom_t _deviceType;	//Tipo de memoria utilizada
 static uint8_t addr_U,addr_H,addr_L;    //Variables de direccionamiento
+static uint8_t _nBuses;			//Cantidad de buses I²C utilizados en modo distribuido (1 o 2)
+static uint16_t _stripedBusy;	//Máscara de memorias en ciclo interno de escritura (bit n = memoria lógica n)
+static bool _spiWriteBusy;		//Escritura SPI pendiente de terminar (bit WIP aún no verificado)
 
 #endif /*EXTERNAL_EEPROM_H*/
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Banco de pruebas en la PC de external_eeprom.c: compara el backend SPI (25XX) con el I²C (24XX, modo distribuido)
+# sobre el modelo de memorias (host/eeprom_modelo.c). Se ejecuta desde cualquier directorio: sh host/banco.sh
+# Termina con error si falla alguna verificación.
+
+set -e
+cd "$(dirname "$0")/.."
+CC="${CC:-gcc}"
+SAL="${TMPDIR:-/tmp}/banco_eeprom"
+mkdir -p "$SAL"
+
+for m in 1 0; do
+	$CC -std=c99 -O2 -I host/stub/lib/pic -DEXTERNAL_EEPROM_METODO_COM=$m -o "$SAL/banco_eeprom" host/banco_eeprom.c \
+		host/eeprom_modelo.c
+	"$SAL/banco_eeprom"
+done
@@ -0,0 +1,126 @@
+/**
+ * @file banco_eeprom.c
+ * @brief Banco de pruebas en la PC de external_eeprom.c sobre el modelo de memorias de eeprom_modelo.c. Con el backend
+ * SPI verifica el manejo del bit WIP (las escrituras retornan sin esperar tWC, sólo se envía RDSR mientras la memoria
+ * escribe, cada WRITE va precedido de WREN y ninguna escritura cruza una página) y la integridad de los datos; con el
+ * backend I²C hace lo mismo con el modo distribuido (ACK polling) sobre 1 y 4 memorias. En ambos casos reporta el
+ * rendimiento de escritura y lectura de 8 KB y de registros de 16 bytes, en tiempo del bus (sin el tiempo de ejecución
+ * del PIC). Se compila desde el directorio EXTERNAL_EEPROM, una vez por backend (ver banco.sh):
+ * gcc -std=c99 -I host/stub/lib/pic -DEXTERNAL_EEPROM_METODO_COM=1 -o banco_eeprom host/banco_eeprom.c host/eeprom_modelo.c
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "eeprom_modelo.h"
+
+/* Nombres anteriores de las constantes, aún usados por las funciones lineales del backend I²C */
+#define EEPROM_EXTERNA_OK				EXTERNAL_EEPROM_OK
+#define EEPROM_EXTERNA_ADDR_ERR			EXTERNAL_EEPROM_ADDR_ERR
+#define EEPROM_EXTERNA_ADDRESS_WRITE	EXTERNAL_EEPROM_ADDRESS_WRITE
+#define EEPROM_EXTERNA_ADDRESS_READ		EXTERNAL_EEPROM_ADDRESS_READ
+
+#include "../external_eeprom.c"		// Las tablas y variables de external_eeprom.h exigen una sola unidad de compilación
+
+#define TOTAL		8192U			// Bytes por medición
+#define REGISTRO	16U
+#define REGISTROS	128U
+
+#if (EXTERNAL_EEPROM_METODO_COM == EXTERNAL_EEPROM_METODO_SPI)
+#define escribir(d, a, n)	external_eeprom_write(d, a, n)
+#define leer(d, a, n)		external_eeprom_read(d, a, n)
+#define terminar()			external_eeprom_waitReady()
+#else
+#define escribir(d, a, n)	external_eeprom_stripedWrite(d, a, n)
+#define leer(d, a, n)		external_eeprom_stripedRead(d, a, n)
+#define terminar()			external_eeprom_stripedFlush()
+#endif
+
+static uint8_t datos[TOTAL], lectura[TOTAL];
+static unsigned fallas;
+
+static void verificar(bool condicion, const char *descripcion)
+{
+	printf("  %s: %s\n", descripcion, condicion ? "ok" : "FALLA");
+	if(!condicion)
+		fallas++;
+}
+
+static void medir(const char *nombre)
+{
+	double t_escritura, t_lectura, t_registros;
+	uint32_t escrituras;
+	uint16_t i;
+	bool iguales;
+
+	for(i = 0; i < TOTAL; i++)
+		datos[i] = (uint8_t)(i * 7 + i / 256);
+
+	// Bloque de 8 KB alineado a página: la escritura retorna antes de que termine el último ciclo tWC
+	eeprom_modelo_reiniciar();
+	escribir(datos, 0, TOTAL);
+	t_escritura = eeprom_modelo_cont.tiempo_us;
+	terminar();
+	verificar(eeprom_modelo_cont.tiempo_us > t_escritura, "Escritura sin esperar el último ciclo interno");
+	t_escritura = eeprom_modelo_cont.tiempo_us;
+	escrituras = eeprom_modelo_cont.escrituras;
+	eeprom_modelo_reiniciar();
+	leer(lectura, 0, TOTAL);
+	t_lectura = eeprom_modelo_cont.tiempo_us;
+	verificar(memcmp(datos, lectura, TOTAL) == 0, "Datos de 8 KB leídos iguales a los escritos");
+	verificar(escrituras == TOTAL / _pageSize, "Un ciclo de escritura por página");
+
+	// Registros de 16 bytes sin alinear: algunos cruzan página y se dividen
+	eeprom_modelo_reiniciar();
+	for(i = 0; i < REGISTROS; i++)
+		escribir(datos + i * REGISTRO, TOTAL + 5 + i * REGISTRO, REGISTRO);
+	terminar();
+	t_registros = eeprom_modelo_cont.tiempo_us;
+	leer(lectura, TOTAL + 5, REGISTROS * REGISTRO);
+	verificar(memcmp(datos, lectura, REGISTROS * REGISTRO) == 0, "Registros leídos iguales a los escritos");
+	verificar(eeprom_modelo_cont.escrituras > REGISTROS, "Registros que cruzan página divididos");
+
+	// Lectura inmediatamente después de una escritura: espera el fin del ciclo interno
+	iguales = true;
+	eeprom_modelo_reiniciar();
+	for(i = 0; i < 4; i++)
+	{
+		datos[0] = (uint8_t)(0xA5 + i);
+		escribir(datos, 20000 + i, 1);
+		leer(lectura, 20000 + i, 1);
+		iguales &= lectura[0] == datos[0];
+	}
+	verificar(iguales && eeprom_modelo_cont.sondeos != 0, "Lectura tras escritura con sondeo de fin de escritura");
+	verificar(eeprom_modelo_cont.violaciones == 0, "Sin instrucciones durante la escritura ni escrituras fuera de página");
+
+	printf("  %s: escritura %.1f KB/s, lectura %.1f KB/s, registros de %u bytes %.0f/s\n", nombre,
+		TOTAL / 1.024 / t_escritura * 1000, TOTAL / 1.024 / t_lectura * 1000, REGISTRO, REGISTROS * 1e6 / t_registros);
+}
+
+int main(void)
+{
+	#if (EXTERNAL_EEPROM_METODO_COM == EXTERNAL_EEPROM_METODO_SPI)
+	printf("Backend SPI\n");
+	eeprom_modelo_init(1);
+	verificar(external_eeprom_init(MICROCHIP_25XX256, 1) == EXTERNAL_EEPROM_OK, "external_eeprom_init");
+	verificar(external_eeprom_init(MICROCHIP_24XX256, 1) == EXTERNAL_EEPROM_CONFIG_ERR, "Memoria I²C rechazada");
+	external_eeprom_init(MICROCHIP_25XX256, 1);
+	medir("25XX256, SPI a 10 MHz");
+	#else
+	uint8_t n;
+
+	printf("Backend I²C (modo distribuido)\n");
+	for(n = 1; n <= 4; n += 3)
+	{
+		char nombre[48];
+
+		eeprom_modelo_init(n);
+		verificar(external_eeprom_stripedInit(MICROCHIP_24XX256, n, 1) == EXTERNAL_EEPROM_OK,
+			"external_eeprom_stripedInit");
+		sprintf(nombre, "%u x 24XX256, I²C a 400 kHz", n);
+		medir(nombre);
+	}
+	#endif
+	return fallas ? 1 : 0;
+}
@@ -0,0 +1,270 @@
+/**
+ * @file eeprom_modelo.c
+ * @brief Modelo en la PC de memorias EEPROM seriales 25XX (SPI) y 24XX (I²C) (ver eeprom_modelo.h)
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include <string.h>
+#include "stub/lib/pic/xc.h"
+#include "stub/peripherals/I2C/i2c.h"
+#include "stub/peripherals/SPI/spi.h"
+#include "eeprom_modelo.h"
+
+#define SPI_WRITE		0x02
+#define SPI_READ		0x03
+#define SPI_RDSR		0x05
+#define SPI_WREN		0x06
+
+eeprom_modelo_memoria_t eeprom_modelo_memoria;
+eeprom_modelo_contadores_t eeprom_modelo_cont;
+uint8_t eeprom_modelo_arreglo[EEPROM_MODELO_MEMORIAS][EEPROM_MODELO_BYTES];
+volatile TRISCbits_t TRISCbits;
+
+static double _ocupado_hasta[EEPROM_MODELO_MEMORIAS];	// Fin del ciclo de escritura de cada memoria
+static uint32_t _addr[EEPROM_MODELO_MEMORIAS];			// Contador de direcciones de cada memoria
+
+/* Memoria SPI (memoria 0) */
+static LATCbits_t _latc = { 1 };
+static bool _abierta, _wel;
+static uint8_t _instruccion;
+static uint16_t _n, _datos;
+
+/* Memorias I²C */
+static enum { I2C_LIBRE, I2C_CONTROL, I2C_DIRECCION, I2C_ESCRITURA, I2C_LECTURA } _estado;
+static uint8_t _memoria;
+
+static bool _ocupada(uint8_t m)
+{
+	return eeprom_modelo_cont.tiempo_us < _ocupado_hasta[m];
+}
+
+static void _escribir(uint8_t m, uint8_t dato)
+{
+	// Escritura en el búfer de página: la dirección da la vuelta dentro de la página, como en la memoria real
+	uint32_t base = _addr[m] - _addr[m] % eeprom_modelo_memoria.pagina;
+
+	if(_addr[m] % eeprom_modelo_memoria.pagina + _datos >= eeprom_modelo_memoria.pagina)
+		eeprom_modelo_cont.violaciones++;
+	eeprom_modelo_arreglo[m][base + (_addr[m] % eeprom_modelo_memoria.pagina + _datos) % eeprom_modelo_memoria.pagina] =
+		dato;
+	_datos++;
+}
+
+static void _iniciar_escritura(uint8_t m)
+{
+	_ocupado_hasta[m] = eeprom_modelo_cont.tiempo_us + eeprom_modelo_memoria.t_escritura_us;
+	eeprom_modelo_cont.escrituras++;
+}
+
+static void _spi_cerrar(void)
+{
+	// Flanco de subida de !CS: termina la instrucción en curso
+	if(!_abierta)
+		return;
+	_abierta = false;
+	if(_instruccion == SPI_WREN)
+		_wel = true;
+	else if(_instruccion == SPI_WRITE && _datos != 0)
+	{
+		_iniciar_escritura(0);
+		_wel = false;
+	}
+}
+
+LATCbits_t *eeprom_modelo_latc(void)
+{
+	// Se llama en cada acceso a !CS; si quedó en alto desde el último, la instrucción terminó
+	if(_latc.LATC2)
+		_spi_cerrar();
+	return &_latc;
+}
+
+uint8_t spi_xmit(uint8_t dato_tx)
+{
+	uint8_t estado;
+
+	eeprom_modelo_cont.tiempo_us += 8e6 / eeprom_modelo_memoria.reloj_spi;
+	eeprom_modelo_cont.bytes++;
+	if(_latc.LATC2)
+	{
+		_spi_cerrar();
+		return 0xFF;							// Memoria sin seleccionar: SO en alta impedancia
+	}
+	if(!_abierta)
+	{
+		_abierta = true;
+		_instruccion = dato_tx;
+		_n = 0;
+		_datos = 0;
+		_addr[0] = 0;
+		if(_ocupada(0) && dato_tx != SPI_RDSR)
+		{
+			eeprom_modelo_cont.violaciones++;	// Durante el ciclo de escritura sólo se atiende RDSR
+			_instruccion = 0;
+		}
+		else if(dato_tx == SPI_WRITE && !_wel)
+		{
+			eeprom_modelo_cont.violaciones++;
+			_instruccion = 0;
+		}
+		return 0xFF;
+	}
+	switch(_instruccion)
+	{
+		case SPI_RDSR:
+			estado = (_ocupada(0) ? 0x01 : 0x00) | (_wel ? 0x02 : 0x00);
+			if(estado & 0x01)
+				eeprom_modelo_cont.sondeos++;
+			return estado;
+		case SPI_READ:
+			if(_n < eeprom_modelo_memoria.bytes_direccion)
+			{
+				_addr[0] = (_addr[0] << 8) | dato_tx;
+				_n++;
+				return 0xFF;
+			}
+			estado = eeprom_modelo_arreglo[0][_addr[0] % eeprom_modelo_memoria.capacidad];
+			_addr[0] = (_addr[0] + 1) % eeprom_modelo_memoria.capacidad;
+			return estado;
+		case SPI_WRITE:
+			if(_n < eeprom_modelo_memoria.bytes_direccion)
+			{
+				_addr[0] = ((_addr[0] << 8) | dato_tx) % eeprom_modelo_memoria.capacidad;
+				_n++;
+			}
+			else
+				_escribir(0, dato_tx);
+			return 0xFF;
+		default:
+			return 0xFF;
+	}
+}
+
+void spi_writeBuffer(const uint8_t *buffer, uint16_t len)
+{
+	while(len--)
+		spi_xmit(*buffer++);
+}
+
+void spi_readBuffer(uint8_t *buffer, uint16_t len)
+{
+	while(len--)
+		*buffer++ = spi_xmit(0xFF);
+}
+
+static void _i2c_bit(double bits)
+{
+	eeprom_modelo_cont.tiempo_us += bits * 1e6 / eeprom_modelo_memoria.reloj_i2c;
+}
+
+void i2c_start(void)
+{
+	_i2c_bit(1);
+	if(_estado == I2C_ESCRITURA && _datos != 0)
+		eeprom_modelo_cont.violaciones++;		// Datos de página descartados por el RESTART
+	_estado = I2C_CONTROL;
+}
+
+void i2c_restart(void)
+{
+	i2c_start();
+}
+
+void i2c_stop(void)
+{
+	_i2c_bit(1);
+	if(_estado == I2C_ESCRITURA && _datos != 0)
+		_iniciar_escritura(_memoria);
+	_estado = I2C_LIBRE;
+}
+
+i2c_status_t i2c_writeByte(uint8_t dato)
+{
+	_i2c_bit(9);
+	eeprom_modelo_cont.bytes++;
+	switch(_estado)
+	{
+		case I2C_CONTROL:
+			// Byte de control 1010 A2 A1 A0 R/!W
+			_memoria = (dato >> 1) & 0x07;
+			if((dato & 0xF0) != 0xA0 || _memoria >= eeprom_modelo_memoria.memorias)
+			{
+				_estado = I2C_LIBRE;
+				return I2C_NACK;
+			}
+			if(_ocupada(_memoria))
+			{
+				eeprom_modelo_cont.sondeos++;
+				_estado = I2C_LIBRE;
+				return I2C_NACK;
+			}
+			if(dato & 0x01)
+				_estado = I2C_LECTURA;
+			else
+			{
+				_estado = I2C_DIRECCION;
+				_n = 0;
+				_datos = 0;
+				_addr[_memoria] = 0;
+			}
+			return I2C_ACK;
+		case I2C_DIRECCION:
+			_addr[_memoria] = ((_addr[_memoria] << 8) | dato) % eeprom_modelo_memoria.capacidad;
+			if(++_n == eeprom_modelo_memoria.bytes_direccion)
+				_estado = I2C_ESCRITURA;
+			return I2C_ACK;
+		case I2C_ESCRITURA:
+			_escribir(_memoria, dato);
+			return I2C_ACK;
+		default:
+			return I2C_NACK;
+	}
+}
+
+uint8_t i2c_readByte(uint8_t ack)
+{
+	uint8_t dato = 0xFF;
+
+	(void)ack;
+	_i2c_bit(9);
+	eeprom_modelo_cont.bytes++;
+	if(_estado == I2C_LECTURA)
+	{
+		dato = eeprom_modelo_arreglo[_memoria][_addr[_memoria]];
+		_addr[_memoria] = (_addr[_memoria] + 1) % eeprom_modelo_memoria.capacidad;
+	}
+	return dato;
+}
+
+void eeprom_modelo_esperar(double us)
+{
+	eeprom_modelo_cont.tiempo_us += us;
+}
+
+void eeprom_modelo_init(uint8_t memorias)
+{
+	eeprom_modelo_memoria.capacidad = 32768UL;
+	eeprom_modelo_memoria.pagina = 64;
+	eeprom_modelo_memoria.bytes_direccion = 2;
+	eeprom_modelo_memoria.memorias = memorias;
+	eeprom_modelo_memoria.reloj_spi = 10e6;
+	eeprom_modelo_memoria.reloj_i2c = 400e3;
+	eeprom_modelo_memoria.t_escritura_us = 5000;
+	memset(eeprom_modelo_arreglo, 0xFF, sizeof eeprom_modelo_arreglo);
+	memset(_ocupado_hasta, 0, sizeof _ocupado_hasta);
+	memset(&eeprom_modelo_cont, 0, sizeof eeprom_modelo_cont);
+	_wel = false;
+	_abierta = false;
+	_latc.LATC2 = 1;
+	_estado = I2C_LIBRE;
+}
+
+void eeprom_modelo_reiniciar(void)
+{
+	uint8_t m;
+
+	for(m = 0; m < EEPROM_MODELO_MEMORIAS; m++)
+		_ocupado_hasta[m] = 0;
+	memset(&eeprom_modelo_cont, 0, sizeof eeprom_modelo_cont);
+}
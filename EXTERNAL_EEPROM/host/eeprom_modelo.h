@@ -0,0 +1,68 @@
+/**
+ * @file eeprom_modelo.h
+ * @brief Modelo en la PC de memorias EEPROM seriales para el banco de pruebas de external_eeprom.c: una memoria SPI de la
+ * serie 25XX (instrucciones WREN, RDSR, READ y WRITE, latch WEL, bit WIP durante el ciclo interno de escritura) detrás de
+ * spi_xmit/spi_writeBuffer/spi_readBuffer y del pin !CS, y hasta 8 memorias I²C 24XX (pines A2,A1,A0) detrás de
+ * i2c_start/i2c_writeByte/..., que no reconocen su byte de control mientras escriben (ACK polling). El modelo lleva el
+ * tiempo del bus (bytes al reloj de cada bus, condiciones START/STOP, retardos) y cuenta los ciclos de escritura, los
+ * sondeos de fin de escritura y los usos indebidos de la memoria. No incluye el tiempo de ejecución del PIC.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef EEPROM_MODELO_H
+#define EEPROM_MODELO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define EEPROM_MODELO_MEMORIAS	8
+#define EEPROM_MODELO_BYTES		32768UL		// Capacidad máxima por memoria (24XX256/25XX256)
+
+/**
+ * @brief Características de las memorias modeladas (todas iguales)
+ */
+typedef struct {
+	uint32_t capacidad;				// Bytes por memoria
+	uint16_t pagina;				// Bytes por página
+	uint8_t bytes_direccion;		// Bytes de dirección después de la instrucción o del byte de control
+	uint8_t memorias;				// Memorias I²C presentes (direcciones 0 a memorias-1)
+	double reloj_spi;				// [Hz]
+	double reloj_i2c;				// [Hz]
+	double t_escritura_us;			// Ciclo interno de escritura (tWC)
+} eeprom_modelo_memoria_t;
+
+/**
+ * @brief Contadores del bus y tiempo acumulado
+ */
+typedef struct {
+	double tiempo_us;				// Tiempo del bus
+	uint32_t bytes;					// Bytes transferidos por el bus
+	uint32_t escrituras;			// Ciclos internos de escritura iniciados
+	uint32_t sondeos;				// Lecturas de estado con WIP = 1 o bytes de control no reconocidos por escritura
+	uint32_t violaciones;			// Instrucciones durante la escritura, WRITE sin WREN, escrituras que cruzan página
+} eeprom_modelo_contadores_t;
+
+extern eeprom_modelo_memoria_t eeprom_modelo_memoria;
+extern eeprom_modelo_contadores_t eeprom_modelo_cont;
+extern uint8_t eeprom_modelo_arreglo[EEPROM_MODELO_MEMORIAS][EEPROM_MODELO_BYTES];
+
+/**
+ * @brief Establece memorias de 32 KB con páginas de 64 bytes (24XX256/25XX256), SPI a 10 MHz, I²C a 400 kHz y tWC de
+ * 5 ms, con el contenido borrado (0xFF)
+ * @param memorias Memorias I²C presentes en el bus
+ */
+void eeprom_modelo_init(uint8_t memorias);
+
+/**
+ * @brief Espera a que terminen las escrituras en curso y pone en cero los contadores y el tiempo
+ */
+void eeprom_modelo_reiniciar(void);
+
+/**
+ * @brief Avanza el tiempo del bus (retardos de la librería)
+ * @param us Tiempo en [us]
+ */
+void eeprom_modelo_esperar(double us);
+
+#endif	/* EEPROM_MODELO_H */
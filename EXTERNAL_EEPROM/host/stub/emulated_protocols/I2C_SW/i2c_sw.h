@@ -0,0 +1,11 @@
+/**
+ * @file i2c_sw.h
+ * @brief Sin I²C por software en el banco de pruebas en la PC
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef I2C_SW_H
+#define I2C_SW_H
+
+#endif	/* I2C_SW_H */
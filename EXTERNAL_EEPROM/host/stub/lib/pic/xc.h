@@ -0,0 +1,32 @@
+/**
+ * @file xc.h
+ * @brief Registros del PIC para compilar external_eeprom.c en la PC. Se incluye con -I host/stub/lib/pic, de modo que
+ * las rutas "../../pconfig.h", "../../utils/utils.h" y "../../peripherals/..." de la librería lleguen a host/stub,
+ * igual que en un proyecto. El pin !CS (LATC2) se accede a través del modelo de la memoria SPI, que así detecta sus
+ * flancos.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef XC_H
+#define XC_H
+
+#include <stdint.h>
+
+typedef uint32_t uint24_t;
+
+typedef struct {
+	unsigned LATC2 : 1;
+} LATCbits_t;
+LATCbits_t *eeprom_modelo_latc(void);
+#define LATCbits			(*eeprom_modelo_latc())
+
+typedef struct {
+	unsigned TRISC2 : 1;
+} TRISCbits_t;
+extern volatile TRISCbits_t TRISCbits;
+
+void eeprom_modelo_esperar(double us);
+#define __delay_us(x)		eeprom_modelo_esperar(x)
+
+#endif	/* XC_H */
@@ -0,0 +1,16 @@
+/**
+ * @file pconfig.h
+ * @brief Configuración del proyecto para compilar el banco de pruebas en la PC (host/banco_eeprom.c): un módulo MSSP
+ * con I²C y SPI (I2C_V1, SPI_V1), como el PIC18F4550
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef PCONFIG_H
+#define PCONFIG_H
+
+#define _XTAL_FREQ		40000000UL
+#define I2C_V1
+#define SPI_V1
+
+#endif	/* PCONFIG_H */
@@ -0,0 +1,25 @@
+/**
+ * @file i2c.h
+ * @brief Funciones de i2c.c (I2C_V1) implementadas por el modelo de memorias 24XX de host/eeprom_modelo.c
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef I2C_H
+#define I2C_H
+
+#include <stdint.h>
+
+typedef enum i2c_status_t {
+	I2C_ACK  				= 0,	// Acknowledge
+	I2C_NACK 				= 1,	// No Acknowledge
+	I2C_TIMEOUT				= 2
+} i2c_status_t;
+
+void i2c_start(void);
+void i2c_stop(void);
+void i2c_restart(void);
+i2c_status_t i2c_writeByte(uint8_t dato);
+uint8_t i2c_readByte(uint8_t ack);
+
+#endif	/* I2C_H */
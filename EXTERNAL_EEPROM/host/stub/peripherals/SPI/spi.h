@@ -0,0 +1,17 @@
+/**
+ * @file spi.h
+ * @brief Funciones de spi.c (SPI_V1) implementadas por el modelo de memorias 25XX de host/eeprom_modelo.c
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef SPI_H
+#define SPI_H
+
+#include <stdint.h>
+
+uint8_t spi_xmit(uint8_t dato_tx);
+void spi_writeBuffer(const uint8_t *buffer, uint16_t len);
+void spi_readBuffer(uint8_t *buffer, uint16_t len);
+
+#endif	/* SPI_H */
@@ -7,12 +7,33 @@
 
 #include "i2c.h"
 
+/*
+    Cálculo de registro SSPxADD para la velocidad deseada en [kHz]. Se redondea hacia arriba para que la velocidad real 
+    nunca exceda la solicitada, y se acota a los límites del generador de baud rate.
+*/
+static uint8_t _i2c_calculaSSPADD(uint16_t speed) {
+    uint32_t divisor = 4000UL*(uint32_t)((speed != 0)? speed:100);
+    uint32_t n = (_XTAL_FREQ + divisor - 1)/divisor;
+    if(n < I2C_SSPADD_MIN + 1)
+        n = I2C_SSPADD_MIN + 1;
+    if(n > I2C_SSPADD_MAX + 1)
+        n = I2C_SSPADD_MAX + 1;
+    return (uint8_t)(n - 1);
+}
+
+/*
+    Velocidad real del bus en [kHz] obtenida con un valor de SSPxADD
+*/
+static uint16_t _i2c_velocidadReal(uint8_t sspadd) {
+    return (uint16_t)(_XTAL_FREQ/(4000UL*((uint32_t)sspadd + 1)));
+}
+
 
 /*
     Funciones de configuración de modo i2c por hardware.
     Parámetros: 
     - opciones_sspcon: Configuración de modo maestro o esclavo ya sea de 7 o 10 bits de direccionamiento
-    - opciones_slew_rate: Control de slew-rate para velocidad de 400 [kHz]
+    - opciones_slew_rate: Control de slew-rate para velocidad de 400 [kHz]. Con I2C_SLEW_AUTO se configura según la velocidad del bus
     - opciones_sspadd: 
         + En modo maestro, velocidad de reloj en [kHz]. Opciones comunes: 100, 400 y 1000
         + En modo esclavo, dirección deseada del dispositivo esclavo
@@ -31,7 +52,8 @@ void i2c_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate, uint16_t opci
             SSPADD = (uint8_t)opciones_sspadd;   //Simplemente establece dirección deseada de dispositivo esclavo
             break;
     }   
-    SSPSTAT |= opciones_slew_rate;        //Configura control de slew-rate 
+    if(opciones_slew_rate != I2C_SLEW_AUTO)     //En modo automático, i2cx_setSpeed configura el slew-rate
+        SSPSTATbits.SMP = (opciones_slew_rate == I2C_SLEW_OFF)? 1:0;    //Configura control de slew-rate 
     //Configuración de pines SDA y SCL
     I2C_SCL_TRIS = 1;
     I2C_SDA_TRIS = 1;
@@ -53,7 +75,8 @@ void i2c_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate, uint16_t opci
             SSPADD = (uint8_t)opciones_sspadd;   //Simplemente establece dirección deseada de dispositivo esclavo
             break;
     }   
-    SSPSTAT |= opciones_slew_rate;        //Configura control de slew-rate 
+    if(opciones_slew_rate != I2C_SLEW_AUTO)     //En modo automático, i2cx_setSpeed configura el slew-rate
+        SSPSTATbits.SMP = (opciones_slew_rate == I2C_SLEW_OFF)? 1:0;    //Configura control de slew-rate 
     //Configuración de pines SDA y SCL
     I2C_SCL_TRIS = 1;
     I2C_SDA_TRIS = 1;
@@ -75,7 +98,8 @@ void i2c1_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate, uint16_t opc
             SSP1ADD = (uint8_t)opciones_sspadd;   //Simplemente establece dirección deseada de dispositivo esclavo
             break;
     }   
-    SSP1STAT |= opciones_slew_rate;        //Configura control de slew-rate 
+    if(opciones_slew_rate != I2C_SLEW_AUTO)     //En modo automático, i2cx_setSpeed configura el slew-rate
+        SSP1STATbits.SMP = (opciones_slew_rate == I2C_SLEW_OFF)? 1:0;    //Configura control de slew-rate 
     //Configuración de pines SDA y SCL
     I2C1_SCL_TRIS = 1;
     I2C1_SDA_TRIS = 1;
@@ -98,7 +122,8 @@ void i2c1_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate, uint16_t opc
             SSP1ADD = (uint8_t)opciones_sspadd;   //Simplemente establece dirección deseada de dispositivo esclavo
             break;
     }   
-    SSP1STAT |= opciones_slew_rate;        //Configura control de slew-rate 
+    if(opciones_slew_rate != I2C_SLEW_AUTO)     //En modo automático, i2cx_setSpeed configura el slew-rate
+        SSP1STATbits.SMP = (opciones_slew_rate == I2C_SLEW_OFF)? 1:0;    //Configura control de slew-rate 
     I2C1_SCL_TRIS = 1;
     I2C1_SDA_TRIS = 1;
     SSP1CON1bits.SSPEN=1;   //Habilita el MSSP y usa los pines correspondintes como SDA y SCL. Habilita el hardware i2c 
@@ -108,7 +133,7 @@ void i2c1_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate, uint16_t opc
 #endif
 
 #if defined (I2C_V3)
-void i2c2_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate) {
+void i2c2_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate, uint16_t opciones_sspadd) {
     SSP2STAT &= 0x3F;        //Estado en power-on
     SSP2CON1 = 0x00;         //Estado en power-on
     SSP2CON2 = 0x00;         //Estado en power-on
@@ -121,7 +146,8 @@ void i2c2_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate) {
             SSP2ADD = (uint8_t)opciones_sspadd;   //Simplemente establece dirección deseada de dispositivo esclavo
             break;
     }   
-    SSP2STAT |= opciones_slew_rate;        //Configura control de slew-rate 
+    if(opciones_slew_rate != I2C_SLEW_AUTO)     //En modo automático, i2cx_setSpeed configura el slew-rate
+        SSP2STATbits.SMP = (opciones_slew_rate == I2C_SLEW_OFF)? 1:0;    //Configura control de slew-rate 
     //Configuración de pines SDA y SCL
     I2C2_SCL_TRIS = 1;
     I2C2_SDA_TRIS = 1;
@@ -143,7 +169,8 @@ void i2c2_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate, uint16_t opc
             SSP2ADD = (uint8_t)opciones_sspadd;   //Simplemente establece dirección deseada de dispositivo esclavo
             break;
     }   
-    SSP2STAT |= opciones_slew_rate;        //Configura control de slew-rate 
+    if(opciones_slew_rate != I2C_SLEW_AUTO)     //En modo automático, i2cx_setSpeed configura el slew-rate
+        SSP2STATbits.SMP = (opciones_slew_rate == I2C_SLEW_OFF)? 1:0;    //Configura control de slew-rate 
     //Configuración de pines SDA y SCL
     I2C2_SCL_TRIS = 1;
     I2C2_SDA_TRIS = 1;
@@ -595,9 +622,11 @@ void i2c2_disable() {
 #endif
 
 #if defined (I2C_V1) || defined (I2C_V4)
-void i2c_setSpeed(uint16_t speed){
-    SSPADD = (uint8_t)(division_entera_sin_signo(_XTAL_FREQ,4*(uint32_t)(speed)*1000UL)-1); //Calcula registro SSPxADD con base en baud_rate_requerido en [kHz]
-    i2c_speed = speed;
+uint16_t i2c_setSpeed(uint16_t speed){
+    SSPADD = _i2c_calculaSSPADD(speed);                 //Calcula registro SSPADD con base en velocidad requerida en [kHz]
+    SSPSTATbits.SMP = (I2C_SLEW_PARA(speed) == I2C_SLEW_OFF)? 1:0;   //Slew-rate según modo estándar, rápido o rápido plus
+    i2c_speed = _i2c_velocidadReal(SSPADD);                  //Velocidad real obtenida
+    return i2c_speed;
 }
 
 uint16_t i2c_getSpeed(void){
@@ -606,9 +635,11 @@ uint16_t i2c_getSpeed(void){
 #endif
 
 #if defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
-void i2c1_setSpeed(uint16_t speed){
-    SSP1ADD = (uint8_t)(division_entera_sin_signo(_XTAL_FREQ,4*(uint32_t)(speed)*1000UL)-1); //Calcula registro SSPxADD con base en baud_rate_requerido en [kHz]
-    i2c1_speed = speed;
+uint16_t i2c1_setSpeed(uint16_t speed){
+    SSP1ADD = _i2c_calculaSSPADD(speed);                 //Calcula registro SSP1ADD con base en velocidad requerida en [kHz]
+    SSP1STATbits.SMP = (I2C_SLEW_PARA(speed) == I2C_SLEW_OFF)? 1:0;   //Slew-rate según modo estándar, rápido o rápido plus
+    i2c1_speed = _i2c_velocidadReal(SSP1ADD);                  //Velocidad real obtenida
+    return i2c1_speed;
 }
 
 uint16_t i2c1_getSpeed(void){
@@ -617,9 +648,11 @@ uint16_t i2c1_getSpeed(void){
 #endif
 
 #if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
-void i2c2_setSpeed(uint16_t speed){
-    SSP2ADD = (uint8_t)(division_entera_sin_signo(_XTAL_FREQ,4*(uint32_t)(speed)*1000UL)-1); //Calcula registro SSPxADD con base en baud_rate_requerido en [kHz]
-    i2c2_speed = speed;
+uint16_t i2c2_setSpeed(uint16_t speed){
+    SSP2ADD = _i2c_calculaSSPADD(speed);                 //Calcula registro SSP2ADD con base en velocidad requerida en [kHz]
+    SSP2STATbits.SMP = (I2C_SLEW_PARA(speed) == I2C_SLEW_OFF)? 1:0;   //Slew-rate según modo estándar, rápido o rápido plus
+    i2c2_speed = _i2c_velocidadReal(SSP2ADD);                  //Velocidad real obtenida
+    return i2c2_speed;
 }
 
 uint16_t i2c2_getSpeed(void){
@@ -627,5 +660,94 @@ uint16_t i2c2_getSpeed(void){
 }
 #endif
 
+/*
+    Funciones de negociación de velocidad de dispositivos. Se prueba el dispositivo a cada velocidad candidata 
+    (I2C_VELOCIDADES_NEGOCIACION, de mayor a menor) verificando el ACK de su dirección en dos intentos consecutivos.
+    Parámetros:
+    - direccion: Dirección de 7 bits del dispositivo esclavo
+    Retorno: Velocidad candidata (solicitada, no la real) más alta en [kHz] a la que respondió el dispositivo, o 0 si no
+    respondió a ninguna.
+    Nota: Al terminar se restaura la configuración previa del bus (SSPxADD, SMP y velocidad registrada) sin recalcularla;
+    la aplicación debe llamar a i2cx_setSpeed con el valor obtenido antes de acceder al dispositivo. La velocidad real
+    ya es la redondeada hacia abajo, por lo que volver a pasarla a i2cx_setSpeed daría una velocidad menor.
+*/
+#if defined (I2C_V1)
+uint16_t i2c_probeSpeed(uint8_t direccion) {
+    const uint16_t candidatas[] = I2C_VELOCIDADES_NEGOCIACION;
+    uint8_t sspadd_previo = SSPADD;
+    uint8_t smp_previo = SSPSTATbits.SMP;
+    uint16_t velocidad_previa = i2c_speed;
+    uint16_t resultado = 0;
+    for(uint8_t i = 0; i != sizeof(candidatas)/sizeof(candidatas[0]) && resultado == 0; i++) {
+        i2c_setSpeed(candidatas[i]);
+        uint8_t intento;
+        for(intento = 0; intento != 2; intento++) {
+            i2c_start();
+            i2c_status_t ack = i2c_writeByte((uint8_t)(direccion << 1));
+            i2c_stop();
+            if(ack != I2C_ACK)
+                break;
+        }
+        if(intento == 2)
+            resultado = candidatas[i];
+    }
+    SSPADD = sspadd_previo;
+    SSPSTATbits.SMP = smp_previo;
+    i2c_speed = velocidad_previa;
+    return resultado;
+}
+#endif
 
+#if defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
+uint16_t i2c1_probeSpeed(uint8_t direccion) {
+    const uint16_t candidatas[] = I2C_VELOCIDADES_NEGOCIACION;
+    uint8_t sspadd_previo = SSP1ADD;
+    uint8_t smp_previo = SSP1STATbits.SMP;
+    uint16_t velocidad_previa = i2c1_speed;
+    uint16_t resultado = 0;
+    for(uint8_t i = 0; i != sizeof(candidatas)/sizeof(candidatas[0]) && resultado == 0; i++) {
+        i2c1_setSpeed(candidatas[i]);
+        uint8_t intento;
+        for(intento = 0; intento != 2; intento++) {
+            i2c1_start();
+            i2c_status_t ack = i2c1_writeByte((uint8_t)(direccion << 1));
+            i2c1_stop();
+            if(ack != I2C_ACK)
+                break;
+        }
+        if(intento == 2)
+            resultado = candidatas[i];
+    }
+    SSP1ADD = sspadd_previo;
+    SSP1STATbits.SMP = smp_previo;
+    i2c1_speed = velocidad_previa;
+    return resultado;
+}
+#endif
 
+#if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
+uint16_t i2c2_probeSpeed(uint8_t direccion) {
+    const uint16_t candidatas[] = I2C_VELOCIDADES_NEGOCIACION;
+    uint8_t sspadd_previo = SSP2ADD;
+    uint8_t smp_previo = SSP2STATbits.SMP;
+    uint16_t velocidad_previa = i2c2_speed;
+    uint16_t resultado = 0;
+    for(uint8_t i = 0; i != sizeof(candidatas)/sizeof(candidatas[0]) && resultado == 0; i++) {
+        i2c2_setSpeed(candidatas[i]);
+        uint8_t intento;
+        for(intento = 0; intento != 2; intento++) {
+            i2c2_start();
+            i2c_status_t ack = i2c2_writeByte((uint8_t)(direccion << 1));
+            i2c2_stop();
+            if(ack != I2C_ACK)
+                break;
+        }
+        if(intento == 2)
+            resultado = candidatas[i];
+    }
+    SSP2ADD = sspadd_previo;
+    SSP2STATbits.SMP = smp_previo;
+    i2c2_speed = velocidad_previa;
+    return resultado;
+}
+#endif
@@ -22,7 +22,8 @@ typedef enum i2c_status_t {
 	I2C_WRITE_COLLISION		= -1,	// Error de colisión WCOL
 	I2C_ACK  				= 0,	// Acknowledge
 	I2C_NACK 				= 1,	// No Acknowledge
-	I2C_TIMEOUT				= 2		// Timeout en la comunicación I²C
+	I2C_TIMEOUT				= 2,	// Timeout en la comunicación I²C
+	I2C_BUS_COLLISION		= 3		// Colisión de bus BCLxIF (arbitraje perdido o línea retenida)
 } i2c_status_t;
 
 /**
@@ -95,6 +96,41 @@ static uint16_t i2c2_speed;
 */
 #define   I2C_SLEW_OFF  			0b10000000  	// Slew rate deshabilitado, para modo de 100[kHz]
 #define   I2C_SLEW_ON   			0b00000000  	// Slew rate habilitado, para modo de 400[kHz]
+#define   I2C_SLEW_AUTO 			0b00000001  	// Slew rate seleccionado automáticamente según la velocidad del bus (solo modo maestro)
+
+/**
+ * Límites de registro SSPxADD en modo maestro. Los valores 0, 1 y 2 no están soportados por el generador de baud rate.
+*/
+#define   I2C_SSPADD_MIN			3
+#define   I2C_SSPADD_MAX			255
+
+/**
+ * Macros de cálculo en tiempo de compilación a partir de _XTAL_FREQ y la velocidad deseada en [kHz].
+ * El valor de SSPxADD se redondea hacia arriba, de modo que la velocidad real nunca excede la solicitada.
+ * - I2C_SSPADD(f_khz): Valor de SSPxADD (sin acotar)
+ * - I2C_VELOCIDAD_REAL(f_khz): Velocidad real obtenida en [kHz]
+ * - I2C_SLEW_PARA(f_khz): Control de slew rate adecuado: habilitado en modo rápido (400[kHz]), deshabilitado 
+ *   en modo estándar (100[kHz]) y en modo rápido plus (1[MHz])
+*/
+#define   I2C_SSPADD(f_khz)				((((_XTAL_FREQ) + 4000UL*(f_khz) - 1) / (4000UL*(f_khz))) - 1)
+#define   I2C_VELOCIDAD_REAL(f_khz)		((_XTAL_FREQ) / (4000UL*(I2C_SSPADD(f_khz) + 1)))
+#define   I2C_SLEW_PARA(f_khz)			((((f_khz) > 100) && ((f_khz) < 1000))? I2C_SLEW_ON:I2C_SLEW_OFF)
+
+/**
+ * Validación en tiempo de compilación de la velocidad del bus, si la aplicación define I2C_VELOCIDAD_KHZ (p. ej. en pconfig.h)
+*/
+#if defined (I2C_VELOCIDAD_KHZ)
+#if (I2C_SSPADD(I2C_VELOCIDAD_KHZ) < I2C_SSPADD_MIN)
+#error "I2C_VELOCIDAD_KHZ demasiado alta para _XTAL_FREQ (SSPxADD < 3)"
+#elif (I2C_SSPADD(I2C_VELOCIDAD_KHZ) > I2C_SSPADD_MAX)
+#error "I2C_VELOCIDAD_KHZ demasiado baja para _XTAL_FREQ (SSPxADD > 255)"
+#endif
+#endif
+
+/**
+ * Velocidades candidatas para negociación de velocidad de dispositivos, en [kHz], de mayor a menor
+*/
+#define   I2C_VELOCIDADES_NEGOCIACION	{1000, 400, 100}
 
 /**
  * Prototipos de funciones
@@ -112,10 +148,19 @@ void i2c_writeInt16(uint16_t dato);
 void i2c_writeInt24(uint24_t dato);
 void i2c_writeInt32(uint32_t dato);
 void i2c_writeFloat(float dato);
-void i2c_setSpeed(uint16_t speed);
+uint16_t i2c_setSpeed(uint16_t speed);
 uint16_t i2c_getSpeed(void);
 #endif
 
+/*
+    El MSSP de I2C_V4 no genera condiciones START/STOP ni reporta el ACK del esclavo: sin negociación de velocidad.
+    i2cx_probeSpeed devuelve la velocidad candidata solicitada (de I2C_VELOCIDADES_NEGOCIACION), no la real, para
+    pasarla tal cual a i2cx_setSpeed; i2cx_setSpeed e i2cx_getSpeed devuelven la velocidad real.
+*/
+#if defined (I2C_V1)
+uint16_t i2c_probeSpeed(uint8_t direccion);
+#endif
+
 #if defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
 void i2c1_init(uint8_t opciones_sspcon, uint8_t opciones_slew_rate, uint16_t opciones_sspadd);
 void i2c1_start(void);
@@ -129,8 +174,9 @@ void i2c1_writeInt16(uint16_t dato);
 void i2c1_writeInt24(uint24_t dato);
 void i2c1_writeInt32(uint32_t dato);
 void i2c1_writeFloat(float dato);
-void i2c1_setSpeed(uint16_t speed);
+uint16_t i2c1_setSpeed(uint16_t speed);
 uint16_t i2c1_getSpeed(void);
+uint16_t i2c1_probeSpeed(uint8_t direccion);
 #endif
 
 #if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
@@ -146,8 +192,9 @@ void i2c2_writeInt16(uint16_t dato);
 void i2c2_writeInt24(uint24_t dato);
 void i2c2_writeInt32(uint32_t dato);
 void i2c2_writeFloat(float dato);
-void i2c2_setSpeed(uint16_t speed);
+uint16_t i2c2_setSpeed(uint16_t speed);
 uint16_t i2c2_getSpeed(void);
+uint16_t i2c2_probeSpeed(uint8_t direccion);
 #endif
 
 #endif	/* I2C_H */
@@ -0,0 +1,424 @@
+/**
+ * @file i2c_async.c
+ * @brief Motor de transacciones I²C maestro por interrupciones, con cola de transferencias no bloqueantes, para microcontroladores PIC de 8 bits.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "i2c_async.h"
+
+/*
+    Operaciones de hardware sobre el módulo MSSP, usadas por la máquina de estados
+*/
+#define I2C_ASYNC_OP_SEN        0   // Genera condición START
+#define I2C_ASYNC_OP_RSEN       1   // Genera condición RESTART
+#define I2C_ASYNC_OP_PEN        2   // Genera condición STOP
+#define I2C_ASYNC_OP_RCEN       3   // Habilita recepción de un byte
+#define I2C_ASYNC_OP_ACKEN      4   // Genera secuencia ACK (dato = 0) o NACK (dato = 1)
+#define I2C_ASYNC_OP_WRITE      5   // Escribe un byte en SSPxBUF
+#define I2C_ASYNC_OP_READ       6   // Lee SSPxBUF
+#define I2C_ASYNC_OP_ACKSTAT    7   // Lee bit ACKSTAT (0-ACK 1-NACK)
+#define I2C_ASYNC_OP_IE_ON      8   // Habilita interrupciones del MSSP y de colisión de bus
+#define I2C_ASYNC_OP_IE_OFF     9   // Deshabilita interrupciones del MSSP y de colisión de bus
+#define I2C_ASYNC_OP_BCL        10  // Lee y limpia la bandera de colisión de bus BCLxIF
+#define I2C_ASYNC_OP_RESET      11  // Reinicia el MSSP: cancela la condición o byte en curso y libera SCL/SDA
+
+/*
+    Contexto de cada bus: cola de transacciones y estado de la transacción en curso
+*/
+typedef struct i2c_async_ctx_t {
+    i2c_transaccion_t * volatile cabeza;    // Transacción en curso (frente de la cola)
+    i2c_transaccion_t * volatile cola;      // Última transacción en cola
+    volatile i2c_async_estado_t estado;     // Estado de la máquina de estados
+    uint8_t indice;                         // Índice de byte en curso (tx o rx)
+    volatile uint8_t ticks;                 // Ticks transcurridos desde el último evento del MSSP
+} i2c_async_ctx_t;
+
+static i2c_async_ctx_t _i2c_async_ctx[I2C_ASYNC_N_BUSES];
+
+#if defined (I2C_V1)
+static uint8_t _i2c_async_hw0(uint8_t op, uint8_t dato)
+{
+    switch(op)
+    {
+        case I2C_ASYNC_OP_SEN:      SSPCON2bits.SEN = 1;    break;
+        case I2C_ASYNC_OP_RSEN:     SSPCON2bits.RSEN = 1;   break;
+        case I2C_ASYNC_OP_PEN:      SSPCON2bits.PEN = 1;    break;
+        case I2C_ASYNC_OP_RCEN:     SSPCON2bits.RCEN = 1;   break;
+        case I2C_ASYNC_OP_ACKEN:    SSPCON2bits.ACKDT = dato; SSPCON2bits.ACKEN = 1;    break;
+        case I2C_ASYNC_OP_WRITE:    SSPBUF = dato;          break;
+        case I2C_ASYNC_OP_READ:     return SSPBUF;
+        case I2C_ASYNC_OP_ACKSTAT:  return SSPCON2bits.ACKSTAT;
+        case I2C_ASYNC_OP_IE_ON:    SSPIE = 1; BCLIE = 1;    break;
+        case I2C_ASYNC_OP_IE_OFF:   SSPIE = 0; BCLIE = 0;    break;
+        case I2C_ASYNC_OP_BCL:      if(!BCLIF) return 0; BCLIF = 0; return 1;
+        case I2C_ASYNC_OP_RESET:    SSPCON1bits.SSPEN = 0; SSPCON2 &= 0xE0; SSPIF = 0; BCLIF = 0; SSPCON1bits.SSPEN = 1;  break;
+        default: break;
+    }
+    return 0;
+}
+#elif defined (I2C_ASYNC_BUS0)
+static uint8_t _i2c_async_hw0(uint8_t op, uint8_t dato)
+{
+    switch(op)
+    {
+        case I2C_ASYNC_OP_SEN:      SSP1CON2bits.SEN = 1;   break;
+        case I2C_ASYNC_OP_RSEN:     SSP1CON2bits.RSEN = 1;  break;
+        case I2C_ASYNC_OP_PEN:      SSP1CON2bits.PEN = 1;   break;
+        case I2C_ASYNC_OP_RCEN:     SSP1CON2bits.RCEN = 1;  break;
+        case I2C_ASYNC_OP_ACKEN:    SSP1CON2bits.ACKDT = dato; SSP1CON2bits.ACKEN = 1;  break;
+        case I2C_ASYNC_OP_WRITE:    SSP1BUF = dato;         break;
+        case I2C_ASYNC_OP_READ:     return SSP1BUF;
+        case I2C_ASYNC_OP_ACKSTAT:  return SSP1CON2bits.ACKSTAT;
+        case I2C_ASYNC_OP_IE_ON:    SSP1IE = 1; BCL1IE = 1;    break;
+        case I2C_ASYNC_OP_IE_OFF:   SSP1IE = 0; BCL1IE = 0;    break;
+        case I2C_ASYNC_OP_BCL:      if(!BCL1IF) return 0; BCL1IF = 0; return 1;
+        case I2C_ASYNC_OP_RESET:    SSP1CON1bits.SSPEN = 0; SSP1CON2 &= 0xE0; SSP1IF = 0; BCL1IF = 0; SSP1CON1bits.SSPEN = 1;  break;
+        default: break;
+    }
+    return 0;
+}
+#endif
+
+#if defined (I2C_ASYNC_BUS1)
+static uint8_t _i2c_async_hw1(uint8_t op, uint8_t dato)
+{
+    switch(op)
+    {
+        case I2C_ASYNC_OP_SEN:      SSP2CON2bits.SEN = 1;   break;
+        case I2C_ASYNC_OP_RSEN:     SSP2CON2bits.RSEN = 1;  break;
+        case I2C_ASYNC_OP_PEN:      SSP2CON2bits.PEN = 1;   break;
+        case I2C_ASYNC_OP_RCEN:     SSP2CON2bits.RCEN = 1;  break;
+        case I2C_ASYNC_OP_ACKEN:    SSP2CON2bits.ACKDT = dato; SSP2CON2bits.ACKEN = 1;  break;
+        case I2C_ASYNC_OP_WRITE:    SSP2BUF = dato;         break;
+        case I2C_ASYNC_OP_READ:     return SSP2BUF;
+        case I2C_ASYNC_OP_ACKSTAT:  return SSP2CON2bits.ACKSTAT;
+        case I2C_ASYNC_OP_IE_ON:    SSP2IE = 1; BCL2IE = 1;    break;
+        case I2C_ASYNC_OP_IE_OFF:   SSP2IE = 0; BCL2IE = 0;    break;
+        case I2C_ASYNC_OP_BCL:      if(!BCL2IF) return 0; BCL2IF = 0; return 1;
+        case I2C_ASYNC_OP_RESET:    SSP2CON1bits.SSPEN = 0; SSP2CON2 &= 0xE0; SSP2IF = 0; BCL2IF = 0; SSP2CON1bits.SSPEN = 1;  break;
+        default: break;
+    }
+    return 0;
+}
+#endif
+
+static uint8_t _i2c_async_hw(uint8_t bus, uint8_t op, uint8_t dato)
+{
+#if defined (I2C_ASYNC_BUS1)
+    if(bus)
+        return _i2c_async_hw1(op, dato);
+#endif
+    return _i2c_async_hw0(op, dato);
+}
+
+/*
+    Inicio de la transacción al frente de la cola. Debe llamarse con la interrupción del MSSP deshabilitada o desde ésta.
+*/
+static void _i2c_async_begin(uint8_t bus)
+{
+    i2c_async_ctx_t *ctx = &_i2c_async_ctx[bus];
+    if(ctx->cabeza == NULL)
+    {
+        ctx->estado = I2C_ASYNC_IDLE;
+        return;
+    }
+    ctx->indice = 0;
+    ctx->ticks = 0;
+    ctx->estado = I2C_ASYNC_START;
+    _i2c_async_hw(bus, I2C_ASYNC_OP_SEN, 0);
+}
+
+/*
+    Fin de la transacción en curso: notificación al usuario y arranque de la siguiente en cola
+*/
+static void _i2c_async_finish(uint8_t bus)
+{
+    i2c_async_ctx_t *ctx = &_i2c_async_ctx[bus];
+    i2c_transaccion_t *t = ctx->cabeza;
+    ctx->cabeza = t->siguiente;
+    if(ctx->cabeza == NULL)
+        ctx->cola = NULL;
+    t->terminada = true;
+    if(t->callback != NULL)
+        t->callback(t);
+    _i2c_async_begin(bus);
+}
+
+/*
+    Aborto de la transacción en curso por colisión de bus o timeout: reinicio del MSSP, notificación al usuario con el
+    código de error y arranque de la siguiente en cola
+*/
+static void _i2c_async_abort(uint8_t bus, i2c_status_t error)
+{
+    i2c_async_ctx_t *ctx = &_i2c_async_ctx[bus];
+    _i2c_async_hw(bus, I2C_ASYNC_OP_RESET, 0);
+    if(ctx->cabeza == NULL)
+    {
+        ctx->estado = I2C_ASYNC_IDLE;
+        return;
+    }
+    ctx->cabeza->resultado = error;
+    _i2c_async_finish(bus);
+}
+
+static void _i2c_async_init(uint8_t bus)
+{
+    _i2c_async_hw(bus, I2C_ASYNC_OP_IE_OFF, 0);
+    _i2c_async_ctx[bus].cabeza = NULL;
+    _i2c_async_ctx[bus].cola = NULL;
+    _i2c_async_ctx[bus].estado = I2C_ASYNC_IDLE;
+    _i2c_async_hw(bus, I2C_ASYNC_OP_BCL, 0);
+    _i2c_async_hw(bus, I2C_ASYNC_OP_IE_ON, 0);
+}
+
+static bool _i2c_async_enqueue(uint8_t bus, i2c_transaccion_t *t)
+{
+    if(t == NULL || (t->n_tx != 0 && t->datos_tx == NULL) || (t->n_rx != 0 && t->datos_rx == NULL))
+        return false;
+    t->terminada = false;
+    t->resultado = I2C_ACK;
+    t->siguiente = NULL;
+
+    i2c_async_ctx_t *ctx = &_i2c_async_ctx[bus];
+    _i2c_async_hw(bus, I2C_ASYNC_OP_IE_OFF, 0);    //Sección crítica respecto a la interrupción del MSSP
+    if(ctx->cola == NULL)
+        ctx->cabeza = t;
+    else
+        ctx->cola->siguiente = t;
+    ctx->cola = t;
+    if(ctx->estado == I2C_ASYNC_IDLE)
+        _i2c_async_begin(bus);
+    _i2c_async_hw(bus, I2C_ASYNC_OP_IE_ON, 0);
+    return true;
+}
+
+/*
+    Timeout: sin eventos del MSSP durante I2C_ASYNC_TIMEOUT ticks (esclavo que retiene SCL, evento perdido) se aborta la
+    transacción en curso. Sección crítica respecto a la interrupción del MSSP.
+*/
+static void _i2c_async_tick(uint8_t bus)
+{
+    i2c_async_ctx_t *ctx = &_i2c_async_ctx[bus];
+    if(ctx->estado == I2C_ASYNC_IDLE)
+        return;
+    _i2c_async_hw(bus, I2C_ASYNC_OP_IE_OFF, 0);
+    if(ctx->estado != I2C_ASYNC_IDLE && ++ctx->ticks >= I2C_ASYNC_TIMEOUT)
+        _i2c_async_abort(bus, I2C_TIMEOUT);
+    _i2c_async_hw(bus, I2C_ASYNC_OP_IE_ON, 0);
+}
+
+/*
+    Máquina de estados. Cada evento del MSSP (fin de START/RESTART/STOP, fin de byte transmitido con su ACK, 
+    byte recibido y fin de secuencia ACK) avanza un paso. Una colisión de bus aborta la transacción en curso.
+*/
+static void _i2c_async_step(uint8_t bus)
+{
+    i2c_async_ctx_t *ctx = &_i2c_async_ctx[bus];
+    i2c_transaccion_t *t = ctx->cabeza;
+    if(_i2c_async_hw(bus, I2C_ASYNC_OP_BCL, 0))
+    {
+        _i2c_async_abort(bus, I2C_BUS_COLLISION);
+        return;
+    }
+    if(t == NULL)
+        return;
+    ctx->ticks = 0;
+    switch(ctx->estado)
+    {
+        case I2C_ASYNC_START:
+            if(t->n_tx != 0 || t->n_rx == 0)
+            {
+                _i2c_async_hw(bus, I2C_ASYNC_OP_WRITE, (uint8_t)(t->direccion << 1));          //Dirección en modo escritura
+                ctx->estado = I2C_ASYNC_TX;
+            }
+            else
+            {
+                _i2c_async_hw(bus, I2C_ASYNC_OP_WRITE, (uint8_t)((t->direccion << 1) | 0x01)); //Dirección en modo lectura
+                ctx->estado = I2C_ASYNC_ADDR_R;
+            }
+            break;
+        case I2C_ASYNC_TX:
+            if(_i2c_async_hw(bus, I2C_ASYNC_OP_ACKSTAT, 0))
+            {
+                t->resultado = I2C_NACK;                    //El esclavo no respondió, se termina la transacción
+                _i2c_async_hw(bus, I2C_ASYNC_OP_PEN, 0);
+                ctx->estado = I2C_ASYNC_STOP;
+            }
+            else if(ctx->indice != t->n_tx)
+            {
+                _i2c_async_hw(bus, I2C_ASYNC_OP_WRITE, t->datos_tx[ctx->indice++]);
+            }
+            else if(t->n_rx != 0)
+            {
+                _i2c_async_hw(bus, I2C_ASYNC_OP_RSEN, 0);
+                ctx->estado = I2C_ASYNC_RESTART;
+            }
+            else
+            {
+                _i2c_async_hw(bus, I2C_ASYNC_OP_PEN, 0);
+                ctx->estado = I2C_ASYNC_STOP;
+            }
+            break;
+        case I2C_ASYNC_RESTART:
+            _i2c_async_hw(bus, I2C_ASYNC_OP_WRITE, (uint8_t)((t->direccion << 1) | 0x01));
+            ctx->estado = I2C_ASYNC_ADDR_R;
+            break;
+        case I2C_ASYNC_ADDR_R:
+            if(_i2c_async_hw(bus, I2C_ASYNC_OP_ACKSTAT, 0))
+            {
+                t->resultado = I2C_NACK;
+                _i2c_async_hw(bus, I2C_ASYNC_OP_PEN, 0);
+                ctx->estado = I2C_ASYNC_STOP;
+            }
+            else
+            {
+                ctx->indice = 0;
+                _i2c_async_hw(bus, I2C_ASYNC_OP_RCEN, 0);
+                ctx->estado = I2C_ASYNC_RX;
+            }
+            break;
+        case I2C_ASYNC_RX:
+            t->datos_rx[ctx->indice++] = _i2c_async_hw(bus, I2C_ASYNC_OP_READ, 0);
+            _i2c_async_hw(bus, I2C_ASYNC_OP_ACKEN, (ctx->indice == t->n_rx)? 1:0); //NACK en el último byte
+            ctx->estado = I2C_ASYNC_ACK;
+            break;
+        case I2C_ASYNC_ACK:
+            if(ctx->indice != t->n_rx)
+            {
+                _i2c_async_hw(bus, I2C_ASYNC_OP_RCEN, 0);
+                ctx->estado = I2C_ASYNC_RX;
+            }
+            else
+            {
+                _i2c_async_hw(bus, I2C_ASYNC_OP_PEN, 0);
+                ctx->estado = I2C_ASYNC_STOP;
+            }
+            break;
+        case I2C_ASYNC_STOP:
+            _i2c_async_finish(bus);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Inicialización del motor de transacciones: vacía la cola y habilita la interrupción del MSSP
+ * @param (void)
+ * @return (void)
+*/
+#if defined (I2C_V1)
+void i2c_async_init(void) {
+    _i2c_async_init(0);
+}
+#endif
+
+#if defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
+void i2c1_async_init(void) {
+    _i2c_async_init(0);
+}
+#endif
+
+#if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
+void i2c2_async_init(void) {
+    _i2c_async_init(1);
+}
+#endif
+
+/**
+ * @brief Agrega una transacción a la cola del bus. Si el bus está libre, la transacción inicia de inmediato.
+ * @param t (i2c_transaccion_t *) Descriptor de transacción, propiedad del usuario
+ * @return (bool) true si la transacción se agregó, false si el descriptor es inválido
+*/
+#if defined (I2C_V1)
+bool i2c_async_enqueue(i2c_transaccion_t *t) {
+    return _i2c_async_enqueue(0, t);
+}
+#endif
+
+#if defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
+bool i2c1_async_enqueue(i2c_transaccion_t *t) {
+    return _i2c_async_enqueue(0, t);
+}
+#endif
+
+#if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
+bool i2c2_async_enqueue(i2c_transaccion_t *t) {
+    return _i2c_async_enqueue(1, t);
+}
+#endif
+
+/**
+ * @brief Verificación de bus libre (cola vacía y sin transacción en curso)
+ * @param (void)
+ * @return (bool) true si no hay transacciones pendientes
+*/
+#if defined (I2C_V1)
+bool i2c_async_idle(void) {
+    return _i2c_async_ctx[0].estado == I2C_ASYNC_IDLE;
+}
+#endif
+
+#if defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
+bool i2c1_async_idle(void) {
+    return _i2c_async_ctx[0].estado == I2C_ASYNC_IDLE;
+}
+#endif
+
+#if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
+bool i2c2_async_idle(void) {
+    return _i2c_async_ctx[1].estado == I2C_ASYNC_IDLE;
+}
+#endif
+
+/**
+ * @brief Rutina a ejecutar en la interrupción del MSSP (verificando estado alto de la bandera SSPxIF o BCLxIF). Limpia
+ * la bandera y avanza la máquina de estados un paso, o aborta la transacción en curso si hubo colisión de bus.
+ * @param (void)
+ * @return (void)
+*/
+#if defined (I2C_V1)
+void i2c_async_interruptHandler(void) {
+    SSPIF = 0;
+    _i2c_async_step(0);
+}
+#endif
+
+#if defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
+void i2c1_async_interruptHandler(void) {
+    SSP1IF = 0;
+    _i2c_async_step(0);
+}
+#endif
+
+#if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
+void i2c2_async_interruptHandler(void) {
+    SSP2IF = 0;
+    _i2c_async_step(1);
+}
+#endif
+
+/**
+ * @brief Base de tiempo del timeout de transacciones. Se deberá incluir en la rutina de interrupción de un temporizador
+ * periódico (p. ej. cada 1[ms]) de la misma prioridad que la interrupción del MSSP.
+ * @param (void)
+ * @return (void)
+*/
+#if defined (I2C_V1)
+void i2c_async_tick(void) {
+    _i2c_async_tick(0);
+}
+#endif
+
+#if defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
+void i2c1_async_tick(void) {
+    _i2c_async_tick(0);
+}
+#endif
+
+#if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
+void i2c2_async_tick(void) {
+    _i2c_async_tick(1);
+}
+#endif
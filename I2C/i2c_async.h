@@ -0,0 +1,103 @@
+/**
+ * @file i2c_async.h
+ * @brief Motor de transacciones I²C maestro por interrupciones, con cola de transferencias no bloqueantes, para microcontroladores PIC de 8 bits.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef I2C_ASYNC_H
+#define	I2C_ASYNC_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../pconfig.h"
+#include "i2c.h"
+
+/**
+ * @brief Disponibilidad de buses para el motor de transacciones. Índice 0: i2c (o i2c1), índice 1: i2c2
+ */
+#if defined (I2C_V1) || defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
+#define I2C_ASYNC_BUS0
+#endif
+
+#if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
+#define I2C_ASYNC_BUS1
+#define I2C_ASYNC_N_BUSES	2
+#else
+#define I2C_ASYNC_N_BUSES	1
+#endif
+
+/**
+ * @brief Ticks de i2cx_async_tick sin eventos del MSSP tras los cuales se aborta la transacción en curso con I2C_TIMEOUT.
+ * Con ticks de 1[ms], un byte a 100[kHz] dura menos de 0.1[ms]; el margen cubre el estiramiento de reloj de los esclavos.
+ */
+#ifndef I2C_ASYNC_TIMEOUT
+#define I2C_ASYNC_TIMEOUT	10
+#endif
+
+/**
+ * @brief Estados de la máquina de estados del motor de transacciones
+ */
+typedef enum i2c_async_estado_t {
+	I2C_ASYNC_IDLE		= 0,	// Sin transacción en curso
+	I2C_ASYNC_START		= 1,	// Condición START en curso
+	I2C_ASYNC_TX		= 2,	// Transmisión de dirección (escritura) o datos en curso
+	I2C_ASYNC_RESTART	= 3,	// Condición RESTART en curso
+	I2C_ASYNC_ADDR_R	= 4,	// Transmisión de dirección en modo lectura en curso
+	I2C_ASYNC_RX		= 5,	// Recepción de byte en curso
+	I2C_ASYNC_ACK		= 6,	// Secuencia ACK/NACK del maestro en curso
+	I2C_ASYNC_STOP		= 7		// Condición STOP en curso
+} i2c_async_estado_t;
+
+/**
+ * @brief Descriptor de transacción I²C. La memoria del descriptor y de sus buffers pertenece al usuario y debe 
+ * permanecer válida hasta que la transacción termine (campo terminada en true).
+ * Secuencia generada: S, dirección+W, datos_tx[0..n_tx-1], Sr, dirección+R, datos_rx[0..n_rx-1], P
+ * Si n_tx = 0 se omite la fase de escritura; si n_rx = 0 se omite la fase de lectura.
+ */
+typedef struct i2c_transaccion_t {
+	uint8_t direccion;								// Dirección de 7 bits del esclavo (sin bit R/!W)
+	const uint8_t *datos_tx;						// Datos a escribir
+	uint8_t n_tx;									// Cantidad de datos a escribir
+	uint8_t *datos_rx;								// Buffer de datos a leer
+	uint8_t n_rx;									// Cantidad de datos a leer
+	void (*callback)(struct i2c_transaccion_t *t);	// Función a llamar al terminar (desde la interrupción), puede ser NULL
+	volatile i2c_status_t resultado;				// I2C_ACK si la transacción fue exitosa, I2C_NACK si el esclavo no respondió, I2C_BUS_COLLISION o I2C_TIMEOUT si se abortó
+	volatile bool terminada;						// Bandera de transacción terminada
+	struct i2c_transaccion_t *siguiente;			// Uso interno (cola de transacciones)
+} i2c_transaccion_t;
+
+/**
+ * Prototipos de funciones. El módulo MSSP debe inicializarse previamente en modo maestro mediante i2c_init/i2c1_init/i2c2_init,
+ * y las interrupciones globales y de periféricos (GIE/PEIE) deben habilitarse por la aplicación. La función interruptHandler
+ * correspondiente debe llamarse desde la rutina de interrupción al detectar la bandera SSPxIF o BCLxIF en alto, y la función
+ * tick desde la interrupción periódica de un temporizador de la misma prioridad (p. ej. cada 1[ms]).
+ * No deben mezclarse funciones bloqueantes de i2c.h sobre el mismo bus mientras haya transacciones en cola.
+*/
+#if defined (I2C_V1)
+void i2c_async_init(void);
+bool i2c_async_enqueue(i2c_transaccion_t *t);
+bool i2c_async_idle(void);
+void i2c_async_interruptHandler(void);
+void i2c_async_tick(void);
+#endif
+
+#if defined (I2C_V2) || defined (I2C_V3) || defined (I2C_V5) || defined (I2C_V6) || defined (I2C_V6_1) || defined (I2C_V6_2)
+void i2c1_async_init(void);
+bool i2c1_async_enqueue(i2c_transaccion_t *t);
+bool i2c1_async_idle(void);
+void i2c1_async_interruptHandler(void);
+void i2c1_async_tick(void);
+#endif
+
+#if defined (I2C_V3) || defined (I2C_V6) || defined (I2C_V6_1)
+void i2c2_async_init(void);
+bool i2c2_async_enqueue(i2c_transaccion_t *t);
+bool i2c2_async_idle(void);
+void i2c2_async_interruptHandler(void);
+void i2c2_async_tick(void);
+#endif
+
+#endif	/* I2C_ASYNC_H */
@@ -0,0 +1,269 @@
+/**
+ * @file i2c_sched.c
+ * @brief Planificador de bus I²C con prioridades por dispositivo y trabajos periódicos, sobre el motor de transacciones i2c_async.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "i2c_sched.h"
+
+/*
+    Variables internas
+*/
+static i2c_sched_trabajo_t *_trabajos[I2C_SCHED_MAX_TRABAJOS];  // Trabajos registrados
+static bool (*_enqueue)(i2c_transaccion_t *t);                  // Función de encolado del bus (i2c_async_enqueue, i2c1_async_enqueue o i2c2_async_enqueue)
+static volatile uint16_t _ticks;                                // Base de tiempo del planificador
+static volatile bool _enCurso;                                  // Transacción del planificador en el bus
+
+/*
+    Lectura atómica del contador de ticks de 16 bits (incrementado desde la interrupción de un temporizador)
+*/
+static uint16_t _i2c_sched_now(void)
+{
+    uint16_t t;
+    do {
+        t = _ticks;
+    } while(t != _ticks);
+    return t;
+}
+
+/*
+    Comparación de ticks tolerante al desbordamiento del contador: true si 'a' ocurre en o después de 'b'
+*/
+static bool _i2c_sched_alcanzado(uint16_t a, uint16_t b)
+{
+    return (int16_t)(a - b) >= 0;
+}
+
+static void _i2c_sched_dispatch(void);
+
+static int8_t _i2c_sched_find(i2c_sched_trabajo_t *trabajo)
+{
+    for(uint8_t i = 0; i != I2C_SCHED_MAX_TRABAJOS; i++)
+    {
+        if(_trabajos[i] == trabajo)
+            return (int8_t)i;
+    }
+    return -1;
+}
+
+/*
+    Fin de transacción: actualización de estadísticas, liberación de la entrada de los trabajos de una sola ejecución
+    y arranque del siguiente trabajo. Se ejecuta desde la interrupción del MSSP.
+*/
+static void _i2c_sched_complete(i2c_transaccion_t *t)
+{
+    i2c_sched_trabajo_t *trabajo = (i2c_sched_trabajo_t *)t;
+    trabajo->ejecuciones++;
+    if(trabajo->periodo == 0)
+    {
+        // La entrada se libera antes del callback, que puede volver a enviar el mismo trabajo
+        int8_t i = _i2c_sched_find(trabajo);
+        if(i >= 0)
+            _trabajos[i] = NULL;
+        trabajo->pendiente = false;
+    }
+    _enCurso = false;
+    if(trabajo->callback != NULL)
+        trabajo->callback(trabajo);
+    _i2c_sched_dispatch();
+}
+
+/*
+    Registro de un trabajo en la tabla. Debe llamarse con interrupciones deshabilitadas: la tabla se recorre desde la
+    interrupción del MSSP (_i2c_sched_complete)
+*/
+static bool _i2c_sched_register(i2c_sched_trabajo_t *trabajo)
+{
+    if(_i2c_sched_find(trabajo) >= 0)
+        return true;
+    int8_t libre = _i2c_sched_find(NULL);
+    if(libre < 0)
+        return false;
+    _trabajos[libre] = trabajo;
+    return true;
+}
+
+/**
+ * @brief Inicialización del planificador
+ * @param enqueue (bool (*)(i2c_transaccion_t *)) Función de encolado del bus a planificar, p. ej. i2c1_async_enqueue
+ * @return (void)
+*/
+void i2c_sched_init(bool (*enqueue)(i2c_transaccion_t *t))
+{
+    for(uint8_t i = 0; i != I2C_SCHED_MAX_TRABAJOS; i++)
+        _trabajos[i] = NULL;
+    _enqueue = enqueue;
+    _ticks = 0;
+    _enCurso = false;
+}
+
+/**
+ * @brief Registro de un trabajo periódico (p. ej. lectura de un sensor)
+ * @param trabajo (i2c_sched_trabajo_t *) Trabajo con su transacción previamente configurada
+ * @param periodo (uint16_t) Periodo de ejecución en ticks (mayor a 0)
+ * @param fase (uint16_t) Retardo de la primera ejecución en ticks, para repartir trabajos del mismo periodo
+ * @param prioridad (uint8_t) Prioridad del trabajo (0 = máxima)
+ * @return (bool) true si el trabajo se registró, false si no hay espacio o el periodo es inválido
+*/
+bool i2c_sched_addPeriodic(i2c_sched_trabajo_t *trabajo, uint16_t periodo, uint16_t fase, uint8_t prioridad)
+{
+    if(periodo == 0)
+        return false;
+    uint8_t gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    trabajo->periodo = periodo;
+    trabajo->prioridad = prioridad;
+    trabajo->transaccion.callback = _i2c_sched_complete;
+    i2c_sched_resetStats(trabajo);
+    trabajo->liberacion = _i2c_sched_now() + fase;
+    trabajo->pendiente = true;
+    bool registrado = _i2c_sched_register(trabajo);
+    INTCONbits.GIE = gie;
+    return registrado;
+}
+
+/**
+ * @brief Envío de una transacción de una sola ejecución. Con prioridad I2C_SCHED_PRIORIDAD_URGENTE se ejecuta en cuanto
+ * termine la transacción en curso, antes que cualquier trabajo periódico listo. El trabajo deja la tabla al terminar
+ * su transacción (antes de llamar a su callback), de modo que no es necesario llamar a i2c_sched_remove y puede volver
+ * a enviarse desde el propio callback; hasta entonces el trabajo y su transacción deben seguir en memoria (no usar
+ * variables locales de una función que retorne antes).
+ * @param trabajo (i2c_sched_trabajo_t *) Trabajo con su transacción previamente configurada
+ * @param prioridad (uint8_t) Prioridad del trabajo (0 = máxima)
+ * @return (bool) true si el trabajo se registró, false si no hay espacio o si aún está pendiente
+*/
+bool i2c_sched_submit(i2c_sched_trabajo_t *trabajo, uint8_t prioridad)
+{
+    bool registrado = false;
+    uint8_t gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    if(_i2c_sched_find(trabajo) < 0 || !trabajo->pendiente)
+    {
+        trabajo->periodo = 0;
+        trabajo->prioridad = prioridad;
+        trabajo->transaccion.callback = _i2c_sched_complete;
+        trabajo->liberacion = _i2c_sched_now();
+        trabajo->pendiente = true;
+        registrado = _i2c_sched_register(trabajo);
+        if(registrado)
+            _i2c_sched_dispatch();
+    }
+    INTCONbits.GIE = gie;
+    return registrado;
+}
+
+/**
+ * @brief Eliminación de un trabajo del planificador. Si está en ejecución, la transacción en curso termina normalmente.
+ * @param trabajo (i2c_sched_trabajo_t *) Trabajo a eliminar
+ * @return (void)
+*/
+void i2c_sched_remove(i2c_sched_trabajo_t *trabajo)
+{
+    uint8_t gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    int8_t i = _i2c_sched_find(trabajo);
+    if(i >= 0)
+    {
+        trabajo->pendiente = false;
+        _trabajos[i] = NULL;
+    }
+    INTCONbits.GIE = gie;
+}
+
+/**
+ * @brief Base de tiempo del planificador. Se deberá incluir en la rutina de interrupción de un temporizador periódico
+ * (p. ej. cada 1[ms]); la resolución del jitter registrado es de un tick. Con el bus libre arranca el trabajo listo de
+ * mayor prioridad, por lo que los trabajos periódicos no dependen del ciclo principal. La interrupción del temporizador
+ * debe tener la misma prioridad que la del MSSP, ya que ambas modifican la tabla y los trabajos.
+ * @param (void)
+ * @return (void)
+*/
+void i2c_sched_tick(void)
+{
+    _ticks++;
+    if(!_enCurso)
+        _i2c_sched_dispatch();
+}
+
+/*
+    Selección y arranque del siguiente trabajo listo. Debe llamarse con interrupciones deshabilitadas o desde la
+    interrupción del MSSP.
+*/
+static void _i2c_sched_dispatch(void)
+{
+    if(_enCurso || _enqueue == NULL)
+        return;
+    uint16_t ahora = _i2c_sched_now();
+    i2c_sched_trabajo_t *elegido = NULL;
+    for(uint8_t i = 0; i != I2C_SCHED_MAX_TRABAJOS; i++)
+    {
+        i2c_sched_trabajo_t *trabajo = _trabajos[i];
+        if(trabajo == NULL || !trabajo->pendiente || !_i2c_sched_alcanzado(ahora, trabajo->liberacion))
+            continue;
+        if(elegido == NULL || trabajo->prioridad < elegido->prioridad ||
+           (trabajo->prioridad == elegido->prioridad && !_i2c_sched_alcanzado(trabajo->liberacion, elegido->liberacion)))
+            elegido = trabajo;
+    }
+    if(elegido == NULL)
+        return;
+
+    //Registro de retardo de inicio respecto a la liberación (jitter)
+    elegido->jitter_ultimo = ahora - elegido->liberacion;
+    if(elegido->jitter_ultimo > elegido->jitter_max)
+        elegido->jitter_max = elegido->jitter_ultimo;
+
+    //Reprogramación de trabajo periódico; los periodos ya vencidos se cuentan como omisiones
+    if(elegido->periodo != 0)
+    {
+        elegido->liberacion += elegido->periodo;
+        while(_i2c_sched_alcanzado(ahora, elegido->liberacion))
+        {
+            elegido->liberacion += elegido->periodo;
+            elegido->omisiones++;
+        }
+    }
+
+    _enCurso = true;
+    if(!_enqueue(&elegido->transaccion))
+        _enCurso = false;
+}
+
+/**
+ * @brief Selección y arranque del siguiente trabajo listo de mayor prioridad (a igual prioridad, el de liberación más
+ * antigua). Se llama automáticamente en cada tick y al terminar cada transacción, de modo que el bus no queda ocioso
+ * entre trabajos listos; sólo es necesario llamarla para adelantar un trabajo al siguiente tick.
+ * @param (void)
+ * @return (void)
+*/
+void i2c_sched_dispatch(void)
+{
+    // La tabla y los trabajos también se modifican desde la interrupción del MSSP al terminar cada transacción
+    uint8_t gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    _i2c_sched_dispatch();
+    INTCONbits.GIE = gie;
+}
+
+/**
+ * @brief Reinicio de estadísticas de un trabajo
+ * @param trabajo (i2c_sched_trabajo_t *) Trabajo
+ * @return (void)
+*/
+void i2c_sched_resetStats(i2c_sched_trabajo_t *trabajo)
+{
+    trabajo->jitter_ultimo = 0;
+    trabajo->jitter_max = 0;
+    trabajo->ejecuciones = 0;
+    trabajo->omisiones = 0;
+}
+
+/**
+ * @brief Lectura de la base de tiempo del planificador
+ * @param (void)
+ * @return (uint16_t) Ticks transcurridos desde la inicialización
+*/
+uint16_t i2c_sched_getTicks(void)
+{
+    return _i2c_sched_now();
+}
@@ -0,0 +1,61 @@
+/**
+ * @file i2c_sched.h
+ * @brief Planificador de bus I²C con prioridades por dispositivo y trabajos periódicos, sobre el motor de transacciones i2c_async.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef I2C_SCHED_H
+#define	I2C_SCHED_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../pconfig.h"
+#include "i2c_async.h"
+
+/**
+ * @brief Cantidad máxima de trabajos registrados en el planificador. Adecuar según necesidades del proyecto.
+ */
+#define I2C_SCHED_MAX_TRABAJOS	8
+
+/**
+ * @brief Prioridades sugeridas. Un valor menor indica mayor prioridad.
+ */
+#define I2C_SCHED_PRIORIDAD_URGENTE	0
+#define I2C_SCHED_PRIORIDAD_ALTA	1
+#define I2C_SCHED_PRIORIDAD_NORMAL	2
+#define I2C_SCHED_PRIORIDAD_BAJA	3
+
+/**
+ * @brief Trabajo del planificador. La transacción debe ser el primer miembro: el planificador recupera el trabajo a partir
+ * del descriptor de transacción al terminar ésta. La memoria del trabajo pertenece al usuario.
+ */
+typedef struct i2c_sched_trabajo_t {
+	i2c_transaccion_t transaccion;							// Transacción a ejecutar (dirección, buffers); su campo callback es de uso interno
+	void (*callback)(struct i2c_sched_trabajo_t *trabajo);	// Función a llamar al terminar cada ejecución (desde la interrupción), puede ser NULL
+	uint16_t periodo;										// Periodo en ticks; 0 para transacciones de una sola ejecución
+	uint8_t prioridad;										// Prioridad (0 = máxima)
+	// Campos de uso interno y estadísticas
+	uint16_t liberacion;									// Tick en que el trabajo queda listo para ejecutarse
+	volatile bool pendiente;								// Trabajo listo o en espera de liberación
+	uint16_t jitter_ultimo;									// Retardo entre liberación e inicio de la última ejecución, en ticks
+	uint16_t jitter_max;									// Máximo retardo registrado, en ticks
+	uint16_t ejecuciones;									// Cantidad de ejecuciones terminadas
+	uint16_t omisiones;										// Periodos perdidos por saturación del bus
+} i2c_sched_trabajo_t;
+
+/**
+ * Prototipos de funciones
+*/
+void i2c_sched_init(bool (*enqueue)(i2c_transaccion_t *t));
+bool i2c_sched_addPeriodic(i2c_sched_trabajo_t *trabajo, uint16_t periodo, uint16_t fase, uint8_t prioridad);
+bool i2c_sched_submit(i2c_sched_trabajo_t *trabajo, uint8_t prioridad);
+void i2c_sched_remove(i2c_sched_trabajo_t *trabajo);
+void i2c_sched_tick(void);
+void i2c_sched_dispatch(void);
+void i2c_sched_resetStats(i2c_sched_trabajo_t *trabajo);
+uint16_t i2c_sched_getTicks(void);
+
+#endif	/* I2C_SCHED_H */
@@ -0,0 +1,252 @@
+/**
+ * @file epwm_mc.c
+ * @brief Capa de control de motores sobre los módulos ECCP (PWM mejorado): salidas de medio puente y puente completo con
+ * banda muerta en nanosegundos, apagado automático por falla con reinicio automático, direccionamiento de pulsos
+ * (steering) para conmutación de motores BLDC y API de conmutación segura desde interrupciones.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "epwm_mc.h"
+
+#if defined (EPWM_MC_DISPONIBLE)
+
+/*
+	Registros de cada módulo ECCP: control (modo de salida), banda muerta/reinicio, apagado automático y direccionamiento
+*/
+typedef struct epwm_mc_regs_t {
+	volatile uint8_t *con;
+	volatile uint8_t *del;
+	volatile uint8_t *as;
+	#if defined (EPWM_MC_STEERING)
+	volatile uint8_t *str;
+	#endif
+} epwm_mc_regs_t;
+
+static const epwm_mc_regs_t _epwm_mc_regs[EPWM_MC_MODULOS] = {
+	#if defined (EPWM_V7)
+	{ &ECCP1CON, &ECCP1DEL, &ECCP1AS },
+	#elif defined (EPWM_V14_3) || defined (EPWM_V14_4) || defined (EPWM_V14_5)
+	{ &CCP1CON, &PWM1CON, &CCP1AS, &PSTR1CON },
+	#else
+	{ &ECCP1CON, &ECCP1DEL, &ECCP1AS, &PSTR1CON },
+	#endif
+	#if (EPWM_MC_MODULOS > 1)
+	#if defined (EPWM_V14_3) || defined (EPWM_V14_4)
+	{ &CCP2CON, &PWM2CON, &CCP2AS, &PSTR2CON },
+	{ &CCP3CON, &PWM3CON, &CCP3AS, &PSTR3CON }
+	#else
+	{ &ECCP2CON, &ECCP2DEL, &ECCP2AS, &PSTR2CON },
+	{ &CCP3CON, &ECCP3DEL, &ECCP3AS, &PSTR3CON }
+	#endif
+	#endif
+};
+
+#if defined (EPWM_MC_STEERING)
+static uint8_t _epwm_mc_tabla[EPWM_MC_MODULOS][EPWM_MC_MAX_PASOS];		// Tablas de conmutación
+static uint8_t _epwm_mc_pasos[EPWM_MC_MODULOS];							// Número de pasos de cada tabla
+static volatile uint8_t _epwm_mc_paso[EPWM_MC_MODULOS];					// Paso aplicado
+#endif
+
+/*
+	Registros de un módulo, o NULL si el número de módulo no es válido
+*/
+static const epwm_mc_regs_t *_epwm_mc_getRegs(uint8_t modulo)
+{
+	if(modulo == 0 || modulo > EPWM_MC_MODULOS)
+	{
+		return NULL;
+	}
+	return &_epwm_mc_regs[modulo - 1];
+}
+
+bool epwm_mc_init(uint8_t modulo, uint8_t salida, uint8_t modo, uint16_t banda_muerta_ns)
+{
+	if(_epwm_mc_getRegs(modulo) == NULL)
+	{
+		return false;
+	}
+	if(!epwm_mc_setDeadBand(modulo, banda_muerta_ns))
+	{
+		return false;
+	}
+	switch(modulo)
+	{
+		case 1: epwm1_setOutput(salida, modo); break;
+		#if (EPWM_MC_MODULOS > 1)
+		case 2: epwm2_setOutput(salida, modo); break;
+		case 3: epwm3_setOutput(salida, modo); break;
+		#endif
+		default: return false;
+	}
+	#if defined (EPWM_MC_STEERING)
+	if(salida == PWM_SINGLE_OUT)
+	{
+		_epwm_mc_pasos[modulo - 1] = 0;
+		_epwm_mc_paso[modulo - 1] = 0;
+	}
+	#endif
+	return true;
+}
+
+bool epwm_mc_setDeadBand(uint8_t modulo, uint16_t banda_muerta_ns)
+{
+	const epwm_mc_regs_t *r = _epwm_mc_getRegs(modulo);
+	uint32_t ciclos = EPWM_MC_BANDA_MUERTA(banda_muerta_ns);
+	if(r == NULL || ciclos > EPWM_MC_MAX_BANDA)
+	{
+		return false;
+	}
+	*r->del = (*r->del & EPWM_MC_AUTO_REINICIO) | (uint8_t)ciclos;
+	return true;
+}
+
+bool epwm_mc_setShutdown(uint8_t modulo, uint8_t fuente, uint8_t estado_ac, uint8_t estado_bd, bool auto_reinicio)
+{
+	const epwm_mc_regs_t *r = _epwm_mc_getRegs(modulo);
+	if(r == NULL)
+	{
+		return false;
+	}
+	// ECCPxASE se conserva: un apagado en curso no se libera al reconfigurar
+	*r->as = (*r->as & EPWM_MC_ASE) | (fuente & 0x70) | (estado_ac & 0x0C) | (estado_bd & 0x03);
+	if(auto_reinicio)
+	{
+		*r->del |= EPWM_MC_AUTO_REINICIO;
+	}
+	else
+	{
+		*r->del &= (uint8_t)~EPWM_MC_AUTO_REINICIO;
+	}
+	return true;
+}
+
+bool epwm_mc_isShutdown(uint8_t modulo)
+{
+	const epwm_mc_regs_t *r = _epwm_mc_getRegs(modulo);
+	if(r == NULL)
+	{
+		return false;
+	}
+	return (*r->as & EPWM_MC_ASE) != 0;
+}
+
+void epwm_mc_shutdown(uint8_t modulo)
+{
+	const epwm_mc_regs_t *r = _epwm_mc_getRegs(modulo);
+	if(r != NULL)
+	{
+		*r->as |= EPWM_MC_ASE;	// BSF: operación de un solo ciclo, segura desde interrupciones
+	}
+}
+
+void epwm_mc_restart(uint8_t modulo)
+{
+	const epwm_mc_regs_t *r = _epwm_mc_getRegs(modulo);
+	if(r != NULL)
+	{
+		*r->as &= (uint8_t)~EPWM_MC_ASE;
+	}
+}
+
+bool epwm_mc_setDirection(uint8_t modulo, bool reversa)
+{
+	const epwm_mc_regs_t *r = _epwm_mc_getRegs(modulo);
+	uint8_t con;
+	uint8_t gie;
+	if(r == NULL)
+	{
+		return false;
+	}
+	// Lectura-modificación-escritura de ECCPxCON: epwmx_setDuty también escribe DCxB en este registro
+	gie = INTCONbits.GIE;
+	INTCONbits.GIE = 0;
+	con = *r->con;
+	if(!IS_QUAD_PWM(con & 0xC0))
+	{
+		INTCONbits.GIE = gie;
+		return false;
+	}
+	*r->con = (con & 0x3F) | (reversa ? PWM_FULL_BRIDGE_REVERSE : PWM_FULL_BRIDGE_FORWARD);
+	INTCONbits.GIE = gie;
+	return true;
+}
+
+#if defined (EPWM_MC_STEERING)
+
+void epwm_mc_commutate(uint8_t modulo, uint8_t pines)
+{
+	const epwm_mc_regs_t *r = _epwm_mc_getRegs(modulo);
+	if(r != NULL)
+	{
+		*r->str = pines & 0x1F;
+	}
+}
+
+bool epwm_mc_setCommutationTable(uint8_t modulo, const uint8_t *tabla, uint8_t n_pasos)
+{
+	uint8_t i;
+	uint8_t gie;
+	if(_epwm_mc_getRegs(modulo) == NULL || tabla == NULL || n_pasos == 0 || n_pasos > EPWM_MC_MAX_PASOS)
+	{
+		return false;
+	}
+	gie = INTCONbits.GIE;
+	INTCONbits.GIE = 0;
+	for(i = 0; i < n_pasos; i++)
+	{
+		_epwm_mc_tabla[modulo - 1][i] = tabla[i];
+	}
+	_epwm_mc_pasos[modulo - 1] = n_pasos;
+	_epwm_mc_paso[modulo - 1] = 0;
+	INTCONbits.GIE = gie;
+	return true;
+}
+
+uint8_t epwm_mc_step(uint8_t modulo, bool reversa)
+{
+	const epwm_mc_regs_t *r = _epwm_mc_getRegs(modulo);
+	uint8_t m;
+	uint8_t paso;
+	uint8_t gie;
+	if(r == NULL || _epwm_mc_pasos[modulo - 1] == 0)
+	{
+		return 0;
+	}
+	m = modulo - 1;
+	// El avance del índice y la escritura de PSTRxCON no deben intercalarse con otra llamada desde interrupción
+	gie = INTCONbits.GIE;
+	INTCONbits.GIE = 0;
+	paso = _epwm_mc_paso[m];
+	if(reversa)
+	{
+		paso = (paso == 0) ? (uint8_t)(_epwm_mc_pasos[m] - 1) : (uint8_t)(paso - 1);
+	}
+	else if(++paso >= _epwm_mc_pasos[m])
+	{
+		paso = 0;
+	}
+	_epwm_mc_paso[m] = paso;
+	*r->str = _epwm_mc_tabla[m][paso] & 0x1F;
+	INTCONbits.GIE = gie;
+	return paso;
+}
+
+void epwm_mc_setStep(uint8_t modulo, uint8_t paso)
+{
+	const epwm_mc_regs_t *r = _epwm_mc_getRegs(modulo);
+	uint8_t gie;
+	if(r == NULL || paso >= _epwm_mc_pasos[modulo - 1])
+	{
+		return;
+	}
+	gie = INTCONbits.GIE;
+	INTCONbits.GIE = 0;
+	_epwm_mc_paso[modulo - 1] = paso;
+	*r->str = _epwm_mc_tabla[modulo - 1][paso] & 0x1F;
+	INTCONbits.GIE = gie;
+}
+
+#endif
+
+#endif
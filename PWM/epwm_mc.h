@@ -0,0 +1,190 @@
+/**
+ * @file epwm_mc.h
+ * @brief Capa de control de motores sobre los módulos ECCP (PWM mejorado): salidas de medio puente y puente completo con
+ * banda muerta en nanosegundos, apagado automático por falla con reinicio automático, direccionamiento de pulsos
+ * (steering) para conmutación de motores BLDC y API de conmutación segura desde interrupciones.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef EPWM_MC_H
+#define	EPWM_MC_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pconfig.h"
+#include "pwm.h"
+
+/**
+ * @brief Versiones con módulos ECCP soportadas. ECCPxDEL/PWMxCON (banda muerta) y ECCPxAS/CCPxAS (apagado automático)
+ * existen en todas; PSTRxCON (direccionamiento) no existe en EPWM_V7.
+ */
+#if defined (EPWM_V7)
+#define EPWM_MC_DISPONIBLE
+#define EPWM_MC_MODULOS		1
+#elif defined (EPWM_V14_2) || defined (EPWM_V14_5)
+#define EPWM_MC_DISPONIBLE
+#define EPWM_MC_STEERING
+#define EPWM_MC_MODULOS		1
+#elif defined (EPWM_V14) || defined (EPWM_V14_1) || defined (EPWM_V14_3) || defined (EPWM_V14_4) ||\
+	defined (EPWM_V15) || defined (EPWM_V15_1)
+#define EPWM_MC_DISPONIBLE
+#define EPWM_MC_STEERING
+#define EPWM_MC_MODULOS		3
+#endif
+
+#if defined (EPWM_MC_DISPONIBLE)
+
+/*
+	Banda muerta: retardo en ciclos de instrucción (Fosc/4) entre el flanco de una salida y la activación de su complemento
+	en modo medio puente. Bits PxDC<6:0> de ECCPxDEL/PWMxCON.
+*/
+#define EPWM_MC_MAX_BANDA		127		// Ciclos de instrucción máximos de banda muerta
+#define EPWM_MC_AUTO_REINICIO	0x80	// Bit PxRSEN: la salida se reanuda al desaparecer la falla
+
+/* Conversión de [ns] a ciclos de instrucción, redondeada hacia arriba. Constante si ns es constante */
+#define EPWM_MC_BANDA_MUERTA(ns)	(((uint32_t)(ns) * ((_XTAL_FREQ) / 4000UL) + 999999UL) / 1000000UL)
+
+/*
+	Fuentes de apagado automático. Bits ECCPxAS<2:0> (ECCPxAS<6:4>)
+*/
+#define EPWM_MC_FALLA_NINGUNA	0x00	// Apagado automático deshabilitado
+#define EPWM_MC_FALLA_C1		0x10	// Salida del comparador 1
+#define EPWM_MC_FALLA_C2		0x20	// Salida del comparador 2
+#define EPWM_MC_FALLA_C1_C2		0x30	// Comparador 1 o comparador 2
+#define EPWM_MC_FALLA_FLT0		0x40	// Nivel bajo en el pin FLT0/INT0
+#define EPWM_MC_FALLA_FLT0_C1	0x50	// FLT0 o comparador 1
+#define EPWM_MC_FALLA_FLT0_C2	0x60	// FLT0 o comparador 2
+#define EPWM_MC_FALLA_TODAS		0x70	// FLT0, comparador 1 o comparador 2
+
+#define EPWM_MC_ASE				0x80	// Bit ECCPxASE: estado de apagado (escribible por software)
+
+/*
+	Estado de los pines durante el apagado. Bits PSSxAC<1:0> (PxA y PxC) y PSSxBD<1:0> (PxB y PxD)
+*/
+#define EPWM_MC_AC_BAJO			0x00
+#define EPWM_MC_AC_ALTO			0x04
+#define EPWM_MC_AC_TRIESTADO	0x08
+#define EPWM_MC_BD_BAJO			0x00
+#define EPWM_MC_BD_ALTO			0x01
+#define EPWM_MC_BD_TRIESTADO	0x02
+
+#if defined (EPWM_MC_STEERING)
+/*
+	Direccionamiento de pulsos (PSTRxCON), válido con salida PWM_SINGLE_OUT. Los pines no seleccionados toman
+	el valor de su registro de puerto.
+*/
+#define EPWM_MC_STR_A			0x01	// Señal PWM en PxA
+#define EPWM_MC_STR_B			0x02	// Señal PWM en PxB
+#define EPWM_MC_STR_C			0x04	// Señal PWM en PxC
+#define EPWM_MC_STR_D			0x08	// Señal PWM en PxD
+#define EPWM_MC_STR_SYNC		0x10	// El cambio se aplica al inicio del siguiente periodo (STRxSYNC)
+
+/**
+ * @brief Número máximo de pasos de una tabla de conmutación
+ */
+#ifndef EPWM_MC_MAX_PASOS
+#define EPWM_MC_MAX_PASOS		6
+#endif
+#endif
+
+/**
+ * @brief Configura las salidas de un módulo ECCP y su banda muerta. El temporizador y el ciclo de trabajo se configuran
+ * con epwmx_init y epwmx_setDuty.
+ * @param modulo Número de módulo ECCP (1 a EPWM_MC_MODULOS)
+ * @param salida PWM_SINGLE_OUT, PWM_HALF_BRIDGE, PWM_FULL_BRIDGE_FORWARD o PWM_FULL_BRIDGE_REVERSE
+ * @param modo Polaridad de las salidas (PWM_MODE_1 a PWM_MODE_4)
+ * @param banda_muerta_ns Banda muerta en [ns] para medio puente (0 si no se usa)
+ * @return (bool) true si la configuración es válida, false en caso contrario
+ */
+bool epwm_mc_init(uint8_t modulo, uint8_t salida, uint8_t modo, uint16_t banda_muerta_ns);
+
+/**
+ * @brief Establece la banda muerta de un módulo, conservando la configuración de reinicio automático
+ * @param modulo Número de módulo ECCP
+ * @param banda_muerta_ns Banda muerta en [ns]; se redondea hacia arriba al siguiente ciclo de instrucción
+ * @return (bool) true si la banda muerta cabe en EPWM_MC_MAX_BANDA ciclos, false en caso contrario (no se modifica)
+ */
+bool epwm_mc_setDeadBand(uint8_t modulo, uint16_t banda_muerta_ns);
+
+/**
+ * @brief Configura el apagado automático por falla
+ * @param modulo Número de módulo ECCP
+ * @param fuente Fuente de falla (EPWM_MC_FALLA_x)
+ * @param estado_ac Estado de PxA y PxC durante el apagado (EPWM_MC_AC_x)
+ * @param estado_bd Estado de PxB y PxD durante el apagado (EPWM_MC_BD_x)
+ * @param auto_reinicio true para reanudar automáticamente al desaparecer la falla, false para requerir epwm_mc_restart
+ * @return (bool) true si el módulo es válido
+ */
+bool epwm_mc_setShutdown(uint8_t modulo, uint8_t fuente, uint8_t estado_ac, uint8_t estado_bd, bool auto_reinicio);
+
+/**
+ * @brief Indica si el módulo está en estado de apagado
+ * @param modulo Número de módulo ECCP
+ * @return (bool) true si las salidas están en estado de apagado
+ */
+bool epwm_mc_isShutdown(uint8_t modulo);
+
+/**
+ * @brief Fuerza el apagado del módulo por software (las salidas toman el estado configurado en epwm_mc_setShutdown)
+ * @param modulo Número de módulo ECCP
+ */
+void epwm_mc_shutdown(uint8_t modulo);
+
+/**
+ * @brief Reanuda las salidas tras un apagado sin reinicio automático. Si la falla persiste, el módulo permanece apagado.
+ * La salida se reanuda al inicio del siguiente periodo.
+ * @param modulo Número de módulo ECCP
+ */
+void epwm_mc_restart(uint8_t modulo);
+
+/**
+ * @brief Cambia el sentido de giro en modo puente completo. Se recomienda reducir el ciclo de trabajo antes de invertir
+ * para limitar la corriente de conmutación.
+ * @param modulo Número de módulo ECCP
+ * @param reversa true para PWM_FULL_BRIDGE_REVERSE, false para PWM_FULL_BRIDGE_FORWARD
+ * @return (bool) true si el módulo está en modo puente completo
+ */
+bool epwm_mc_setDirection(uint8_t modulo, bool reversa);
+
+#if defined (EPWM_MC_STEERING)
+
+/**
+ * @brief Escribe directamente la selección de pines de la señal PWM. Escritura de un solo registro, segura desde interrupciones.
+ * @param modulo Número de módulo ECCP
+ * @param pines Combinación de EPWM_MC_STR_x
+ */
+void epwm_mc_commutate(uint8_t modulo, uint8_t pines);
+
+/**
+ * @brief Registra una tabla de conmutación (p.ej. seis pasos de un motor BLDC). La tabla se copia y el paso actual se reinicia a 0.
+ * @param modulo Número de módulo ECCP
+ * @param tabla Selección de pines de cada paso (combinaciones de EPWM_MC_STR_x)
+ * @param n_pasos Número de pasos (1 a EPWM_MC_MAX_PASOS)
+ * @return (bool) true si la tabla es válida
+ */
+bool epwm_mc_setCommutationTable(uint8_t modulo, const uint8_t *tabla, uint8_t n_pasos);
+
+/**
+ * @brief Avanza un paso en la tabla de conmutación y aplica la selección de pines. Segura desde interrupciones
+ * (p.ej. desde la interrupción por cambio de los sensores Hall).
+ * @param modulo Número de módulo ECCP
+ * @param reversa true para retroceder un paso, false para avanzar
+ * @return (uint8_t) Paso aplicado
+ */
+uint8_t epwm_mc_step(uint8_t modulo, bool reversa);
+
+/**
+ * @brief Aplica un paso específico de la tabla de conmutación (p.ej. a partir de la lectura de los sensores Hall)
+ * @param modulo Número de módulo ECCP
+ * @param paso Paso a aplicar (0 a n_pasos-1)
+ */
+void epwm_mc_setStep(uint8_t modulo, uint8_t paso);
+
+#endif
+
+#endif
+
+#endif	/* EPWM_MC_H */
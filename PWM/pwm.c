@@ -2090,8 +2090,7 @@ void epwm3_setOutput(uint8_t output_config, uint8_t output_mode)
 void pwm1_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR1L=(uint8_t)(duty>>2);
-    CCP1CON|= (uint8_t)((duty & 0x0003)<< 4);
+    PWM_ESCRIBIR_DUTY(CCPR1L, CCP1CON, duty);
 }
 #endif
 
@@ -2104,8 +2103,7 @@ void pwm1_setDuty(uint16_t duty)
 void pwm2_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR2L=(uint8_t)(duty>>2);
-    CCP2CON|= (uint8_t)((duty & 0x0003)<< 4);
+    PWM_ESCRIBIR_DUTY(CCPR2L, CCP2CON, duty);
 }
 #endif
 
@@ -2116,8 +2114,7 @@ void pwm2_setDuty(uint16_t duty)
 void pwm3_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR3L=(uint8_t)(duty>>2);
-    CCP3CON|= (uint8_t)((duty & 0x0003)<< 4);
+    PWM_ESCRIBIR_DUTY(CCPR3L, CCP3CON, duty);
 }
 #endif
 
@@ -2130,8 +2127,7 @@ void pwm3_setDuty(uint16_t duty)
 void pwm4_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR4L=(uint8_t)(duty>>2);
-    CCP4CON|= (uint8_t)((duty & 0x0003)<< 4);  
+    PWM_ESCRIBIR_DUTY(CCPR4L, CCP4CON, duty);
 }
 #endif
 
@@ -2143,8 +2139,7 @@ void pwm4_setDuty(uint16_t duty)
 void pwm5_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR5L=(uint8_t)(duty>>2);
-    CCP5CON|= (uint8_t)((duty & 0x0003)<< 4);   
+    PWM_ESCRIBIR_DUTY(CCPR5L, CCP5CON, duty);
 }
 #endif
 
@@ -2156,8 +2151,7 @@ void pwm5_setDuty(uint16_t duty)
 void pwm6_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR6L=(uint8_t)(duty>>2);
-    CCP6CON|= (uint8_t)((duty & 0x0003)<< 4);   
+    PWM_ESCRIBIR_DUTY(CCPR6L, CCP6CON, duty);
 }
 #endif
 
@@ -2168,8 +2162,7 @@ void pwm6_setDuty(uint16_t duty)
 void pwm7_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR7L=(uint8_t)(duty>>2);
-    CCP7CON|= (uint8_t)((duty & 0x0003)<< 4);   
+    PWM_ESCRIBIR_DUTY(CCPR7L, CCP7CON, duty);
 }
 #endif
 
@@ -2180,8 +2173,7 @@ void pwm7_setDuty(uint16_t duty)
 void pwm8_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR8L=(uint8_t)(duty>>2);
-    CCP8CON|= (uint8_t)((duty & 0x0003)<< 4);   
+    PWM_ESCRIBIR_DUTY(CCPR8L, CCP8CON, duty);
 }
 #endif
 
@@ -2192,8 +2184,7 @@ void pwm8_setDuty(uint16_t duty)
 void pwm9_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR9L=(uint8_t)(duty>>2);
-    CCP9CON|= (uint8_t)((duty & 0x0003)<< 4);   
+    PWM_ESCRIBIR_DUTY(CCPR9L, CCP9CON, duty);
 }
 #endif
 
@@ -2204,8 +2195,7 @@ void pwm9_setDuty(uint16_t duty)
 void pwm10_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR10L=(uint8_t)(duty>>2);
-    CCP10CON|= (uint8_t)((duty & 0x0003)<< 4);   
+    PWM_ESCRIBIR_DUTY(CCPR10L, CCP10CON, duty);
 }
 #endif
 
@@ -2216,8 +2206,7 @@ void pwm10_setDuty(uint16_t duty)
 void epwm1_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    ECCPR1L=(uint8_t)(duty>>2);
-    ECCP1CON|= (uint8_t)((duty & 0x0003)<< 4);
+    PWM_ESCRIBIR_DUTY(ECCPR1L, ECCP1CON, duty);
 }
 
 #elif defined (EPWM_V14) || defined (EPWM_V14_1) || defined (EPWM_V14_2) \
@@ -2225,12 +2214,10 @@ void epwm1_setDuty(uint16_t duty)
 void epwm1_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR1L=(uint8_t)(duty>>2);
-
     #if defined (EPWM_V14_3) || defined (EPWM_V14_4) || defined (EPWM_V14_5) 
-    CCP1CON|= (uint8_t)((duty & 0x0003)<< 4);
+    PWM_ESCRIBIR_DUTY(CCPR1L, CCP1CON, duty);
     #else
-    ECCP1CON|= (uint8_t)((duty & 0x0003)<< 4);
+    PWM_ESCRIBIR_DUTY(CCPR1L, ECCP1CON, duty);
     #endif 
 }
 #endif
@@ -2243,12 +2230,10 @@ void epwm1_setDuty(uint16_t duty)
 void epwm2_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR2L=(uint8_t)(duty>>2);
-
     #if defined (EPWM_V14_3) || defined (EPWM_V14_4)
-    CCP2CON|= (uint8_t)((duty & 0x0003)<< 4);
+    PWM_ESCRIBIR_DUTY(CCPR2L, CCP2CON, duty);
     #else
-    ECCP2CON|= (uint8_t)((duty & 0x0003)<< 4);
+    PWM_ESCRIBIR_DUTY(CCPR2L, ECCP2CON, duty);
     #endif 
 }    
 #endif
@@ -2261,12 +2246,174 @@ void epwm2_setDuty(uint16_t duty)
 void epwm3_setDuty(uint16_t duty)
 {
     //Se configura la palabra CCPRL:CCPCON<5:4>, formando una variable de 10 bits que contiene el ciclo de trabajo
-    CCPR3L=(uint8_t)(duty>>2);
-    CCP3CON|= (uint8_t)((duty & 0x0003)<< 4);
+    PWM_ESCRIBIR_DUTY(CCPR3L, CCP3CON, duty);
 }
 #endif
 
 
+/*
+* Función para esperar el fin de periodo del temporizador base de PWM. Al regresar, los ciclos de trabajo escritos
+* se transfieren al siguiente fin de periodo, por lo que se dispone de un periodo completo para actualizar.
+* Parámetros: 
+* timer: PWM_SYNC_TMR2, PWM_SYNC_TMR4 o PWM_SYNC_TMR6 (PWM_SYNC_NINGUNO regresa de inmediato)
+* Retorno: 
+* Vacío (void)
+* Nota: limpia la bandera TMRxIF y espera a que el hardware la active. No debe usarse mientras la interrupción del mismo
+* temporizador esté habilitada (p. ej. con pwm_seq): la rutina de interrupción limpia la bandera primero y la espera
+* puede no terminar. En ese caso las actualizaciones deben hacerse desde dicha interrupción con PWM_SYNC_NINGUNO.
+*/
+void pwm_waitPeriod(uint8_t timer)
+{
+    switch(timer)
+    {
+        case PWM_SYNC_TMR2:
+            TMR2IF = 0;
+            while(!TMR2IF){}
+            break;
+        #if defined (PWM_SYNC_TMR4)
+        case PWM_SYNC_TMR4:
+            TMR4IF = 0;
+            while(!TMR4IF){}
+            break;
+        #endif
+        #if defined (PWM_SYNC_TMR6)
+        case PWM_SYNC_TMR6:
+            TMR6IF = 0;
+            while(!TMR6IF){}
+            break;
+        #endif
+        default: break;
+    }
+}
+
+/*
+* Función para actualizar varios canales PWM en el mismo fin de periodo
+* Parámetros: 
+* canales: Arreglo de funciones pwmx_setDuty/epwmx_setDuty de los canales a actualizar
+* duties: Arreglo de ciclos de trabajo, en el mismo orden que canales
+* n: Número de canales
+* timer: Temporizador base para sincronización (PWM_SYNC_x)
+* Retorno: 
+* Vacío (void)
+* Nota: las interrupciones se deshabilitan antes de esperar el fin de periodo (si se solicita sincronización) y hasta
+* terminar las escrituras, de modo que ninguna interrupción retrase las escrituras más allá del siguiente fin de periodo
+* y todos los canales cambian en el mismo ciclo PWM. La espera dura hasta un periodo PWM con interrupciones
+* deshabilitadas; si la interrupción del temporizador está habilitada, pierde ese fin de periodo.
+*/
+void pwm_setDutyBulk(const pwm_setDuty_t *canales, const uint16_t *duties, uint8_t n, uint8_t timer)
+{
+    uint8_t i;
+    uint8_t gie;
+    gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    pwm_waitPeriod(timer);
+    for(i = 0; i < n; i++)
+    {
+        canales[i](duties[i]);
+    }
+    INTCONbits.GIE = gie;
+}
+
+/*
+* Función para calcular preescala y periodo a partir de una frecuencia PWM, con la máxima resolución posible
+* Parámetros: 
+* frecuencia_hz: Frecuencia PWM deseada en [Hz]
+* bits_min: Resolución mínima aceptable del ciclo de trabajo en bits (2 a 10)
+* resultado: Apuntador a estructura donde se devuelven config_timer, periodo, preescala, bits, duty_max y la frecuencia obtenida
+* Retorno: 
+* true si la frecuencia es alcanzable con la resolución pedida, false en caso contrario
+* Nota: con argumentos constantes es preferible usar las macros PWM_CONFIG_TIMER(f) y PWM_PERIODO(f), que se resuelven
+* en tiempo de compilación.
+*/
+bool pwm_calcFrequency(uint32_t frecuencia_hz, uint8_t bits_min, pwm_freq_t *resultado)
+{
+    uint8_t config = 0;
+    uint8_t preescala = 1;
+    uint16_t cuentas;
+    uint32_t divisor;
+    if(frecuencia_hz == 0)
+    {
+        return false;
+    }
+    //Preescala más pequeña con PRx + 1 <= 256: mayor número de cuentas por periodo
+    while(1)
+    {
+        divisor = 4UL * preescala * frecuencia_hz;
+        if(((_XTAL_FREQ) + (divisor >> 1)) / divisor <= 256)
+        {
+            break;
+        }
+        if(preescala >= PWM_PREESCALA_MAX)
+        {
+            return false;   //Frecuencia demasiado baja
+        }
+        preescala <<= 2;
+        config++;
+    }
+    cuentas = (uint16_t)(((_XTAL_FREQ) + (divisor >> 1)) / divisor);
+    if(cuentas == 0)
+    {
+        return false;       //Frecuencia demasiado alta
+    }
+    resultado->config_timer = config;
+    resultado->periodo = (uint8_t)(cuentas - 1);
+    resultado->preescala = preescala;
+    resultado->duty_max = cuentas << 2;
+    resultado->bits = _PWM_BITS(resultado->duty_max);
+    resultado->frecuencia = (_XTAL_FREQ) / ((uint32_t)cuentas * (4UL * preescala));
+    return resultado->bits >= bits_min;
+}
+
+/*
+* Función para cambiar la frecuencia de un temporizador base PWM en funcionamiento
+* Parámetros: 
+* timer: PWM_SYNC_TMR2, PWM_SYNC_TMR4 o PWM_SYNC_TMR6
+* frecuencia_hz: Frecuencia PWM deseada en [Hz]
+* bits_min: Resolución mínima aceptable del ciclo de trabajo en bits
+* resultado: Apuntador a estructura donde se devuelve la configuración obtenida
+* Retorno: 
+* true si se aplicó la nueva frecuencia, false si no es alcanzable (el temporizador no se modifica)
+* Nota: conserva la postescala y el estado de encendido del temporizador. Los ciclos de trabajo deben reescalarse
+* con resultado->duty_max, ya que el 100% cambia con PRx.
+*/
+bool pwm_setFrequency(uint8_t timer, uint32_t frecuencia_hz, uint8_t bits_min, pwm_freq_t *resultado)
+{
+    uint8_t gie;
+    if(!pwm_calcFrequency(frecuencia_hz, bits_min, resultado))
+    {
+        return false;
+    }
+    gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    switch(timer)
+    {
+        case PWM_SYNC_TMR2:
+            T2CON = (T2CON & 0xFC) | resultado->config_timer;
+            PR2 = resultado->periodo;
+            if(TMR2 > PR2) TMR2 = 0;   //Evita recorrer el conteo completo hasta 255
+            break;
+        #if defined (PWM_SYNC_TMR4)
+        case PWM_SYNC_TMR4:
+            T4CON = (T4CON & 0xFC) | resultado->config_timer;
+            PR4 = resultado->periodo;
+            if(TMR4 > PR4) TMR4 = 0;
+            break;
+        #endif
+        #if defined (PWM_SYNC_TMR6)
+        case PWM_SYNC_TMR6:
+            T6CON = (T6CON & 0xFC) | resultado->config_timer;
+            PR6 = resultado->periodo;
+            if(TMR6 > PR6) TMR6 = 0;
+            break;
+        #endif
+        default:
+            INTCONbits.GIE = gie;
+            return false;
+    }
+    INTCONbits.GIE = gie;
+    return true;
+}
+
 /*
 * Función para desactivar PWM
 * Parámetros: 
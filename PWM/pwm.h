@@ -200,6 +200,121 @@ Compilador: XC8
 #endif
 
 
+/*
+	Escritura de ciclo de trabajo de 10 bits en CCPRxL:CCPxCON<5:4>. El nuevo valor de CCPxCON se calcula antes de escribir
+	CCPRxL para que ambas escrituras queden consecutivas, y los bits DCxB<1:0> se reemplazan con máscara (no se acumulan con OR).
+	El hardware transfiere ambos registros a CCPRxH al final del periodo, por lo que la escritura no debe quedar partida por un
+	fin de periodo: para ello se usa pwm_waitPeriod o pwm_setDutyBulk.
+*/
+#define PWM_ESCRIBIR_DUTY(ccprl, ccpcon, duty)	do{ uint8_t _pwm_con = (uint8_t)(((ccpcon) & 0xCF) | (((duty) & 0x0003) << 4));\
+												(ccprl) = (uint8_t)((duty) >> 2); (ccpcon) = _pwm_con; }while(0)
+
+/*
+	Temporizadores de base de tiempo PWM disponibles para sincronización con fin de periodo
+*/
+#define PWM_SYNC_NINGUNO	0	//Sin sincronización: la actualización se aplica de inmediato
+#define PWM_SYNC_TMR2		2	//Sincronización con TMR2IF
+#if defined (PWM_V4) || defined (PWM_V9) || defined (PWM_V14) || defined (PWM_V14_1) || defined (PWM_V14_2) ||\
+	defined (PWM_V14_3) || defined (PWM_V14_4) || defined (PWM_V15) || defined (PWM_V15_1) ||\
+	defined (EPWM_V14) || defined (EPWM_V14_1) || defined (EPWM_V14_2) || defined (EPWM_V14_3) || defined (EPWM_V14_4) ||\
+	defined (EPWM_V15) || defined (EPWM_V15_1)
+#define PWM_SYNC_TMR4		4	//Sincronización con TMR4IF
+#endif
+#if defined (PWM_V14) || defined (PWM_V14_1) || defined (PWM_V14_3) || defined (PWM_V14_4) || defined (PWM_V15) || defined (PWM_V15_1) ||\
+	defined (EPWM_V14) || defined (EPWM_V14_1) || defined (EPWM_V14_3) || defined (EPWM_V14_4) || defined (EPWM_V15) || defined (EPWM_V15_1)
+#define PWM_SYNC_TMR6		6	//Sincronización con TMR6IF
+#endif
+
+/*
+	Función de establecimiento de ciclo de trabajo (pwmx_setDuty o epwmx_setDuty), para actualizaciones en bloque
+*/
+typedef void (*pwm_setDuty_t)(uint16_t duty);
+
+/*
+	Prototipos de funciones de sincronización y actualización en bloque
+*/
+void pwm_waitPeriod(uint8_t timer);
+
+void pwm_setDutyBulk(const pwm_setDuty_t *canales, const uint16_t *duties, uint8_t n, uint8_t timer);
+
+/*
+	Selección de preescala y registro de periodo a partir de una frecuencia en [Hz].
+	Fpwm = _XTAL_FREQ / (4 * preescala * (PRx + 1)), con resolución de ciclo de trabajo log2(4 * (PRx + 1)) bits.
+	La resolución máxima se obtiene con la preescala más pequeña cuyo PRx + 1 no exceda 256.
+	Las macros PWM_x(f) se reducen a constantes cuando f es constante, por ejemplo:
+		pwm1_init(PWM_CONFIG_TIMER(20000) | TIMER2_POST1, PWM_PERIODO(20000));
+	Las macros no detectan una frecuencia fuera de rango: PWM_PERIODO excedería 255 (o sería negativo) y se truncaría al
+	escribirse en PRx. Con frecuencias constantes se debe comprobar PWM_FRECUENCIA_VALIDA(f), por ejemplo:
+		#if !PWM_FRECUENCIA_VALIDA(20000)
+		#error "Frecuencia PWM fuera de rango"
+		#endif
+	(o definir PWM_FRECUENCIA_HZ, ver abajo). Para valores calculados en ejecución se usa pwm_calcFrequency, que
+	retorna false en ese caso. La asignación de temporizador a cada módulo CCP
+	se hace con el parámetro timer_source de pwmx_init o con setTimerCCPsource, según la versión.
+*/
+#ifndef PWM_PREESCALA_MAX
+#define PWM_PREESCALA_MAX	16		//Preescala máxima del temporizador; definir 64 en pconfig.h si el microcontrolador la soporta
+#endif
+
+#define _PWM_CUENTAS(f, p)	(((_XTAL_FREQ) + 2UL * (p) * (f)) / (4UL * (p) * (f)))		//PRx + 1 redondeado
+#define _PWM_BITS(d)		((d) >= 1024 ? 10 : (d) >= 512 ? 9 : (d) >= 256 ? 8 : (d) >= 128 ? 7 :\
+							 (d) >= 64 ? 6 : (d) >= 32 ? 5 : (d) >= 16 ? 4 : (d) >= 8 ? 3 : 2)
+
+#define PWM_PREESCALA(f)	(_PWM_CUENTAS(f, 1) <= 256 ? 1 : _PWM_CUENTAS(f, 4) <= 256 ? 4 :\
+							 (_PWM_CUENTAS(f, 16) <= 256 || PWM_PREESCALA_MAX < 64) ? 16 : 64)
+#define PWM_CONFIG_TIMER(f)	(PWM_PREESCALA(f) == 1 ? 0 : PWM_PREESCALA(f) == 4 ? 1 : PWM_PREESCALA(f) == 16 ? 2 : 3)	//Bits TxCKPS (TIMERx_DIV_y)
+#define PWM_PERIODO(f)		(_PWM_CUENTAS(f, PWM_PREESCALA(f)) - 1)									//Valor de PRx
+#define PWM_DUTY_MAX(f)		(4UL * _PWM_CUENTAS(f, PWM_PREESCALA(f)))								//Ciclo de trabajo de 100%
+#define PWM_BITS(f)			_PWM_BITS(PWM_DUTY_MAX(f))												//Resolución obtenida en bits
+#define PWM_FRECUENCIA(f)	((_XTAL_FREQ) / (4UL * PWM_PREESCALA(f) * _PWM_CUENTAS(f, PWM_PREESCALA(f))))	//Frecuencia obtenida en [Hz]
+#define PWM_FRECUENCIA_VALIDA(f)	(_PWM_CUENTAS(f, 1) >= 1 && _PWM_CUENTAS(f, PWM_PREESCALA_MAX) <= 256)	//PRx entre 0 y 255
+
+/*
+	Validación en tiempo de compilación. Se activa si la aplicación define PWM_FRECUENCIA_HZ (p. ej. en pconfig.h) y,
+	opcionalmente, PWM_BITS_MIN. Resultados: PWM_AUTO_CONFIG_TIMER, PWM_AUTO_PERIODO, PWM_AUTO_BITS y PWM_AUTO_FRECUENCIA.
+*/
+#if defined (PWM_FRECUENCIA_HZ)
+
+#if !defined (_XTAL_FREQ)
+#error "PWM_FRECUENCIA_HZ requiere _XTAL_FREQ"
+#endif
+#if (_PWM_CUENTAS(PWM_FRECUENCIA_HZ, 1) < 1)
+#error "PWM_FRECUENCIA_HZ demasiado alta para _XTAL_FREQ"
+#endif
+#if (_PWM_CUENTAS(PWM_FRECUENCIA_HZ, PWM_PREESCALA_MAX) > 256)
+#error "PWM_FRECUENCIA_HZ demasiado baja: PRx excede 255 con la preescala máxima"
+#endif
+
+#define PWM_AUTO_CONFIG_TIMER	PWM_CONFIG_TIMER(PWM_FRECUENCIA_HZ)
+#define PWM_AUTO_PERIODO		PWM_PERIODO(PWM_FRECUENCIA_HZ)
+#define PWM_AUTO_BITS			PWM_BITS(PWM_FRECUENCIA_HZ)
+#define PWM_AUTO_FRECUENCIA		PWM_FRECUENCIA(PWM_FRECUENCIA_HZ)
+
+#if defined (PWM_BITS_MIN) && (PWM_AUTO_BITS < PWM_BITS_MIN)
+#error "PWM_FRECUENCIA_HZ no alcanza la resolución PWM_BITS_MIN"
+#endif
+
+#endif
+
+/*
+	Resultado del cálculo de frecuencia PWM en ejecución
+*/
+typedef struct pwm_freq_t {
+	uint8_t config_timer;	//Bits de preescala TxCKPS, para combinar con la postescala en pwmx_init
+	uint8_t periodo;		//Valor de PRx
+	uint8_t preescala;		//Preescala elegida (1, 4, 16 o 64)
+	uint8_t bits;			//Resolución del ciclo de trabajo en bits
+	uint16_t duty_max;		//Ciclo de trabajo de 100%: 4 * (PRx + 1)
+	uint32_t frecuencia;	//Frecuencia obtenida en [Hz]
+} pwm_freq_t;
+
+/*
+	Prototipos de funciones de selección de frecuencia
+*/
+bool pwm_calcFrequency(uint32_t frecuencia_hz, uint8_t bits_min, pwm_freq_t *resultado);
+
+bool pwm_setFrequency(uint8_t timer, uint32_t frecuencia_hz, uint8_t bits_min, pwm_freq_t *resultado);
+
 /*
 	Prototipos de funciones para PWM 1
 */
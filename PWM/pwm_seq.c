@@ -0,0 +1,304 @@
+/**
+ * @file pwm_seq.c
+ * @brief Secuenciador de formas de onda para módulos CCP/ECCP en modo PWM: reproduce tablas de ciclo de trabajo almacenadas
+ * en memoria flash desde la interrupción de fin de periodo del temporizador base (Timer2/4/6), con modos cíclico y de
+ * un solo disparo, desfase entre canales y escalamiento de amplitud.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "pwm_seq.h"
+
+const uint8_t pwm_seq_tabla_seno[PWM_SEQ_LONGITUD_SENO] = {
+	128, 140, 153, 165, 177, 188, 199, 209, 218, 226, 234, 240, 245, 250, 253, 254,
+	255, 254, 253, 250, 245, 240, 234, 226, 218, 209, 199, 188, 177, 165, 153, 140,
+	128, 116, 103, 91, 79, 68, 57, 47, 38, 30, 22, 16, 11, 6, 3, 2,
+	1, 2, 3, 6, 11, 16, 22, 30, 38, 47, 57, 68, 79, 91, 103, 116
+};
+
+const uint8_t pwm_seq_tabla_rampa[PWM_SEQ_LONGITUD_RAMPA] = {
+	0, 4, 8, 12, 16, 20, 24, 28, 32, 36, 40, 44, 48, 52, 56, 60,
+	64, 68, 72, 76, 80, 84, 88, 92, 96, 100, 104, 108, 112, 116, 120, 124,
+	128, 132, 136, 140, 144, 148, 152, 156, 160, 164, 168, 172, 176, 180, 184, 188,
+	192, 196, 200, 204, 208, 212, 216, 220, 224, 228, 232, 236, 240, 244, 248, 252
+};
+
+/*
+    Estado de reproducción de un canal
+*/
+typedef struct pwm_seq_canal_t {
+	pwm_setDuty_t setDuty;							// NULL si el canal no está asignado
+	uint24_t tabla;									// Dirección de la tabla en memoria de programa
+	uint16_t longitud;
+	uint16_t fase;
+	uint16_t indice;								// Muestra a escribir en la siguiente actualización
+	uint8_t paso;
+	uint16_t escala;
+	uint16_t desplazamiento;
+	bool terminado;
+} pwm_seq_canal_t;
+
+static pwm_seq_canal_t _pwm_seq_canales[PWM_SEQ_MAX_CANALES];
+static uint8_t _pwm_seq_timer = PWM_SYNC_NINGUNO;					// Temporizador base
+static uint8_t _pwm_seq_modo = PWM_SEQ_CICLICO;
+static volatile bool _pwm_seq_terminado = false;
+
+/*
+    Lectura y escritura del bit de habilitación de interrupción del temporizador base
+*/
+static bool _pwm_seq_getIE(void)
+{
+	switch(_pwm_seq_timer)
+	{
+		case PWM_SYNC_TMR2: return TMR2IE;
+		#if defined (PWM_SYNC_TMR4)
+		case PWM_SYNC_TMR4: return TMR4IE;
+		#endif
+		#if defined (PWM_SYNC_TMR6)
+		case PWM_SYNC_TMR6: return TMR6IE;
+		#endif
+		default: return false;
+	}
+}
+
+static void _pwm_seq_setIE(bool ie)
+{
+	switch(_pwm_seq_timer)
+	{
+		case PWM_SYNC_TMR2: TMR2IE = ie; break;
+		#if defined (PWM_SYNC_TMR4)
+		case PWM_SYNC_TMR4: TMR4IE = ie; break;
+		#endif
+		#if defined (PWM_SYNC_TMR6)
+		case PWM_SYNC_TMR6: TMR6IE = ie; break;
+		#endif
+		default: break;
+	}
+}
+
+/*
+    Atención de la bandera del temporizador base: regresa true y la limpia si la interrupción está pendiente y habilitada
+*/
+static bool _pwm_seq_atenderIF(void)
+{
+	switch(_pwm_seq_timer)
+	{
+		case PWM_SYNC_TMR2:
+			if(!(TMR2IF && TMR2IE)) return false;
+			TMR2IF = 0;
+			return true;
+		#if defined (PWM_SYNC_TMR4)
+		case PWM_SYNC_TMR4:
+			if(!(TMR4IF && TMR4IE)) return false;
+			TMR4IF = 0;
+			return true;
+		#endif
+		#if defined (PWM_SYNC_TMR6)
+		case PWM_SYNC_TMR6:
+			if(!(TMR6IF && TMR6IE)) return false;
+			TMR6IF = 0;
+			return true;
+		#endif
+		default: return false;
+	}
+}
+
+/*
+    Posición inicial de un canal
+*/
+static void _pwm_seq_rebobinar(pwm_seq_canal_t *c)
+{
+	c->indice = c->fase;
+	c->terminado = false;
+}
+
+bool pwm_seq_init(uint8_t timer, uint8_t modo)
+{
+	uint8_t i;
+	if(modo != PWM_SEQ_CICLICO && modo != PWM_SEQ_UN_DISPARO)
+	{
+		return false;
+	}
+	switch(timer)
+	{
+		case PWM_SYNC_TMR2:
+		#if defined (PWM_SYNC_TMR4)
+		case PWM_SYNC_TMR4:
+		#endif
+		#if defined (PWM_SYNC_TMR6)
+		case PWM_SYNC_TMR6:
+		#endif
+			break;
+		default: return false;
+	}
+	_pwm_seq_setIE(false);	// Temporizador usado anteriormente
+	_pwm_seq_timer = timer;
+	_pwm_seq_setIE(false);
+	_pwm_seq_modo = modo;
+	_pwm_seq_terminado = false;
+	for(i = 0; i < PWM_SEQ_MAX_CANALES; i++)
+	{
+		_pwm_seq_canales[i].setDuty = NULL;
+	}
+	return true;
+}
+
+bool pwm_seq_setChannel(uint8_t canal, pwm_setDuty_t setDuty, uint32_t tabla, uint16_t longitud, uint16_t fase, uint8_t paso)
+{
+	pwm_seq_canal_t *c;
+	bool ie;
+	if(canal >= PWM_SEQ_MAX_CANALES || setDuty == NULL || longitud == 0 || fase >= longitud || paso == 0 || paso > longitud)
+	{
+		return false;
+	}
+	c = &_pwm_seq_canales[canal];
+	ie = _pwm_seq_getIE();
+	_pwm_seq_setIE(false);
+	c->tabla = (uint24_t)tabla;
+	c->longitud = longitud;
+	c->fase = fase;
+	c->paso = paso;
+	c->escala = 256;			// Por defecto el ciclo de trabajo es la muestra misma (8 bits)
+	c->desplazamiento = 0;
+	_pwm_seq_rebobinar(c);
+	c->setDuty = setDuty;
+	_pwm_seq_setIE(ie);
+	return true;
+}
+
+void pwm_seq_setAmplitude(uint8_t canal, uint16_t escala, uint16_t desplazamiento)
+{
+	bool ie;
+	if(canal >= PWM_SEQ_MAX_CANALES)
+	{
+		return;
+	}
+	ie = _pwm_seq_getIE();
+	_pwm_seq_setIE(false);
+	_pwm_seq_canales[canal].escala = escala;
+	_pwm_seq_canales[canal].desplazamiento = desplazamiento;
+	_pwm_seq_setIE(ie);
+}
+
+void pwm_seq_setStep(uint8_t canal, uint8_t paso)
+{
+	if(canal >= PWM_SEQ_MAX_CANALES || paso == 0 || paso > _pwm_seq_canales[canal].longitud)
+	{
+		return;
+	}
+	_pwm_seq_canales[canal].paso = paso;	// Escritura de 8 bits: no requiere sección crítica
+}
+
+void pwm_seq_removeChannel(uint8_t canal)
+{
+	bool ie;
+	if(canal >= PWM_SEQ_MAX_CANALES)
+	{
+		return;
+	}
+	ie = _pwm_seq_getIE();
+	_pwm_seq_setIE(false);
+	_pwm_seq_canales[canal].setDuty = NULL;
+	_pwm_seq_setIE(ie);
+}
+
+void pwm_seq_start(void)
+{
+	uint8_t i;
+	_pwm_seq_setIE(false);
+	for(i = 0; i < PWM_SEQ_MAX_CANALES; i++)
+	{
+		_pwm_seq_rebobinar(&_pwm_seq_canales[i]);
+	}
+	_pwm_seq_terminado = false;
+	pwm_seq_resume();
+}
+
+void pwm_seq_stop(void)
+{
+	_pwm_seq_setIE(false);
+}
+
+void pwm_seq_resume(void)
+{
+	if(_pwm_seq_terminado)
+	{
+		return;
+	}
+	// La primera actualización ocurre en el siguiente fin de periodo
+	switch(_pwm_seq_timer)
+	{
+		case PWM_SYNC_TMR2: TMR2IF = 0; break;
+		#if defined (PWM_SYNC_TMR4)
+		case PWM_SYNC_TMR4: TMR4IF = 0; break;
+		#endif
+		#if defined (PWM_SYNC_TMR6)
+		case PWM_SYNC_TMR6: TMR6IF = 0; break;
+		#endif
+		default: return;
+	}
+	_pwm_seq_setIE(true);
+	INTCONbits.PEIE = 1;
+}
+
+bool pwm_seq_done(void)
+{
+	return _pwm_seq_terminado;
+}
+
+void pwm_seq_interruptHandler(void)
+{
+	uint8_t i;
+	uint8_t tblptru, tblptrh, tblptrl, tablat;
+	bool activos = false;
+	if(!_pwm_seq_atenderIF())
+	{
+		return;
+	}
+	// Los apuntadores de tabla y TABLAT pueden estar en uso por el programa principal (flash_readByte, entre TBLRD y la
+	// lectura de TABLAT)
+	tblptru = TBLPTRU;
+	tblptrh = TBLPTRH;
+	tblptrl = TBLPTRL;
+	tablat = TABLAT;
+	for(i = 0; i < PWM_SEQ_MAX_CANALES; i++)
+	{
+		pwm_seq_canal_t *c = &_pwm_seq_canales[i];
+		uint24_t direccion;
+		uint8_t muestra;
+		if(c->setDuty == NULL || c->terminado)
+		{
+			continue;
+		}
+		direccion = c->tabla + c->indice;
+		flash_loadAddress(direccion);
+		flash_tableRead(muestra);
+		c->setDuty(c->desplazamiento + (uint16_t)(((uint24_t)muestra * c->escala) >> 8));
+		// Avance de posición
+		c->indice += c->paso;
+		if(c->indice >= c->longitud)
+		{
+			if(_pwm_seq_modo == PWM_SEQ_CICLICO)
+			{
+				c->indice -= c->longitud;
+			}
+			else
+			{
+				c->indice = c->longitud - 1;
+				c->terminado = true;	// La última muestra ya quedó escrita
+				continue;
+			}
+		}
+		activos = true;
+	}
+	TBLPTRU = tblptru;
+	TBLPTRH = tblptrh;
+	TBLPTRL = tblptrl;
+	TABLAT = tablat;
+	if(!activos && _pwm_seq_modo == PWM_SEQ_UN_DISPARO)
+	{
+		// Un disparo: todos los canales llegaron al final
+		_pwm_seq_terminado = true;
+		_pwm_seq_setIE(false);
+	}
+}
@@ -0,0 +1,114 @@
+/**
+ * @file pwm_seq.h
+ * @brief Secuenciador de formas de onda para módulos CCP/ECCP en modo PWM: reproduce tablas de ciclo de trabajo almacenadas
+ * en memoria flash desde la interrupción de fin de periodo del temporizador base (Timer2/4/6), con modos cíclico y de
+ * un solo disparo, desfase entre canales y escalamiento de amplitud.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef PWM_SEQ_H
+#define	PWM_SEQ_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "pconfig.h"
+#include "flash.h"
+#include "pwm.h"
+
+/**
+ * @brief Número máximo de canales reproducidos simultáneamente. Puede redefinirse en pconfig.h
+ */
+#ifndef PWM_SEQ_MAX_CANALES
+#define PWM_SEQ_MAX_CANALES		3
+#endif
+
+/*
+    Modos de reproducción
+*/
+#define PWM_SEQ_CICLICO			0	// Al llegar al final de la tabla se continúa desde el inicio
+#define PWM_SEQ_UN_DISPARO		1	// Al llegar al final de la tabla el canal conserva la última muestra
+
+/*
+    Tablas de 8 bits incluidas en memoria de programa (un periodo completo cada una)
+*/
+#define PWM_SEQ_LONGITUD_SENO	64
+#define PWM_SEQ_LONGITUD_RAMPA	64
+
+extern const uint8_t pwm_seq_tabla_seno[PWM_SEQ_LONGITUD_SENO];		// Seno desplazado: 128 + 127*sen(2*pi*n/64)
+extern const uint8_t pwm_seq_tabla_rampa[PWM_SEQ_LONGITUD_RAMPA];	// Diente de sierra: 0, 4, 8, ..., 252
+
+/**
+ * @brief Inicializa el secuenciador sin canales y con la interrupción del temporizador deshabilitada.
+ * El temporizador y los módulos PWM se configuran previamente con pwmx_init/epwmx_init; la frecuencia de
+ * actualización es la de TMRxIF, es decir, el periodo PWM dividido entre el postescalador del temporizador.
+ * @param timer Temporizador base: PWM_SYNC_TMR2, PWM_SYNC_TMR4 o PWM_SYNC_TMR6 según la versión
+ * @param modo PWM_SEQ_CICLICO o PWM_SEQ_UN_DISPARO
+ * @return (bool) true si los parámetros son válidos, false en caso contrario
+ */
+bool pwm_seq_init(uint8_t timer, uint8_t modo);
+
+/**
+ * @brief Asigna una tabla a un canal. Cada muestra de 8 bits se convierte en ciclo de trabajo como
+ * desplazamiento + (muestra * escala) / 256, de modo que escala = 4*(PRx+1) recorre el periodo completo.
+ * @param canal Posición del canal en el secuenciador (0 a PWM_SEQ_MAX_CANALES-1)
+ * @param setDuty Función pwmx_setDuty/epwmx_setDuty del módulo a controlar
+ * @param tabla Dirección de la tabla en memoria de programa (p.ej. (uint32_t)pwm_seq_tabla_seno para un arreglo const)
+ * @param longitud Número de muestras de la tabla (mayor que cero)
+ * @param fase Muestra inicial del canal, para desfasar canales que comparten tabla (p.ej. longitud/3 para trifásico)
+ * @param paso Muestras que avanza el canal por actualización (1 = todas las muestras); permite variar la frecuencia sin cambiar la tabla
+ * @return (bool) true si los parámetros son válidos, false en caso contrario
+ */
+bool pwm_seq_setChannel(uint8_t canal, pwm_setDuty_t setDuty, uint32_t tabla, uint16_t longitud, uint16_t fase, uint8_t paso);
+
+/**
+ * @brief Ajusta el escalamiento de amplitud de un canal. Puede llamarse durante la reproducción.
+ * @param canal Posición del canal en el secuenciador
+ * @param escala Ciclo de trabajo correspondiente a una muestra de 256 (amplitud)
+ * @param desplazamiento Ciclo de trabajo correspondiente a una muestra de 0 (nivel de referencia)
+ */
+void pwm_seq_setAmplitude(uint8_t canal, uint16_t escala, uint16_t desplazamiento);
+
+/**
+ * @brief Cambia el avance por actualización de un canal. Puede llamarse durante la reproducción.
+ * @param canal Posición del canal en el secuenciador
+ * @param paso Muestras que avanza el canal por actualización
+ */
+void pwm_seq_setStep(uint8_t canal, uint8_t paso);
+
+/**
+ * @brief Retira un canal del secuenciador. El módulo PWM conserva el último ciclo de trabajo escrito.
+ * @param canal Posición del canal en el secuenciador
+ */
+void pwm_seq_removeChannel(uint8_t canal);
+
+/**
+ * @brief Reinicia la posición de cada canal a su fase y habilita la interrupción del temporizador base
+ */
+void pwm_seq_start(void);
+
+/**
+ * @brief Deshabilita la interrupción del temporizador base. Los canales conservan su posición.
+ */
+void pwm_seq_stop(void);
+
+/**
+ * @brief Reanuda la reproducción desde la posición en la que se detuvo
+ */
+void pwm_seq_resume(void);
+
+/**
+ * @brief Indica si la secuencia terminó (modo PWM_SEQ_UN_DISPARO, todos los canales al final de su tabla)
+ * @return (bool) true si la secuencia terminó
+ */
+bool pwm_seq_done(void);
+
+/**
+ * @brief Función de manejo de interrupción del temporizador base. Debe llamarse desde la rutina de interrupción.
+ * Escribe el ciclo de trabajo de todos los canales, que el hardware aplica en el siguiente fin de periodo.
+ */
+void pwm_seq_interruptHandler(void);
+
+#endif	/* PWM_SEQ_H */
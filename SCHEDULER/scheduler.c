@@ -0,0 +1,183 @@
+/**
+ * @file scheduler.c
+ * @brief Planificador cooperativo de tareas de ejecución hasta terminar (run-to-completion): banderas de eventos activadas
+ * desde las interrupciones, lista de tareas ordenada por prioridad y función de reposo que lleva al microcontrolador a
+ * modo IDLE/SLEEP cuando no hay eventos pendientes. Opcionalmente mide el porcentaje de tiempo en reposo y la latencia y
+ * duración máximas de cada tarea.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "scheduler.h"
+
+static scheduler_tarea_t *_scheduler_lista = NULL;		// Tareas registradas, en orden de prioridad
+
+#if defined (SCHEDULER_MEDIR)
+static uint64_t _scheduler_inicio;						// Inicio de la ventana de medición
+static uint64_t _scheduler_reposo;						// Cuentas en reposo dentro de la ventana
+#endif
+
+void scheduler_init(void)
+{
+	uint8_t gie = INTCONbits.GIE;
+
+	INTCONbits.GIE = 0;
+	_scheduler_lista = NULL;
+	INTCONbits.GIE = gie;
+	#if defined (SCHEDULER_MEDIR)
+	scheduler_resetStats();
+	#endif
+}
+
+void scheduler_add(scheduler_tarea_t *tarea, scheduler_funcion_t funcion, void *contexto, uint8_t prioridad)
+{
+	scheduler_tarea_t **p;
+	uint8_t gie;
+
+	scheduler_remove(tarea);
+	tarea->funcion = funcion;
+	tarea->contexto = contexto;
+	tarea->prioridad = prioridad;
+	tarea->eventos = 0;
+	#if defined (SCHEDULER_MEDIR)
+	tarea->latencia_max = 0;
+	tarea->duracion_max = 0;
+	tarea->ejecuciones = 0;
+	#endif
+	gie = INTCONbits.GIE;
+	INTCONbits.GIE = 0;
+	for(p = &_scheduler_lista; *p != NULL && (*p)->prioridad <= prioridad; p = &(*p)->siguiente);
+	tarea->siguiente = *p;
+	*p = tarea;
+	INTCONbits.GIE = gie;
+}
+
+void scheduler_remove(scheduler_tarea_t *tarea)
+{
+	scheduler_tarea_t **p;
+	uint8_t gie = INTCONbits.GIE;
+
+	INTCONbits.GIE = 0;
+	for(p = &_scheduler_lista; *p != NULL; p = &(*p)->siguiente)
+	{
+		if(*p == tarea)
+		{
+			*p = tarea->siguiente;
+			break;
+		}
+	}
+	tarea->eventos = 0;
+	INTCONbits.GIE = gie;
+}
+
+void scheduler_signal(scheduler_tarea_t *tarea, uint8_t eventos)
+{
+	// Dentro de la interrupción GIE ya vale 0; fuera de ella se evita que una interrupción intercale su propia activación
+	uint8_t gie = INTCONbits.GIE;
+
+	INTCONbits.GIE = 0;
+	#if defined (SCHEDULER_MEDIR)
+	if(tarea->eventos == 0)
+		tarea->liberacion = uptime_getTicks32();
+	#endif
+	tarea->eventos |= eventos;
+	INTCONbits.GIE = gie;
+}
+
+void scheduler_timerCallback(void *contexto)
+{
+	scheduler_signal((scheduler_tarea_t *)contexto, SCHEDULER_EVENTO_TIEMPO);
+}
+
+bool scheduler_dispatch(void)
+{
+	scheduler_tarea_t *t;
+	uint8_t eventos, gie;
+	#if defined (SCHEDULER_MEDIR)
+	uint32_t inicio, cuentas;
+	#endif
+
+	for(t = _scheduler_lista; t != NULL && t->eventos == 0; t = t->siguiente);
+	if(t == NULL)
+		return false;
+	gie = INTCONbits.GIE;
+	INTCONbits.GIE = 0;
+	eventos = t->eventos;
+	t->eventos = 0;
+	#if defined (SCHEDULER_MEDIR)
+	inicio = uptime_getTicks32();
+	cuentas = inicio - t->liberacion;
+	#endif
+	INTCONbits.GIE = gie;
+	#if defined (SCHEDULER_MEDIR)
+	if(cuentas > t->latencia_max)
+		t->latencia_max = cuentas;
+	#endif
+	t->funcion(t, eventos);
+	#if defined (SCHEDULER_MEDIR)
+	cuentas = uptime_getTicks32() - inicio;
+	if(cuentas > t->duracion_max)
+		t->duracion_max = cuentas;
+	if(t->ejecuciones < 0xFFFF)
+		t->ejecuciones++;
+	#endif
+	return true;
+}
+
+void scheduler_idle(void)
+{
+	scheduler_tarea_t *t;
+	uint8_t gie = INTCONbits.GIE;
+	#if defined (SCHEDULER_MEDIR)
+	uint64_t inicio;
+	#endif
+
+	INTCONbits.GIE = 0;
+	for(t = _scheduler_lista; t != NULL && t->eventos == 0; t = t->siguiente);
+	if(t == NULL)
+	{
+		#if defined (SCHEDULER_MEDIR)
+		inicio = uptime_getTicks();
+		SCHEDULER_IDLE();
+		_scheduler_reposo += uptime_getTicks() - inicio;
+		#else
+		SCHEDULER_IDLE();
+		#endif
+	}
+	// La interrupción que despertó al microcontrolador se atiende aquí
+	INTCONbits.GIE = gie;
+}
+
+void scheduler_run(void)
+{
+	while(1)
+	{
+		if(!scheduler_dispatch())
+			scheduler_idle();
+	}
+}
+
+#if defined (SCHEDULER_MEDIR)
+uint16_t scheduler_getIdle(void)
+{
+	uint64_t total = uptime_getTicks() - _scheduler_inicio;
+
+	if(total == 0)
+		return 0;
+	return (uint16_t)(_scheduler_reposo * 1000 / total);
+}
+
+void scheduler_resetStats(void)
+{
+	scheduler_tarea_t *t;
+
+	for(t = _scheduler_lista; t != NULL; t = t->siguiente)
+	{
+		t->latencia_max = 0;
+		t->duracion_max = 0;
+		t->ejecuciones = 0;
+	}
+	_scheduler_reposo = 0;
+	_scheduler_inicio = uptime_getTicks();
+}
+#endif
@@ -0,0 +1,155 @@
+/**
+ * @file scheduler.h
+ * @brief Planificador cooperativo de tareas de ejecución hasta terminar (run-to-completion): banderas de eventos activadas
+ * desde las interrupciones, lista de tareas ordenada por prioridad y función de reposo que lleva al microcontrolador a
+ * modo IDLE/SLEEP cuando no hay eventos pendientes. Opcionalmente mide el porcentaje de tiempo en reposo y la latencia y
+ * duración máximas de cada tarea.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef SCHEDULER_H
+#define	SCHEDULER_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../pconfig.h"
+
+/*
+	Con SCHEDULER_MEDIR definido en pconfig.h se registran estadísticas con la base de tiempo de uptime (TIMERS/uptime.h),
+	que la aplicación debe inicializar con uptime_init.
+*/
+#if defined (SCHEDULER_MEDIR)
+#include "../TIMERS/uptime.h"
+#endif
+
+/**
+ * @brief Entrada a bajo consumo cuando no hay eventos pendientes. Se ejecuta con interrupciones deshabilitadas: cualquier
+ * interrupción habilitada individualmente despierta al microcontrolador y se atiende al regresar. Por omisión entra en
+ * modo IDLE (CPU detenida, periféricos y temporizadores con reloj). En versiones con el bit IDLEN en otro registro, o para
+ * usar SLEEP, puede redefinirse en pconfig.h.
+ */
+#ifndef SCHEDULER_IDLE
+#define SCHEDULER_IDLE()	do { OSCCONbits.IDLEN = 1; SLEEP(); NOP(); } while(0)
+#endif
+
+/**
+ * @brief Prioridades sugeridas. Un valor menor indica mayor prioridad.
+ */
+#define SCHEDULER_PRIORIDAD_URGENTE	0
+#define SCHEDULER_PRIORIDAD_ALTA	1
+#define SCHEDULER_PRIORIDAD_NORMAL	2
+#define SCHEDULER_PRIORIDAD_BAJA	3
+
+/**
+ * @brief Evento que activa scheduler_timerCallback. Los bits 0 a 6 quedan a disposición de la aplicación.
+ */
+#define SCHEDULER_EVENTO_TIEMPO		0x80
+
+struct scheduler_tarea_t;
+
+/**
+ * @brief Función de una tarea. Se ejecuta hasta terminar, sin bloquearse en espera de periféricos: la latencia máxima de
+ * cualquier tarea es la duración de la tarea más larga más la de las tareas de mayor prioridad.
+ * @param tarea Tarea en ejecución (su campo contexto queda a disposición de la función)
+ * @param eventos Eventos acumulados desde la ejecución anterior
+ */
+typedef void (*scheduler_funcion_t)(struct scheduler_tarea_t *tarea, uint8_t eventos);
+
+/**
+ * @brief Tarea. La aplicación reserva la estructura (típicamente estática) y no debe modificar sus campos, salvo contexto.
+ */
+typedef struct scheduler_tarea_t {
+	struct scheduler_tarea_t *siguiente;	// Lista ordenada por prioridad
+	scheduler_funcion_t funcion;
+	void *contexto;
+	volatile uint8_t eventos;				// Eventos pendientes
+	uint8_t prioridad;
+	#if defined (SCHEDULER_MEDIR)
+	volatile uint32_t liberacion;			// Marca de tiempo del primer evento pendiente
+	uint32_t latencia_max;					// Máximo tiempo entre evento e inicio de la tarea, en cuentas de uptime
+	uint32_t duracion_max;					// Máxima duración de la tarea, en cuentas de uptime
+	uint16_t ejecuciones;
+	#endif
+} scheduler_tarea_t;
+
+/*
+	Ejemplo de integración de los servicios del repositorio:
+
+	- Pila TCP/IP: Network_Manage se sondea desde una tarea activada por un soft_timer periódico (y opcionalmente por la
+	  interrupción del ENC28J60), p.ej. soft_timer_create(&t_red, scheduler_timerCallback, &tarea_red).
+	- Serial: la rutina de interrupción llama a serial_interruptHandler y a scheduler_signal(&tarea_serial, EV_RX); la tarea
+	  consume serial_dataAvailable bytes con serial_readByteBuffer en lugar de bloquearse en serial_gets.
+	- I²C: la función callback de cada trabajo de i2c_sched (o transacción de i2c_async) señala a la tarea consumidora, y la
+	  interrupción del temporizador del sistema llama a i2c_sched_tick, que arranca los trabajos vencidos.
+	- ADC: la función registrada con adc_scan_setCallback pasa las muestras a adc_pipeline_feed y señala a la tarea que
+	  consume adc_pipeline_read, en lugar de esperar en adc_read.
+*/
+
+/**
+ * @brief Vacía la lista de tareas y reinicia las estadísticas
+ */
+void scheduler_init(void);
+
+/**
+ * @brief Registra una tarea. Tareas de igual prioridad se atienden en orden de registro.
+ * @param tarea Tarea
+ * @param funcion Función de la tarea
+ * @param contexto Apuntador a disposición de la función
+ * @param prioridad Prioridad (0 = máxima)
+ */
+void scheduler_add(scheduler_tarea_t *tarea, scheduler_funcion_t funcion, void *contexto, uint8_t prioridad);
+
+/**
+ * @brief Retira una tarea de la lista y descarta sus eventos pendientes
+ * @param tarea Tarea
+ */
+void scheduler_remove(scheduler_tarea_t *tarea);
+
+/**
+ * @brief Activa eventos de una tarea. Puede llamarse desde la interrupción o desde otra tarea.
+ * @param tarea Tarea
+ * @param eventos Bits de eventos a activar
+ */
+void scheduler_signal(scheduler_tarea_t *tarea, uint8_t eventos);
+
+/**
+ * @brief Función de notificación para soft_timer: activa SCHEDULER_EVENTO_TIEMPO en la tarea recibida como contexto
+ * @param contexto Tarea (scheduler_tarea_t *)
+ */
+void scheduler_timerCallback(void *contexto);
+
+/**
+ * @brief Ejecuta la tarea de mayor prioridad con eventos pendientes
+ * @return (bool) true si se ejecutó una tarea, false si no había eventos pendientes
+ */
+bool scheduler_dispatch(void);
+
+/**
+ * @brief Entra en reposo con SCHEDULER_IDLE si no hay eventos pendientes. La verificación y la entrada se hacen con
+ * interrupciones deshabilitadas, de modo que un evento activado entre ambas no se pierde.
+ */
+void scheduler_idle(void);
+
+/**
+ * @brief Ciclo principal: ejecuta tareas mientras haya eventos y entra en reposo en caso contrario. No regresa.
+ * Las interrupciones deben estar habilitadas.
+ */
+void scheduler_run(void);
+
+#if defined (SCHEDULER_MEDIR)
+/**
+ * @brief Fracción del tiempo en reposo desde scheduler_init o scheduler_resetStats
+ * @return (uint16_t) Tiempo en reposo en décimas de porcentaje (0 a 1000)
+ */
+uint16_t scheduler_getIdle(void);
+
+/**
+ * @brief Reinicia la medición de reposo y las estadísticas de todas las tareas
+ */
+void scheduler_resetStats(void);
+#endif
+
+#endif	/* SCHEDULER_H */
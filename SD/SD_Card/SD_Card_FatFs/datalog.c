@@ -0,0 +1,311 @@
+/**
+ * @file datalog.c
+ * @brief Registro de datos de sólo anexado sobre FatFs: archivo preasignado en clusters contiguos que se escribe por
+ * sectores completos directamente en su rango de LBA, con registros binarios compactos agrupados en bloques de un sector.
+ * Durante el registro no se modifican la FAT ni la entrada de directorio; los sectores escritos se confirman en la
+ * tarjeta periódicamente y el final del registro se localiza al abrirlo por búsqueda binaria.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include <string.h>
+#include <stdbool.h>
+#include "datalog.h"
+
+#define _DATALOG_FIRMA_ENCABEZADO	14		// Bytes del sector 0 cubiertos por su CRC
+
+static WORD _datalog_crc16(WORD crc, const BYTE *datos, UINT n)
+{
+	// CRC16 CCITT (polinomio 0x1021), el mismo que usa la tarjeta en los bloques de datos
+	BYTE i;
+
+	while(n--)
+	{
+		crc ^= (WORD)*datos++ << 8;
+		for(i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+	}
+	return crc;
+}
+
+static void _datalog_put16(BYTE *p, WORD valor)
+{
+	p[0] = (BYTE)valor;
+	p[1] = (BYTE)(valor >> 8);
+}
+
+static void _datalog_put32(BYTE *p, DWORD valor)
+{
+	_datalog_put16(p, (WORD)valor);
+	_datalog_put16(p + 2, (WORD)(valor >> 16));
+}
+
+static WORD _datalog_get16(const BYTE *p)
+{
+	return (WORD)p[0] | ((WORD)p[1] << 8);
+}
+
+static DWORD _datalog_get32(const BYTE *p)
+{
+	return (DWORD)_datalog_get16(p) | ((DWORD)_datalog_get16(p + 2) << 16);
+}
+
+static FRESULT _datalog_read(datalog_t *d, DWORD sector)
+{
+	return disk_read(d->archivo.fs->drv, d->bloque, d->lba + sector, 1) == RES_OK ? FR_OK : FR_DISK_ERR;
+}
+
+static FRESULT _datalog_write(datalog_t *d, DWORD sector)
+{
+	return disk_write(d->archivo.fs->drv, d->bloque, d->lba + sector, 1) == RES_OK ? FR_OK : FR_DISK_ERR;
+}
+
+static bool _datalog_valid(datalog_t *d, DWORD indice)
+{
+	// Bloque de datos de esta sesión, en su posición y completo
+	const BYTE *b = d->bloque;
+	UINT usados;
+
+	if(_datalog_read(d, indice) != FR_OK)
+		return false;
+	usados = _datalog_get16(b + 10);
+	return b[0] == 'D' && b[1] == 'L' && _datalog_get32(b + 2) == d->sesion && _datalog_get32(b + 6) == indice &&
+		usados <= DATALOG_CARGA &&
+		_datalog_crc16(_datalog_crc16(0, b, 12), b + DATALOG_ENCABEZADO, usados) == _datalog_get16(b + 12);
+}
+
+static FRESULT _datalog_contiguous(datalog_t *d)
+{
+	// Recorre la cadena de clusters con f_lseek (posición 1 de cada cluster, de modo que clust sea ese cluster)
+	FIL *f = &d->archivo;
+	DWORD bcs = (DWORD)f->fs->csize * 512, n, clusters;
+	FRESULT res = FR_OK;
+
+	if(f->sclust == 0)
+		return FR_DENIED;
+	clusters = (f->fsize + bcs - 1) / bcs;
+	for(n = 0; n < clusters && res == FR_OK; n++)
+	{
+		res = f_lseek(f, n * bcs + 1);
+		if(res == FR_OK && f->clust != f->sclust + n)
+			res = FR_DENIED;
+	}
+	d->lba = f->fs->database + (f->sclust - 2) * f->fs->csize;
+	return res;
+}
+
+static FRESULT _datalog_create(datalog_t *d, DWORD tamano)
+{
+	FIL *f = &d->archivo;
+	BYTE *b = d->bloque;
+	FRESULT res;
+
+	// Encabezado y al menos un bloque de datos
+	tamano = (tamano + 511) & ~(DWORD)511;
+	if(tamano < 1024)
+		tamano = 1024;
+	res = f_lseek(f, tamano);
+	if(res == FR_OK && f->fsize != tamano)
+		res = FR_DENIED;							// Sin espacio libre
+	if(res == FR_OK)
+		res = f_sync(f);
+	if(res == FR_OK)
+		res = _datalog_contiguous(d);
+	if(res != FR_OK)
+		return res;
+	// La sesión nueva difiere de la del contenido previo del sector 0, de modo que los bloques de un registro anterior en
+	// los mismos clusters no se confunden con los de éste
+	if((res = _datalog_read(d, 0)) != FR_OK)
+		return res;
+	d->sesion = _datalog_get32(b + 6) + 1;
+	d->capacidad = tamano / 512 - 1;
+	memset(b, 0, 512);
+	memcpy(b, "DLOG", 4);
+	b[4] = DATALOG_VERSION;
+	_datalog_put32(b + 6, d->sesion);
+	_datalog_put32(b + 10, d->capacidad);
+	_datalog_put16(b + 14, _datalog_crc16(0, b, _DATALOG_FIRMA_ENCABEZADO));
+	return _datalog_write(d, 0);
+}
+
+static FRESULT _datalog_resume(datalog_t *d)
+{
+	BYTE *b = d->bloque;
+	DWORD valido, invalido, medio;
+	FRESULT res;
+
+	if((res = _datalog_contiguous(d)) != FR_OK)
+		return res;
+	if((res = _datalog_read(d, 0)) != FR_OK)
+		return res;
+	if(memcmp(b, "DLOG", 4) != 0 || b[4] != DATALOG_VERSION ||
+		_datalog_crc16(0, b, _DATALOG_FIRMA_ENCABEZADO) != _datalog_get16(b + 14))
+		return FR_INVALID_OBJECT;
+	d->sesion = _datalog_get32(b + 6);
+	d->capacidad = _datalog_get32(b + 10);
+	if(d->capacidad > d->archivo.fsize / 512 - 1)
+		return FR_INVALID_OBJECT;
+	// Los bloques válidos forman un prefijo: búsqueda binaria del último
+	valido = 0;
+	invalido = d->capacidad + 1;
+	while(invalido - valido > 1)
+	{
+		medio = valido + (invalido - valido) / 2;
+		if(_datalog_valid(d, medio))
+			valido = medio;
+		else
+			invalido = medio;
+	}
+	// Continúa llenando el último bloque
+	if(valido != 0 && _datalog_valid(d, valido))
+	{
+		d->indice = valido;
+		d->usados = _datalog_get16(b + 10);
+	}
+	else
+	{
+		d->indice = 1;
+		d->usados = 0;
+		memset(b, 0, 512);
+	}
+	return FR_OK;
+}
+
+static void _datalog_seal(datalog_t *d)
+{
+	BYTE *b = d->bloque;
+
+	b[0] = 'D';
+	b[1] = 'L';
+	_datalog_put32(b + 2, d->sesion);
+	_datalog_put32(b + 6, d->indice);
+	_datalog_put16(b + 10, (WORD)d->usados);
+	_datalog_put16(b + 12, _datalog_crc16(_datalog_crc16(0, b, 12), b + DATALOG_ENCABEZADO, d->usados));
+}
+
+#if _SD_ASYNC
+static FRESULT _datalog_wait(datalog_t *d)
+{
+	// Sólo espera si la tarjeta es más lenta que el registro
+	while(d->peticion.busy)
+		disk_poll();
+	return d->peticion.res == RES_OK ? FR_OK : FR_DISK_ERR;
+}
+#endif
+
+static FRESULT _datalog_send(datalog_t *d)
+{
+	// Bloque completo
+	#if _SD_ASYNC
+	FRESULT res = _datalog_wait(d);
+
+	if(res != FR_OK)
+		return res;
+	_datalog_seal(d);
+	memcpy(d->envio, d->bloque, 512);
+	d->peticion.buff = d->envio;
+	d->peticion.sector = d->lba + d->indice;
+	d->peticion.write = 1;
+	d->peticion.done = NULL;
+	disk_submit(&d->peticion);
+	return FR_OK;
+	#else
+	_datalog_seal(d);
+	return _datalog_write(d, d->indice);
+	#endif
+}
+
+static FRESULT _datalog_commit(datalog_t *d, DWORD indice)
+{
+	#if _SD_ASYNC
+	FRESULT res = _datalog_wait(d);
+
+	if(res != FR_OK)
+		return res;
+	#endif
+	// Con la caché de diskio habilitada los sectores pueden seguir en RAM hasta CTRL_SYNC
+	if(disk_ioctl(d->archivo.fs->drv, CTRL_SYNC, 0) != RES_OK)
+		return FR_DISK_ERR;
+	d->confirmado = indice;
+	return FR_OK;
+}
+
+FRESULT datalog_open(datalog_t *d, const TCHAR *ruta, DWORD tamano)
+{
+	FRESULT res;
+
+	#if _SD_ASYNC
+	d->peticion.busy = 0;
+	d->peticion.res = RES_OK;
+	#endif
+	res = f_open(&d->archivo, ruta, FA_OPEN_ALWAYS | FA_READ | FA_WRITE);
+	if(res != FR_OK)
+		return res;
+	if(d->archivo.fsize == 0)
+	{
+		res = _datalog_create(d, tamano);
+		d->indice = 1;
+		d->usados = 0;
+		memset(d->bloque, 0, 512);
+	}
+	else
+		res = _datalog_resume(d);
+	d->confirmado = d->indice - 1;
+	if(res != FR_OK)
+		f_close(&d->archivo);
+	return res;
+}
+
+FRESULT datalog_write(datalog_t *d, BYTE tipo, DWORD marca, const void *datos, BYTE longitud)
+{
+	BYTE *p;
+	FRESULT res;
+
+	if(d->usados + DATALOG_REGISTRO + longitud > DATALOG_CARGA)
+	{
+		// Bloque completo: un sector entero, directo a su LBA
+		if(d->indice > d->capacidad)
+			return FR_DENIED;
+		if((res = _datalog_send(d)) != FR_OK)
+			return res;
+		if(d->indice - d->confirmado >= DATALOG_CONFIRMAR && (res = _datalog_commit(d, d->indice)) != FR_OK)
+			return res;
+		d->indice++;
+		d->usados = 0;
+		memset(d->bloque, 0, 512);
+	}
+	if(d->indice > d->capacidad)
+		return FR_DENIED;
+	p = d->bloque + DATALOG_ENCABEZADO + d->usados;
+	p[0] = longitud;
+	p[1] = tipo;
+	_datalog_put32(p + 2, marca);
+	memcpy(p + DATALOG_REGISTRO, datos, longitud);
+	d->usados += DATALOG_REGISTRO + longitud;
+	return FR_OK;
+}
+
+FRESULT datalog_flush(datalog_t *d)
+{
+	FRESULT res;
+
+	if(d->usados == 0 || d->indice > d->capacidad)
+		return _datalog_commit(d, d->indice - 1);		// Sólo bloques completos pendientes
+	_datalog_seal(d);
+	if((res = _datalog_write(d, d->indice)) != FR_OK)
+		return res;
+	return _datalog_commit(d, d->indice);
+}
+
+FRESULT datalog_close(datalog_t *d)
+{
+	FRESULT res = datalog_flush(d);
+	FRESULT res_cierre = f_close(&d->archivo);
+
+	return res != FR_OK ? res : res_cierre;
+}
+
+DWORD datalog_free(const datalog_t *d)
+{
+	return d->indice > d->capacidad ? 0 : d->capacidad - d->indice;
+}
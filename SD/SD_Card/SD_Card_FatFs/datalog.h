@@ -0,0 +1,124 @@
+/**
+ * @file datalog.h
+ * @brief Registro de datos de sólo anexado sobre FatFs: archivo preasignado en clusters contiguos que se escribe por
+ * sectores completos directamente en su rango de LBA, con registros binarios compactos agrupados en bloques de un sector.
+ * Durante el registro no se modifican la FAT ni la entrada de directorio; los sectores escritos se confirman en la
+ * tarjeta periódicamente y el final del registro se localiza al abrirlo por búsqueda binaria.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef DATALOG_H
+#define	DATALOG_H
+
+#include "ff.h"
+#include "diskio.h"
+
+/*
+	Formato del archivo (enteros en little endian)
+
+	Sector 0, encabezado (escrito al crear el archivo):
+		0	"DLOG"
+		4	Versión (DATALOG_VERSION)
+		5	Reservado
+		6	Sesión (DWORD): distingue los sectores de este archivo de datos previos en los mismos clusters
+		10	Capacidad en sectores de datos (DWORD)
+		14	CRC16 (CCITT) de los bytes 0 a 13
+
+	Sectores 1 a capacidad, bloques de datos:
+		0	"DL"
+		2	Sesión (DWORD)
+		6	Índice del sector (DWORD, 1 el primero)
+		10	Bytes de registros en el bloque (WORD)
+		12	CRC16 (CCITT) de los bytes 0 a 11 y de los registros
+		14	Registros
+
+	Registro (DATALOG_REGISTRO bytes + datos; un registro nunca cruza un sector):
+		0	Longitud de los datos (BYTE)
+		1	Tipo (BYTE, definido por la aplicación)
+		2	Marca de tiempo (DWORD, definida por la aplicación)
+		6	Datos
+
+	Los bloques válidos (sesión, índice y CRC correctos) forman un prefijo del archivo; el registro termina en el último
+	de ellos. host/datalog_lector.c extrae los registros de una copia del archivo.
+*/
+
+#define DATALOG_VERSION		1
+#define DATALOG_ENCABEZADO	14		// Bytes del encabezado de un bloque de datos
+#define DATALOG_REGISTRO	6		// Bytes del encabezado de un registro
+#define DATALOG_CARGA		(512 - DATALOG_ENCABEZADO)
+
+/**
+ * @brief Sectores escritos entre confirmaciones (CTRL_SYNC, que vacía la caché de sectores de diskio). Acota los datos
+ * que pueden perderse ante una falla de alimentación.
+ */
+#ifndef DATALOG_CONFIRMAR
+#define DATALOG_CONFIRMAR	16
+#endif
+
+/**
+ * @brief Registro de datos. La aplicación reserva la estructura (típicamente estática) y no debe modificar sus campos.
+ * Con _SD_ASYNC (diskio.h) los bloques completos se escriben mediante la cola de diskio desde un segundo buffer, de modo
+ * que datalog_write no espera a la tarjeta; la aplicación debe llamar a disk_poll en su ciclo principal.
+ */
+typedef struct datalog_t {
+	FIL archivo;
+	DWORD lba;				// Sector del encabezado
+	DWORD capacidad;		// Sectores de datos
+	DWORD indice;			// Sector de datos en llenado (1 a capacidad)
+	DWORD confirmado;		// Último sector de datos confirmado
+	DWORD sesion;
+	UINT usados;			// Bytes de registros en el bloque
+	BYTE bloque[512];		// Sector en llenado
+	#if _SD_ASYNC
+	BYTE envio[512];		// Bloque completo en escritura
+	DISK_REQ peticion;
+	#endif
+} datalog_t;
+
+/**
+ * @brief Abre o crea un registro de datos. Un archivo nuevo se preasigna con el tamaño indicado (extendiéndolo con
+ * f_lseek) y se verifica que sus clusters sean contiguos; un archivo existente continúa a partir de su último bloque
+ * válido. El bloque del registro se usa como buffer de lectura durante la búsqueda.
+ * @param d Registro de datos
+ * @param ruta Ruta del archivo
+ * @param tamano Tamaño en bytes del archivo nuevo (se ignora si el archivo existe)
+ * @return (FRESULT) FR_OK, FR_DENIED si no hay clusters contiguos suficientes, FR_INVALID_OBJECT si el archivo existe y
+ * no es un registro de datos, o el error de FatFs
+ */
+FRESULT datalog_open(datalog_t *d, const TCHAR *ruta, DWORD tamano);
+
+/**
+ * @brief Agrega un registro. Sólo escribe en la tarjeta cuando el registro no cabe en el sector en llenado (un sector
+ * completo), y confirma cada DATALOG_CONFIRMAR sectores.
+ * @param d Registro de datos
+ * @param tipo Tipo del registro
+ * @param marca Marca de tiempo
+ * @param datos Datos del registro
+ * @param longitud Bytes de datos (hasta 255)
+ * @return (FRESULT) FR_OK, FR_DENIED si el archivo está lleno o el error de escritura
+ */
+FRESULT datalog_write(datalog_t *d, BYTE tipo, DWORD marca, const void *datos, BYTE longitud);
+
+/**
+ * @brief Escribe el sector en llenado aunque esté incompleto (se completará en escrituras posteriores) y lo confirma
+ * @param d Registro de datos
+ * @return (FRESULT) FR_OK o el error de escritura
+ */
+FRESULT datalog_flush(datalog_t *d);
+
+/**
+ * @brief Vacía el registro con datalog_flush y cierra el archivo
+ * @param d Registro de datos
+ * @return (FRESULT) FR_OK o el error de escritura
+ */
+FRESULT datalog_close(datalog_t *d);
+
+/**
+ * @brief Sectores de datos libres
+ * @param d Registro de datos
+ * @return (DWORD) Sectores libres, sin contar el sector en llenado
+ */
+DWORD datalog_free(const datalog_t *d);
+
+#endif	/* DATALOG_H */
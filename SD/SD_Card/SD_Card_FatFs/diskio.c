@@ -12,7 +12,12 @@
 /-------------------------------------------------------------------------*/
 
 #include "diskio.h"
+#ifdef _SD_HOST
+#include "host/sd_modelo.h"		/* SD card model for the host benchmarks */
+#else
 #include "mcc_generated_files/mcc.h"
+#endif
+#include <string.h>
 #ifdef __XC16
 #ifndef FCY
 #define FCY (_XTAL_FREQ/2)
@@ -30,6 +35,7 @@
 /* Definitions for MMC/SDC command */
 #define CMD0	(0)			/* GO_IDLE_STATE */
 #define CMD1	(1)			/* SEND_OP_COND (MMC) */
+#define CMD6	(6)			/* SWITCH_FUNC (SDC) */
 #define	ACMD41	(0x80+41)	/* SEND_OP_COND (SDC) */
 #define CMD8	(8)			/* SEND_IF_COND */
 #define CMD9	(9)			/* SEND_CSD */
@@ -64,6 +70,46 @@ DSTATUS Stat = STA_NOINIT;	/* Disk status */
 static
 BYTE CardType;			/* Card type flags */
 
+static
+DWORD SpiClock;			/* SPI clock after initialization (Hz) */
+
+#if _SD_ASYNC
+#define AS_READY	1		/* Waiting for the card to leave the busy state */
+#define AS_TOKEN	2		/* Waiting for the data token of a read */
+
+static
+DISK_REQ *ReqHead, *ReqTail;	/* Request queue */
+
+static
+BYTE ReqState;			/* State of the request at the head of the queue */
+
+static volatile
+BYTE ReqTimer;			/* 10ms decrement timer of the request in progress */
+#endif
+
+#if _SD_CACHE
+#define CF_VALID	0x01		/* Cache line holds a sector */
+#define CF_DIRTY	0x02		/* Cache line is newer than the card */
+
+static
+BYTE CacheBuf[_SD_CACHE][512];	/* Cached sector data */
+
+static
+DWORD CacheSect[_SD_CACHE];		/* Sector number (LBA) of each line */
+
+static
+BYTE CacheFlag[_SD_CACHE];		/* Line status flags */
+
+static
+BYTE CacheAge[_SD_CACHE];		/* LRU order (0:most recently used) */
+
+static
+DWORD PinStart, PinCount;		/* Sector range preferred to stay in the cache (FAT area) */
+
+static
+DWORD CacheStat[4];				/* Hits, misses, sectors read, sectors written */
+#endif
+
 
 
 /*-----------------------------------------------------------------------*/
@@ -76,8 +122,12 @@ BYTE wait_ready (void)	/* 1:Ready, 0:Timeout */
 	UINT tmr;
 
 
+	for (tmr = 1000; tmr; tmr--) {	/* Poll back-to-back first: short busy times end without a 100us step */
+		if (sd_rx() == 0xFF) return 1;
+	}
 	for (tmr = 5000; tmr; tmr--) {	/* Wait for ready in timeout of 500ms */
 		if (sd_rx() == 0xFF) break;
+		sd_idle();
 		__delay_us(100);
 	}
 
@@ -117,42 +167,118 @@ BYTE select (void)	/* 1:Successful, 0:Timeout */
 
 
 /*-----------------------------------------------------------------------*/
-/* Receive a data packet from MMC                                        */
+/* CRC16 (CCITT, x^16+x^12+x^5+1) of data blocks                         */
+/*-----------------------------------------------------------------------*/
+
+#if _SD_CRC
+#define CRC16_UPDATE(crc, d) {						\
+	crc = (WORD)((crc >> 8) | (crc << 8)) ^ (d);	\
+	crc ^= (BYTE)crc >> 4;							\
+	crc ^= crc << 12;								\
+	crc ^= (WORD)(BYTE)crc << 5;					\
+}
+#else
+#define CRC16_UPDATE(crc, d)
+#endif
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Wait for a data token                                                 */
 /*-----------------------------------------------------------------------*/
 
 static
-BYTE rcvr_datablock (
-	BYTE *buff,			/* Data buffer to store received data */
-	UINT btr			/* Byte count (must be multiple of 4) */
-)
+BYTE rcvr_token (void)	/* Returns the token, 0xFF on timeout */
 {
 	BYTE token;
 	UINT tmr;
 
 
+	for (tmr = 1000; tmr; tmr--) {	/* Poll back-to-back first: the token usually comes within the read latency of the card */
+		token = sd_rx();
+		if (token != 0xFF) return token;
+	}
 	for (tmr = 2000; tmr; tmr--) {	/* Wait for data packet in timeout of 200ms */
 		token = sd_rx();
 		if (token != 0xFF) break;
+		sd_idle();
 		__delay_us(100);
 	}
-	if (token != 0xFE) return 0;	/* If not valid data token, retutn with error */
 
-	do
-		*buff++ = sd_rx();		/* Receive the data block into buffer */
-	while (--btr);
-	sd_rx();					/* Discard CRC */
+	return token;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Receive a data packet from MMC                                        */
+/*-----------------------------------------------------------------------*/
+
+/* Each byte is stored while the next one is being shifted in */
+#define RCVR_BYTE() {		\
+	sd_wait();				\
+	d = sd_get();			\
+	sd_put(0xFF);			\
+	*buff++ = d;			\
+	CRC16_UPDATE(crc, d);	\
+}
+
+static
+BYTE rcvr_data (		/* Data block following the data token */
+	BYTE *buff,			/* Data buffer to store received data */
+	UINT btr			/* Byte count (must be multiple of 4) */
+)
+{
+	BYTE d;
+#if _SD_CRC
+	WORD crc = 0, rcrc;
+#endif
+
+
+	sd_put(0xFF);				/* Start the first byte */
+	do {						/* Receive the data block into buffer */
+		RCVR_BYTE(); RCVR_BYTE(); RCVR_BYTE(); RCVR_BYTE();
+	} while (btr -= 4);
+	sd_wait();					/* CRC (the first byte was started by the last iteration) */
+	d = sd_get();
+#if _SD_CRC
+	rcrc = (WORD)d << 8;
+	rcrc |= sd_rx();
+	if (rcrc != crc) return 0;	/* If CRC error, return with error */
+#else
 	sd_rx();
+#endif
 
 	return 1;					/* Return with success */
 }
 
 
+static
+BYTE rcvr_datablock (
+	BYTE *buff,			/* Data buffer to store received data */
+	UINT btr			/* Byte count (must be multiple of 4) */
+)
+{
+	if (rcvr_token() != 0xFE) return 0;	/* If not valid data token, retutn with error */
+
+	return rcvr_data(buff, btr);
+}
+
+
 
 /*-----------------------------------------------------------------------*/
 /* Send a data packet to MMC                                             */
 /*-----------------------------------------------------------------------*/
 
 #if	_USE_WRITE
+/* The pointer is advanced while the byte is being shifted out */
+#define XMIT_BYTE() {		\
+	sd_put(*buff);			\
+	buff++;					\
+	sd_wait();				\
+	(void)sd_get();			\
+}
+
 static
 BYTE xmit_datablock (
 	const BYTE *buff,	/* 512 byte data block to be transmitted */
@@ -167,10 +293,10 @@ BYTE xmit_datablock (
 
 	sd_tx(token);			/* Xmit data token */
 	if (token != 0xFD) {	/* Is data token */
-		i = 512;
-		do
-			sd_tx(*buff++);				/* Xmit the data block to the MMC */
-		while (--i);
+		i = 512 / 4;
+		do {								/* Xmit the data block to the MMC */
+			XMIT_BYTE(); XMIT_BYTE(); XMIT_BYTE(); XMIT_BYTE();
+		} while (--i);
 		sd_rx();						/* CRC (Dummy) */
 		sd_rx();
 		resp = sd_rx();					/* Reveive data response */
@@ -284,6 +410,394 @@ BYTE send_cmd (		/* Returns R1 resp (bit7==1:Send failed) */
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Read sectors from the card                                            */
+/*-----------------------------------------------------------------------*/
+
+static
+DRESULT read_blocks (
+	BYTE *buff,			/* Pointer to the data buffer to store read data */
+	DWORD sector,		/* Start sector number (LBA) */
+	UINT count			/* Sector count (1..128) */
+)
+{
+	BYTE cmd;
+
+
+#if _SD_CACHE
+	CacheStat[2] += count;
+#endif
+	if (!(CardType & CT_BLOCK)) sector *= 512;	/* Convert to byte address if needed */
+
+	cmd = count > 1 ? CMD18 : CMD17;			/*  READ_MULTIPLE_BLOCK : READ_SINGLE_BLOCK */
+	if (send_cmd(cmd, sector) == 0) {
+		do {
+			if (!rcvr_datablock(buff, 512)) break;
+			buff += 512;
+		} while (--count);
+		if (cmd == CMD18) send_cmd(CMD12, 0);	/* STOP_TRANSMISSION */
+	}
+	deselect();
+
+	return count ? RES_ERROR : RES_OK;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Write sectors to the card                                             */
+/*-----------------------------------------------------------------------*/
+
+#if _USE_WRITE
+static
+DRESULT write_blocks (
+	const BYTE *buff,	/* Pointer to the data to be written */
+	DWORD sector,		/* Start sector number (LBA) */
+	UINT count			/* Sector count (1..128) */
+)
+{
+#if _SD_CACHE
+	CacheStat[3] += count;
+#endif
+	if (!(CardType & CT_BLOCK)) sector *= 512;	/* Convert to byte address if needed */
+
+	if (count == 1) {	/* Single block write */
+		if ((send_cmd(CMD24, sector) == 0)	/* WRITE_BLOCK */
+			&& xmit_datablock(buff, 0xFE))
+			count = 0;
+	}
+	else {				/* Multiple block write */
+		if (CardType & CT_SDC) send_cmd(ACMD23, count);
+		if (send_cmd(CMD25, sector) == 0) {	/* WRITE_MULTIPLE_BLOCK */
+			do {
+				if (!xmit_datablock(buff, 0xFC)) break;
+				buff += 512;
+			} while (--count);
+			if (!xmit_datablock(0, 0xFD))	/* STOP_TRAN token */
+				count = 1;
+		}
+	}
+	deselect();
+
+	return count ? RES_ERROR : RES_OK;
+}
+#endif
+
+
+
+#if _SD_CACHE
+/*-----------------------------------------------------------------------*/
+/* Sector cache                                                          */
+/*-----------------------------------------------------------------------*/
+
+static
+void cache_clear (void)
+{
+	BYTE ln;
+
+
+	for (ln = 0; ln < _SD_CACHE; ln++) {
+		CacheFlag[ln] = 0;
+		CacheAge[ln] = ln;
+	}
+}
+
+
+static
+BYTE cache_find (	/* Returns the line holding the sector, _SD_CACHE if not cached */
+	DWORD sector
+)
+{
+	BYTE ln;
+
+
+	for (ln = 0; ln < _SD_CACHE; ln++) {
+		if ((CacheFlag[ln] & CF_VALID) && CacheSect[ln] == sector) break;
+	}
+	return ln;
+}
+
+
+static
+void cache_touch (	/* Make the line the most recently used */
+	BYTE ln
+)
+{
+	BYTE i;
+
+
+	for (i = 0; i < _SD_CACHE; i++) {
+		if (CacheAge[i] < CacheAge[ln]) CacheAge[i]++;
+	}
+	CacheAge[ln] = 0;
+}
+
+
+static
+BYTE cache_victim (void)	/* Free line, else least recently used out of the pinned range, else least recently used */
+{
+	BYTE ln, lru = 0, lru_free = _SD_CACHE;
+
+
+	for (ln = 0; ln < _SD_CACHE; ln++) {
+		if (!(CacheFlag[ln] & CF_VALID)) return ln;
+		if (CacheAge[ln] > CacheAge[lru]) lru = ln;
+		if (CacheSect[ln] - PinStart >= PinCount
+			&& (lru_free == _SD_CACHE || CacheAge[ln] > CacheAge[lru_free])) lru_free = ln;
+	}
+	return lru_free < _SD_CACHE ? lru_free : lru;
+}
+
+
+#if _USE_WRITE
+static
+DRESULT cache_flush (	/* Write back the run of contiguous dirty lines containing the line */
+	BYTE ln
+)
+{
+	DWORD first, last, sect;
+	BYTE i, n, ok;
+
+
+	first = last = CacheSect[ln];
+	while ((i = cache_find(first - 1)) < _SD_CACHE && (CacheFlag[i] & CF_DIRTY)) first--;
+	while ((i = cache_find(last + 1)) < _SD_CACHE && (CacheFlag[i] & CF_DIRTY)) last++;
+	n = (BYTE)(last - first + 1);
+
+	sect = (CardType & CT_BLOCK) ? first : first * 512;	/* Convert to byte address if needed */
+	ok = 0;
+	if (n == 1) {		/* Single block write */
+		if ((send_cmd(CMD24, sect) == 0)	/* WRITE_BLOCK */
+			&& xmit_datablock(CacheBuf[ln], 0xFE))
+			ok = 1;
+	}
+	else {				/* Multiple block write from each line of the run */
+		if (CardType & CT_SDC) send_cmd(ACMD23, n);	/* Pre-erase */
+		if (send_cmd(CMD25, sect) == 0) {	/* WRITE_MULTIPLE_BLOCK */
+			for (sect = first; sect <= last; sect++) {
+				if (!xmit_datablock(CacheBuf[cache_find(sect)], 0xFC)) break;
+			}
+			if (xmit_datablock(0, 0xFD) && sect > last)	/* STOP_TRAN token */
+				ok = 1;
+		}
+	}
+	deselect();
+	if (!ok) return RES_ERROR;
+
+	for (sect = first; sect <= last; sect++) CacheFlag[cache_find(sect)] &= ~CF_DIRTY;
+	CacheStat[3] += n;
+
+	return RES_OK;
+}
+
+
+static
+DRESULT cache_sync (void)	/* Write back all dirty lines */
+{
+	BYTE ln;
+
+
+	for (ln = 0; ln < _SD_CACHE; ln++) {
+		if ((CacheFlag[ln] & CF_DIRTY) && cache_flush(ln) != RES_OK) return RES_ERROR;
+	}
+	return RES_OK;
+}
+#endif
+
+
+static
+BYTE cache_load (	/* Returns a line for the sector (loaded from the card if read), _SD_CACHE on error */
+	DWORD sector,
+	BYTE read
+)
+{
+	BYTE ln;
+
+
+	ln = cache_find(sector);
+	if (ln < _SD_CACHE) {
+		CacheStat[0]++;
+	} else {
+		CacheStat[1]++;
+		ln = cache_victim();
+#if _USE_WRITE
+		if ((CacheFlag[ln] & CF_DIRTY) && cache_flush(ln) != RES_OK) return _SD_CACHE;
+#endif
+		CacheFlag[ln] = 0;
+		if (read && read_blocks(CacheBuf[ln], sector, 1) != RES_OK) return _SD_CACHE;
+		CacheSect[ln] = sector;
+		CacheFlag[ln] = CF_VALID;
+	}
+	cache_touch(ln);
+
+	return ln;
+}
+
+
+static
+DRESULT cache_read (
+	BYTE *buff,
+	DWORD sector
+)
+{
+	BYTE ln;
+
+
+	ln = cache_load(sector, 1);
+	if (ln == _SD_CACHE) return RES_ERROR;
+	memcpy(buff, CacheBuf[ln], 512);
+
+	return RES_OK;
+}
+
+
+static
+void cache_overlay (	/* Copy dirty lines over sectors read directly from the card */
+	BYTE *buff,
+	DWORD sector,
+	UINT count
+)
+{
+	BYTE ln;
+
+
+	for (ln = 0; ln < _SD_CACHE; ln++) {
+		if ((CacheFlag[ln] & CF_DIRTY) && CacheSect[ln] - sector < count)
+			memcpy(buff + (UINT)(CacheSect[ln] - sector) * 512, CacheBuf[ln], 512);
+	}
+}
+
+
+#if _USE_WRITE
+static
+DRESULT cache_write (
+	const BYTE *buff,
+	DWORD sector
+)
+{
+	BYTE ln;
+
+
+	ln = cache_load(sector, 0);	/* The whole sector is replaced: no need to read it */
+	if (ln == _SD_CACHE) return RES_ERROR;
+	memcpy(CacheBuf[ln], buff, 512);
+	CacheFlag[ln] |= CF_DIRTY;
+
+	return RES_OK;
+}
+
+
+static
+void cache_discard (	/* Drop lines of sectors written directly to the card */
+	DWORD sector,
+	UINT count
+)
+{
+	BYTE ln;
+
+
+	for (ln = 0; ln < _SD_CACHE; ln++) {
+		if (CacheSect[ln] - sector < count) CacheFlag[ln] = 0;
+	}
+}
+#endif
+#endif
+
+
+
+#if _SD_ASYNC
+/*-----------------------------------------------------------------------*/
+/* Non-blocking sector requests                                          */
+/*-----------------------------------------------------------------------*/
+
+static
+void req_done (
+	DRESULT res		/* Result of the request at the head of the queue */
+)
+{
+	DISK_REQ *req = ReqHead;
+
+
+	deselect();
+	ReqState = 0;
+	ReqHead = req->next;
+	if (!ReqHead) ReqTail = 0;
+	req->res = res;
+	req->busy = 0;
+	if (req->done) req->done(req);
+}
+
+
+static
+void req_step (void)	/* Advance the request at the head of the queue without waiting for the card */
+{
+	DISK_REQ *req = ReqHead;
+	DWORD sect;
+	BYTE d;
+
+
+	switch (ReqState) {
+	case 0:				/* Start */
+#if _SD_CACHE
+		if (!req->write && cache_find(req->sector) != _SD_CACHE) {	/* Cache hit */
+			req_done(cache_read(req->buff, req->sector));
+			return;
+		}
+		if (req->write) cache_discard(req->sector, 1);	/* The cached copy is superseded */
+#endif
+		ReqTimer = 50;		/* Ready in timeout of 500ms */
+		ReqState = AS_READY;
+		/* Fall through */
+
+	case AS_READY:		/* One poll per step; the bus is released while the card is busy */
+		SD_CS_SetLow();
+		sd_rx();
+		if (sd_rx() != 0xFF) {
+			if (ReqTimer) deselect();
+			else req_done(RES_ERROR);
+			return;
+		}
+		sect = req->sector;
+		if (!(CardType & CT_BLOCK)) sect *= 512;	/* Convert to byte address if needed */
+		if (send_cmd(req->write ? CMD24 : CMD17, sect) != 0) {
+			req_done(RES_ERROR);
+			return;
+		}
+		if (req->write) {	/* Done when the block is accepted; the card programs it until the next request */
+#if _SD_CACHE
+			CacheStat[3]++;
+#endif
+			req_done(xmit_datablock(req->buff, 0xFE) ? RES_OK : RES_ERROR);
+			return;
+		}
+		ReqTimer = 20;		/* Data token in timeout of 200ms */
+		ReqState = AS_TOKEN;
+		return;
+
+	case AS_TOKEN:		/* The card stays selected until the data block */
+		d = sd_rx();
+		if (d == 0xFF) {
+			if (!ReqTimer) req_done(RES_ERROR);
+			return;
+		}
+#if _SD_CACHE
+		CacheStat[2]++;
+#endif
+		req_done(d == 0xFE && rcvr_data(req->buff, 512) ? RES_OK : RES_ERROR);
+		return;
+	}
+}
+
+
+static
+void req_drain (void)	/* Complete the queued requests before a blocking access */
+{
+	while (disk_poll()) ;
+}
+#endif
+
+
+
 /*--------------------------------------------------------------------------
 
    Public Functions
@@ -291,6 +805,89 @@ BYTE send_cmd (		/* Returns R1 resp (bit7==1:Send failed) */
 ---------------------------------------------------------------------------*/
 
 
+/*-----------------------------------------------------------------------*/
+/* Raise the SPI clock to the fastest rate of the host and the card      */
+/*-----------------------------------------------------------------------*/
+
+static
+const BYTE TranValue[16] = { 0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80 };	/* TRAN_SPEED time value x10 */
+
+static
+DWORD tran_speed (	/* Returns the maximum clock of the card in Hz */
+	const BYTE *csd	/* CSD */
+)
+{
+	DWORD f = 10000;	/* Rate unit 0: 100kbit/s, divided by 10 for the time value */
+	BYTE n;
+
+
+	for (n = csd[3] & 7; n && n < 4; n--) f *= 10;
+	return f * TranValue[(csd[3] >> 3) & 15];
+}
+
+
+static
+DWORD set_clock (	/* Returns the SPI clock in Hz */
+	DWORD fmax		/* Maximum clock */
+)
+{
+	DWORD div = (SD_FOSC + fmax - 1) / fmax;	/* Minimum divider of Fosc */
+
+
+	if (div <= 4) {
+		sd_clock(SD_SSPM_4, 0);
+		return SD_FOSC / 4;
+	}
+	div = (div + 3) / 4;			/* SSPxADD + 1 */
+	if (div < 4) {					/* SSPxADD below 3 is not supported in SPI mode */
+		sd_clock(SD_SSPM_16, 0);
+		return SD_FOSC / 16;
+	}
+	if (div > 256) div = 256;
+	sd_clock(SD_SSPM_ADD, (BYTE)(div - 1));
+	return SD_FOSC / (4 * div);
+}
+
+
+#if _SD_HS
+static
+BYTE switch_hs (void)	/* 1:The card is in high speed mode */
+{
+	BYTE st[64];
+
+
+	/* Switch function group 1 (access mode) to 1 (high speed) and check the result in the status */
+	if (send_cmd(CMD6, 0x80FFFFF1) != 0 || !rcvr_datablock(st, 64)) return 0;
+	return (st[16] & 0x0F) == 1;
+}
+#endif
+
+
+static
+BYTE fast_clock (void)	/* 1:Successful, 0:The card can not be read back */
+{
+	BYTE csd[16], chk[16];
+	DWORD f;
+
+
+	if (send_cmd(CMD9, 0) != 0 || !rcvr_datablock(csd, 16)) return 0;	/* CSD at the identification clock */
+	f = tran_speed(csd);
+#if _SD_HS
+	if ((CardType & CT_SDC) && (csd[4] & 0x40) && f < SD_FOSC / 4 && switch_hs()) {	/* Command class 10 (switch)? */
+		if (send_cmd(CMD9, 0) != 0 || !rcvr_datablock(csd, 16)) return 0;	/* TRAN_SPEED in high speed mode */
+		f = tran_speed(csd);
+	}
+#endif
+	for (;;) {	/* Read the CSD back at the new clock and step down on mismatch */
+		SpiClock = set_clock(f);
+		if (send_cmd(CMD9, 0) == 0 && rcvr_datablock(chk, 16) && !memcmp(chk, csd, 16)) return 1;
+		if (SpiClock <= 400000) return 0;
+		f = SpiClock / 2;
+	}
+}
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Initialize Disk Drive                                                 */
 /*-----------------------------------------------------------------------*/
@@ -307,7 +904,14 @@ DSTATUS disk_initialize (
 
 	if (Stat & STA_NODISK) return Stat;	/* No card in the socket */
 
+#if _SD_CACHE
+	cache_clear();		/* Sectors of a previous card are not valid */
+#endif
+#if _SD_ASYNC
+	while (ReqHead) req_done(RES_NOTRDY);	/* Requests for a previous card */
+#endif
 	sd_init();
+	set_clock(400000);		/* Identification clock */
 	select();
 	for (n = 10; n; n--) sd_rx();	/* 80 dummy clocks */
 
@@ -340,11 +944,11 @@ DSTATUS disk_initialize (
 		}
 	}
 	CardType = ty;
+	if (ty && !fast_clock()) CardType = ty = 0;	/* Raise the SPI clock */
 	deselect();
 
 	if (ty) {			/* Initialization succeded */
 		Stat &= ~STA_NOINIT;		/* Clear STA_NOINIT */
-		sd_open();
 	}
 
 	return Stat;
@@ -377,25 +981,26 @@ DRESULT disk_read (
 	UINT count			/* Sector count (1..128) */
 )
 {
-	BYTE cmd;
+#if _SD_CACHE
+	DRESULT res;
+#endif
 
 
 	if (pdrv || !count) return RES_PARERR;
 	if (Stat & STA_NOINIT) return RES_NOTRDY;
 
-	if (!(CardType & CT_BLOCK)) sector *= 512;	/* Convert to byte address if needed */
-
-	cmd = count > 1 ? CMD18 : CMD17;			/*  READ_MULTIPLE_BLOCK : READ_SINGLE_BLOCK */
-	if (send_cmd(cmd, sector) == 0) {
-		do {
-			if (!rcvr_datablock(buff, 512)) break;
-			buff += 512;
-		} while (--count);
-		if (cmd == CMD18) send_cmd(CMD12, 0);	/* STOP_TRANSMISSION */
-	}
-	deselect();
+#if _SD_ASYNC
+	req_drain();
+#endif
+#if _SD_CACHE
+	if (count == 1) return cache_read(buff, sector);	/* Single sector through the cache */
 
-	return count ? RES_ERROR : RES_OK;
+	res = read_blocks(buff, sector, count);		/* Multiple sectors direct to the buffer */
+	if (res == RES_OK) cache_overlay(buff, sector, count);	/* Dirty lines are newer than the card */
+	return res;
+#else
+	return read_blocks(buff, sector, count);
+#endif
 }
 
 
@@ -416,27 +1021,15 @@ DRESULT disk_write (
 	if (Stat & STA_NOINIT) return RES_NOTRDY;
 	if (Stat & STA_PROTECT) return RES_WRPRT;
 
-	if (!(CardType & CT_BLOCK)) sector *= 512;	/* Convert to byte address if needed */
-
-	if (count == 1) {	/* Single block write */
-		if ((send_cmd(CMD24, sector) == 0)	/* WRITE_BLOCK */
-			&& xmit_datablock(buff, 0xFE))
-			count = 0;
-	}
-	else {				/* Multiple block write */
-		if (CardType & CT_SDC) send_cmd(ACMD23, count);
-		if (send_cmd(CMD25, sector) == 0) {	/* WRITE_MULTIPLE_BLOCK */
-			do {
-				if (!xmit_datablock(buff, 0xFC)) break;
-				buff += 512;
-			} while (--count);
-			if (!xmit_datablock(0, 0xFD))	/* STOP_TRAN token */
-				count = 1;
-		}
-	}
-	deselect();
+#if _SD_ASYNC
+	req_drain();
+#endif
+#if _SD_CACHE
+	if (count == 1) return cache_write(buff, sector);	/* Single sector into the cache */
 
-	return count ? RES_ERROR : RES_OK;
+	cache_discard(sector, count);	/* Cached copies are superseded */
+#endif
+	return write_blocks(buff, sector, count);
 }
 #endif
 
@@ -455,6 +1048,9 @@ DRESULT disk_ioctl (
 	DRESULT res;
 	BYTE n, csd[16], *ptr = buff;
 	DWORD csize;
+#if _SD_CRC
+	BYTE sdstat[64];
+#endif
 
 
 	if (pdrv) return RES_PARERR;
@@ -463,8 +1059,15 @@ DRESULT disk_ioctl (
 
 	if (Stat & STA_NOINIT) return RES_NOTRDY;
 
+#if _SD_ASYNC
+	req_drain();
+#endif
+
 	switch (cmd) {
 	case CTRL_SYNC :		/* Make sure that no pending write process. Do not remove this or written sector might not left updated. */
+#if _SD_CACHE && _USE_WRITE
+		if (cache_sync() != RES_OK) break;	/* Write back the cache */
+#endif
 		if (select()) res = RES_OK;
 		break;
 
@@ -486,11 +1089,18 @@ DRESULT disk_ioctl (
 		if (CardType & CT_SD2) {	/* SDv2? */
 			if (send_cmd(ACMD13, 0) == 0) {	/* Read SD status */
 				sd_rx();
+#if _SD_CRC
+				if (rcvr_datablock(sdstat, 64)) {			/* Read whole block for the CRC check */
+					*(DWORD*)buff = 16UL << (sdstat[10] >> 4);
+					res = RES_OK;
+				}
+#else
 				if (rcvr_datablock(csd, 16)) {				/* Read partial block */
 					for (n = 64 - 16; n; n--) sd_rx();	/* Purge trailing data */
 					*(DWORD*)buff = 16UL << (csd[10] >> 4);
 					res = RES_OK;
 				}
+#endif
 			}
 		} else {					/* SDv1 or MMCv3 */
 			if ((send_cmd(CMD9, 0) == 0) && rcvr_datablock(csd, 16)) {	/* Read CSD */
@@ -538,6 +1148,24 @@ DRESULT disk_ioctl (
 		}
 		break;
 
+	case MMC_GET_CLOCK :	/* Get SPI clock (DWORD) */
+		*(DWORD*)buff = SpiClock;
+		res = RES_OK;
+		break;
+
+#if _SD_CACHE
+	case MMC_CACHE_PIN :	/* Set sector range preferred to stay in the cache (DWORD[2]) */
+		PinStart = ((DWORD*)buff)[0];
+		PinCount = ((DWORD*)buff)[1];
+		res = RES_OK;
+		break;
+
+	case MMC_CACHE_STAT :	/* Get cache statistics (DWORD[4]) */
+		for (n = 0; n < 4; n++) ((DWORD*)buff)[n] = CacheStat[n];
+		res = RES_OK;
+		break;
+#endif
+
 	default:
 		res = RES_PARERR;
 	}
@@ -547,3 +1175,53 @@ DRESULT disk_ioctl (
 	return res;
 }
 #endif
+
+
+
+#if _SD_ASYNC
+/*-----------------------------------------------------------------------*/
+/* Queue a Sector Request                                                */
+/*-----------------------------------------------------------------------*/
+
+void disk_submit (
+	DISK_REQ *req		/* Request (buff, sector, write and done set by the caller) */
+)
+{
+	req->next = 0;
+	req->busy = 1;
+	if (ReqTail) ReqTail->next = req;
+	else ReqHead = req;
+	ReqTail = req;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Advance the Request Queue                                             */
+/*-----------------------------------------------------------------------*/
+
+BYTE disk_poll (void)	/* 1:Requests pending */
+{
+	if (!ReqHead) return 0;
+	if (Stat & STA_NOINIT) req_done(RES_NOTRDY);
+	else req_step();
+
+	return ReqHead ? 1 : 0;
+}
+
+
+
+/*-----------------------------------------------------------------------*/
+/* Device Timer Interrupt Procedure                                      */
+/*-----------------------------------------------------------------------*/
+/* This function must be called in period of 10ms for the timeouts of    */
+/* the request queue                                                     */
+
+void disk_timerproc (void)
+{
+	BYTE n = ReqTimer;
+
+
+	if (n) ReqTimer = --n;
+}
+#endif
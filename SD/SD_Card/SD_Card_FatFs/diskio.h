@@ -12,6 +12,37 @@ extern "C" {
 #define _USE_WRITE	1	/* 1: Enable disk_write function */
 #define _USE_IOCTL	1	/* 1: Enable disk_ioctl fucntion */
 
+#ifndef _SD_CACHE
+#define _SD_CACHE	0
+#endif
+/* Number of 512-byte sectors in the write-back sector cache under disk_read/disk_write.
+/  Single-sector accesses (the FatFs window) are served from the cache with LRU replacement
+/  and dirty sectors are written back in runs of contiguous sectors with CMD25.
+/  Each sector takes 512 bytes of RAM.
+/
+/   0: Disabled
+/   1 or more: Number of cached sectors */
+
+#ifndef _SD_CRC
+#define _SD_CRC		0
+#endif
+/* 1: Check the CRC16 of every received data block (computed while the block is received) */
+
+#ifndef _SD_ASYNC
+#define _SD_ASYNC	0
+#endif
+/* 1: Enable the non-blocking request queue (disk_submit/disk_poll/disk_timerproc).
+/  Single-sector reads and writes advance one step per disk_poll call and never wait
+/  for the card; the SPI bus is released while the card programs a written block.
+/  disk_read, disk_write and disk_ioctl complete the queued requests first. */
+
+#ifndef _SD_HS
+#define _SD_HS		0
+#endif
+/* 1: Switch SD cards to high speed mode (CMD6) when the SPI clock of the host exceeds
+/  the default speed of the card (25MHz). Not needed on PIC18, whose SPI clock is
+/  limited to Fosc/4 (16MHz at 64MHz). */
+
 #define _SD_SPI 1
 /* This option defines the SPI port to be used.
 /
@@ -34,6 +65,21 @@ typedef enum {
 	RES_PARERR		/* 4: Invalid Parameter */
 } DRESULT;
 
+#if _SD_ASYNC
+/* Sector request for disk_submit */
+typedef struct _DISK_REQ {
+	struct _DISK_REQ *next;	/* Queue link (used by the driver) */
+	BYTE *buff;				/* 512-byte data buffer, untouched until completion */
+	DWORD sector;			/* Sector number (LBA) */
+	BYTE write;				/* 0:Read, 1:Write */
+	BYTE busy;				/* 1 while queued or in progress */
+	DRESULT res;			/* Result */
+	void (*done)(struct _DISK_REQ *req);	/* Completion callback called from disk_poll (0:None),
+											   must not call the disk functions */
+	void *ctx;				/* Free for the caller */
+} DISK_REQ;
+#endif
+
 
 /*---------------------------------------*/
 /* Prototypes for disk control functions */
@@ -44,6 +90,11 @@ DSTATUS disk_status (BYTE pdrv);
 DRESULT disk_read (BYTE pdrv, BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_write (BYTE pdrv, const BYTE* buff, DWORD sector, UINT count);
 DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
+#if _SD_ASYNC
+void disk_submit (DISK_REQ* req);
+BYTE disk_poll (void);
+void disk_timerproc (void);
+#endif
 
 
 /* Disk Status Bits (DSTATUS) */
@@ -74,6 +125,9 @@ DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 #define MMC_GET_CID			12	/* Get CID */
 #define MMC_GET_OCR			13	/* Get OCR */
 #define MMC_GET_SDSTAT		14	/* Get SD status */
+#define MMC_CACHE_PIN		15	/* Set sector range preferred to stay in the cache (DWORD[2]: start, count) */
+#define MMC_CACHE_STAT		16	/* Get cache statistics (DWORD[4]: hits, misses, sectors read, sectors written) */
+#define MMC_GET_CLOCK		17	/* Get SPI clock negotiated by disk_initialize in Hz (DWORD) */
 
 /* ATA/CF specific ioctl command */
 #define ATA_GET_REV			20	/* Get F/W revision */
@@ -85,27 +139,54 @@ DRESULT disk_ioctl (BYTE pdrv, BYTE cmd, void* buff);
 /* PIC18 SPI definitions and functions */
 
 /* Note: sd_init() must open SPI at a speed between 100-400 KHz */
+/* sd_put/sd_wait/sd_get access the MSSP directly for the data block loops */
+/* sd_clock(sspm, add) disables the MSSP, sets the SPI clock and enables it again:
+/  SSPM = SD_SSPM_4 (Fosc/4), SD_SSPM_16 (Fosc/16) or SD_SSPM_ADD (Fosc/(4*(SSPxADD+1)), SSPxADD >= 3) */
+
+/* sd_idle() is called between the 100us polls of the blocking waits for the card. It can
+/  run short jobs that do not use the card (e.g. servicing a network controller). */
+
+#ifndef sd_idle
+#define sd_idle()
+#endif
+
+#ifndef SD_FOSC
+#define SD_FOSC		_XTAL_FREQ	/* Clock of the MSSP (Fosc) in Hz */
+#endif
+
+#define SD_SSPM_4	0x00
+#define SD_SSPM_16	0x01
+#define SD_SSPM_ADD	0x0A
 
 #if _SD_SPI == 1
 
 #define sd_init()	SPI1_Initialize()
-#define sd_open()	SPI1_Open()
+#define sd_clock(sspm, add)	{ SSP1CON1 = (sspm); SSP1ADD = (add); SSP1CON1 = 0x20 | (sspm); }
 #define sd_tx(d)	SPI1_Exchange8bit(d)
 #define sd_rx()		SPI1_Exchange8bit(0xFF)
+#define sd_put(d)	(SSP1BUF = (d))		/* Start a byte transfer */
+#define sd_wait()	while (!SSP1STATbits.BF)	/* Wait for the transfer to complete */
+#define sd_get()	(SSP1BUF)			/* Received byte (clears BF) */
 
 #elif _SD_SPI == 2
 
 #define sd_init()	SPI2_Initialize()
-#define sd_open()	SPI2_Open()
+#define sd_clock(sspm, add)	{ SSP2CON1 = (sspm); SSP2ADD = (add); SSP2CON1 = 0x20 | (sspm); }
 #define sd_tx(d)	SPI2_Exchange8bit(d)
 #define sd_rx()		SPI2_Exchange8bit(0xFF)
+#define sd_put(d)	(SSP2BUF = (d))		/* Start a byte transfer */
+#define sd_wait()	while (!SSP2STATbits.BF)	/* Wait for the transfer to complete */
+#define sd_get()	(SSP2BUF)			/* Received byte (clears BF) */
 
 #else
 
 #define sd_init()	SPI_Initialize()
-#define sd_open()	SPI_Open()
+#define sd_clock(sspm, add)	{ SSPCON1 = (sspm); SSPADD = (add); SSPCON1 = 0x20 | (sspm); }
 #define sd_tx(d)	SPI_Exchange8bit(d)
 #define sd_rx()		SPI_Exchange8bit(0xFF)
+#define sd_put(d)	(SSPBUF = (d))		/* Start a byte transfer */
+#define sd_wait()	while (!SSPSTATbits.BF)	/* Wait for the transfer to complete */
+#define sd_get()	(SSPBUF)			/* Received byte (clears BF) */
 
 #endif
 
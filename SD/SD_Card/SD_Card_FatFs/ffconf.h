@@ -4,18 +4,72 @@
 
 #define _FFCONF 64180	/* Revision ID */
 
+/*---------------------------------------------------------------------------/
+/ Configuration Profiles
+/---------------------------------------------------------------------------*/
+
+#ifndef _FS_PROFILE
+#define _FS_PROFILE	2
+#endif
+/* This option selects a set of the options below. All profiles use 8.3 names
+/  (_USE_LFN 0) and the shared sector buffer in FATFS unless noted.
+/
+/   0: Custom. The values written below are used.
+/   1: Minimal read-only. f_open(), f_read(), f_lseek() and f_close() only,
+/      ASCII names (_CODE_PAGE 1). Smallest code.
+/   2: Logger. Read/write with f_lseek() (_FS_MINIMIZE 2), ASCII names. Enough
+/      for main.c and datalog.c.
+/   3: Full. All basic functions, directories, f_mkfs(), string functions and
+/      U.S. code page (437). Each FIL gets its own sector buffer (_FS_TINY 0):
+/      512 bytes more per open file, fewer window reloads with several open
+/      files.
+/
+/  The profile can also be selected from the command line (-D_FS_PROFILE=n).
+/  host/banco.sh reports code size, RAM and throughput of each profile. */
+
+#if _FS_PROFILE == 1
+#define _FS_READONLY	1
+#define _FS_MINIMIZE	2
+#define _USE_STRFUNC	0
+#define _USE_FIND		0
+#define _USE_MKFS		0
+#define _CODE_PAGE		1
+#define _FS_TINY		1
+#elif _FS_PROFILE == 2
+#define _FS_READONLY	0
+#define _FS_MINIMIZE	2
+#define _USE_STRFUNC	0
+#define _USE_FIND		0
+#define _USE_MKFS		0
+#define _CODE_PAGE		1
+#define _FS_TINY		1
+#elif _FS_PROFILE == 3
+#define _FS_READONLY	0
+#define _FS_MINIMIZE	0
+#define _USE_STRFUNC	1
+#define _USE_FIND		1
+#define _USE_MKFS		1
+#define _CODE_PAGE		437
+#define _FS_TINY		0
+#endif
+
+
 /*---------------------------------------------------------------------------/
 / Function Configurations
 /---------------------------------------------------------------------------*/
 
+#ifndef _FS_READONLY
 #define _FS_READONLY	0
+#endif
 /* This option switches read-only configuration. (0:Read/Write or 1:Read-only)
 /  Read-only configuration removes writing API functions, f_write(), f_sync(),
 /  f_unlink(), f_mkdir(), f_chmod(), f_rename(), f_truncate(), f_getfree()
 /  and optional writing functions as well. */
 
 
+#ifndef _FS_MINIMIZE
 #define _FS_MINIMIZE	2
+#endif
 /* This option defines minimization level to remove some basic API functions.
 /
 /   0: All basic functions are enabled.
@@ -25,7 +79,9 @@
 /   3: f_lseek() function is removed in addition to 2. */
 
 
+#ifndef _USE_STRFUNC
 #define	_USE_STRFUNC	0
+#endif
 /* This option switches string functions, f_gets(), f_putc(), f_puts() and
 /  f_printf().
 /
@@ -34,12 +90,16 @@
 /  2: Enable with LF-CRLF conversion. */
 
 
+#ifndef _USE_FIND
 #define _USE_FIND		0
+#endif
 /* This option switches filtered directory read feature and related functions,
 /  f_findfirst() and f_findnext(). (0:Disable or 1:Enable) */
 
 
+#ifndef _USE_MKFS
 #define	_USE_MKFS		0
+#endif
 /* This option switches f_mkfs() function. (0:Disable or 1:Enable) */
 
 
@@ -61,7 +121,9 @@
 / Locale and Namespace Configurations
 /---------------------------------------------------------------------------*/
 
-#define _CODE_PAGE	932
+#ifndef _CODE_PAGE
+#define _CODE_PAGE	437
+#endif
 /* This option specifies the OEM code page to be used on the target system.
 /  Incorrect setting of the code page can cause a file open failure.
 /
@@ -192,7 +254,9 @@
 / System Configurations
 /---------------------------------------------------------------------------*/
 
+#ifndef _FS_TINY
 #define	_FS_TINY	1
+#endif
 /* This option switches tiny buffer configuration. (0:Normal or 1:Tiny)
 /  At the tiny configuration, size of the file object (FIL) is reduced _MAX_SS
 /  bytes. Instead of private sector buffer eliminated from the file object,
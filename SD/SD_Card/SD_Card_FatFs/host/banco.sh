@@ -0,0 +1,35 @@
+#!/bin/sh
+# Bancos de pruebas en la PC de diskio.c y ff.c sobre el modelo de tarjeta (host/sd_modelo.c).
+# Se ejecuta desde cualquier directorio: sh host/banco.sh
+# Termina con error si falla alguna verificación.
+
+set -e
+cd "$(dirname "$0")/.."
+CC="${CC:-gcc}"
+CFLAGS="-std=c99 -O2 -D_SD_HOST -I."
+SAL="${TMPDIR:-/tmp}/banco_sd"
+mkdir -p "$SAL"
+
+# Caché de sectores: sin caché y con 8 sectores
+for c in 0 8; do
+	$CC $CFLAGS -D_SD_CACHE=$c -o "$SAL/banco_cache" host/banco_cache.c host/sd_modelo.c diskio.c ff.c
+	"$SAL/banco_cache"
+	echo
+done
+
+# Negociación del reloj y rendimiento de bloques: sin y con CMD6 (con verificación de CRC), y con caché
+for o in "-D_SD_HS=0" "-D_SD_HS=1 -D_SD_CRC=1" "-D_SD_HS=1 -D_SD_CRC=1 -D_SD_CACHE=8"; do
+	$CC $CFLAGS $o -o "$SAL/banco_reloj" host/banco_reloj.c host/sd_modelo.c diskio.c
+	"$SAL/banco_reloj"
+	echo
+done
+
+# Perfiles de ffconf.h: código y variables estáticas de ff.c (gcc -Os de la PC, como referencia relativa entre
+# perfiles, no como tamaño en el PIC) y RAM de los objetos y rendimiento sobre la imagen
+for p in 0 1 2 3; do
+	$CC -std=c99 -Os -D_FS_PROFILE=$p -I. -c -o "$SAL/ff.o" ff.c
+	size "$SAL/ff.o" | awk -v p=$p 'NR == 2 { printf "_FS_PROFILE=%d: ff.c código %d bytes, variables %d bytes\n", p, $1, $2 + $3 }'
+	$CC $CFLAGS -D_FS_PROFILE=$p -o "$SAL/banco_perfiles" host/banco_perfiles.c host/sd_modelo.c diskio.c ff.c
+	"$SAL/banco_perfiles"
+	echo
+done
@@ -0,0 +1,204 @@
+/**
+ * @file banco_cache.c
+ * @brief Banco de pruebas en la PC de la caché de sectores de diskio.c (_SD_CACHE) sobre el modelo de tarjeta de
+ * sd_modelo.c. Mide los sectores que mueve el bus por KB escrito con f_write (registro en trozos de 100 bytes con
+ * f_sync periódico, como main.c) y, con caché de 4 sectores o más, verifica su comportamiento: reemplazo LRU, rango de
+ * la FAT fijado con MMC_CACHE_PIN, escritura de los sectores sucios contiguos con un solo ACMD23 + CMD25, lecturas de
+ * varios sectores con los sectores sucios superpuestos y escrituras de varios sectores que descartan las copias en
+ * caché. Se compila desde el directorio del módulo (ver banco.sh):
+ * gcc -std=c99 -D_SD_HOST -D_SD_CACHE=8 -I. -o banco_cache host/banco_cache.c host/sd_modelo.c diskio.c ff.c
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "ff.h"
+#include "diskio.h"
+#include "host/sd_modelo.h"
+
+#define SECTORES	65536UL		// Imagen de 32 MB
+#define TROZO		100			// Bytes por f_write
+#define TOTAL		262144UL	// Bytes escritos en la medición
+#define SINCRONIZAR	4096UL		// Bytes entre f_sync
+
+#if _SD_CACHE >= 4
+static unsigned fallas;
+
+static void verificar(bool condicion, const char *descripcion)
+{
+	printf("  %s: %s\n", descripcion, condicion ? "ok" : "FALLA");
+	if(!condicion)
+		fallas++;
+}
+
+static uint32_t leidos(void)
+{
+	return sd_modelo_cont.bloques_leidos;
+}
+
+static void patron(BYTE *b, DWORD sector, BYTE version)
+{
+	UINT i;
+
+	for(i = 0; i < 512; i++)
+		b[i] = (BYTE)(sector * 7 + i + version * 31);
+}
+#endif
+
+static int medir(void)
+{
+	static FATFS fs;
+	static FIL f;
+	static BYTE datos[TROZO];
+	DWORD escrito, pin[2];
+	UINT bw, i;
+	double kb = TOTAL / 1024.0, movidos;
+
+	sd_modelo_formatear();
+	if(f_mount(&fs, "", 1) != FR_OK)
+	{
+		printf("f_mount falló\n");
+		return 1;
+	}
+	#if _SD_CACHE
+	// La FAT (ambas copias) queda preferentemente en la caché
+	pin[0] = fs.fatbase;
+	pin[1] = fs.fsize * fs.n_fats;
+	disk_ioctl(0, MMC_CACHE_PIN, pin);
+	#else
+	(void)pin;
+	#endif
+	if(f_open(&f, "REGISTRO.BIN", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+	{
+		printf("f_open falló\n");
+		return 1;
+	}
+	for(i = 0; i < TROZO; i++)
+		datos[i] = (BYTE)i;
+	sd_modelo_reiniciar();
+	for(escrito = 0; escrito < TOTAL; escrito += bw)
+	{
+		if(f_write(&f, datos, TROZO, &bw) != FR_OK || bw != TROZO)
+		{
+			printf("f_write falló\n");
+			return 1;
+		}
+		if((escrito + bw) / SINCRONIZAR != escrito / SINCRONIZAR)
+			f_sync(&f);
+	}
+	f_close(&f);
+	movidos = sd_modelo_cont.bloques_leidos + sd_modelo_cont.bloques_escritos;
+	printf("f_write de %u bytes, f_sync cada %lu bytes, %.0f KB, _SD_CACHE=%d\n", TROZO, SINCRONIZAR, kb, _SD_CACHE);
+	printf("  sectores leídos %lu, escritos %lu: %.2f sectores/KB\n", (unsigned long)sd_modelo_cont.bloques_leidos,
+		(unsigned long)sd_modelo_cont.bloques_escritos, movidos / kb);
+	printf("  CMD17 %lu, CMD18 %lu, CMD24 %lu, CMD25 %lu (racha máxima %lu)\n",
+		(unsigned long)sd_modelo_cont.comandos[17], (unsigned long)sd_modelo_cont.comandos[18],
+		(unsigned long)sd_modelo_cont.comandos[24], (unsigned long)sd_modelo_cont.comandos[25],
+		(unsigned long)sd_modelo_cont.racha_max);
+	printf("  tiempo del bus %.1f ms: %.1f KB/s\n", sd_modelo_cont.tiempo_us / 1000, kb * 1e6 / sd_modelo_cont.tiempo_us);
+	f_mount(NULL, "", 0);
+	return 0;
+}
+
+#if _SD_CACHE >= 4
+static void regresion(void)
+{
+	static BYTE b[4 * 512], e[512];
+	DWORD pin[2], s, antes;
+	UINT i;
+
+	printf("Regresión de la caché (%d sectores)\n", _SD_CACHE);
+	disk_initialize(0);
+	pin[0] = pin[1] = 0;
+	disk_ioctl(0, MMC_CACHE_PIN, pin);
+
+	// LRU: tras llenar la caché y volver a usar el primero, el reemplazado es el segundo
+	for(s = 0; s < _SD_CACHE; s++)
+		disk_read(0, b, 1000 + s, 1);
+	disk_read(0, b, 1000, 1);
+	disk_read(0, b, 2000, 1);
+	antes = leidos();
+	disk_read(0, b, 1000, 1);
+	verificar(leidos() == antes, "LRU: el sector recién usado sigue en caché");
+	disk_read(0, b, 1001, 1);
+	verificar(leidos() == antes + 1, "LRU: el menos usado fue el reemplazado");
+
+	// Rango fijado: sobrevive a una lectura secuencial del doble de la caché; sin fijar no sobrevive
+	pin[0] = 1000;
+	pin[1] = 1;
+	disk_ioctl(0, MMC_CACHE_PIN, pin);
+	disk_read(0, b, 1000, 1);
+	for(s = 0; s < 2 * _SD_CACHE; s++)
+		disk_read(0, b, 5000 + s, 1);
+	antes = leidos();
+	disk_read(0, b, 1000, 1);
+	verificar(leidos() == antes, "Rango fijado: sobrevive a la lectura secuencial");
+	pin[0] = pin[1] = 0;
+	disk_ioctl(0, MMC_CACHE_PIN, pin);
+	for(s = 0; s < 2 * _SD_CACHE; s++)
+		disk_read(0, b, 6000 + s, 1);
+	antes = leidos();
+	disk_read(0, b, 1000, 1);
+	verificar(leidos() == antes + 1, "Sin rango fijado: es reemplazado");
+
+	// Sectores sucios contiguos: ninguna escritura hasta CTRL_SYNC y después una sola racha ACMD23 + CMD25
+	sd_modelo_reiniciar();
+	for(s = 0; s < 4; s++)
+	{
+		// En orden inverso: la racha no depende del orden de escritura
+		patron(e, 3003 - s, 1);
+		disk_write(0, e, 3003 - s, 1);
+	}
+	verificar(sd_modelo_cont.bloques_escritos == 0, "Escrituras de un sector retenidas en caché");
+	disk_ioctl(0, CTRL_SYNC, NULL);
+	verificar(sd_modelo_cont.comandos[24] == 0 && sd_modelo_cont.comandos[25] == 1 && sd_modelo_cont.racha_max == 4,
+		"CTRL_SYNC: un CMD25 de 4 bloques, sin CMD24");
+	verificar(sd_modelo_cont.acmd23 == 1 && sd_modelo_cont.acmd23_bloques == 4, "CTRL_SYNC: ACMD23 de 4 bloques");
+	for(s = 0, i = 1; s < 4; s++)
+	{
+		patron(e, 3000 + s, 1);
+		i &= memcmp(sd_modelo_imagen[3000 + s], e, 512) == 0;
+	}
+	verificar(i, "CTRL_SYNC: la imagen contiene los datos escritos");
+
+	// Lectura de varios sectores con un sector sucio en caché que la tarjeta aún no tiene
+	for(s = 0; s < 4; s++)
+	{
+		patron(e, 4000 + s, 1);
+		disk_write(0, e, 4000 + s, 1);
+	}
+	disk_ioctl(0, CTRL_SYNC, NULL);
+	patron(e, 4001, 2);
+	disk_write(0, e, 4001, 1);
+	disk_read(0, b, 4000, 4);
+	verificar(memcmp(b + 512, e, 512) == 0, "Lectura múltiple: el sector sucio se superpone");
+	verificar(memcmp(sd_modelo_imagen[4001], e, 512) != 0, "Lectura múltiple: el sector seguía sin escribir");
+
+	// Escritura de varios sectores: la copia en caché se descarta y CTRL_SYNC no la reescribe
+	for(s = 0; s < 4; s++)
+		patron(b + s * 512, 4000 + s, 3);
+	disk_write(0, b, 4000, 4);
+	disk_read(0, e, 4001, 1);
+	verificar(memcmp(e, b + 512, 512) == 0, "Escritura múltiple: se lee el dato nuevo");
+	disk_ioctl(0, CTRL_SYNC, NULL);
+	verificar(memcmp(sd_modelo_imagen[4001], b + 512, 512) == 0, "Escritura múltiple: CTRL_SYNC no la sobrescribe");
+}
+#endif
+
+int main(void)
+{
+	if(!sd_modelo_init(SECTORES))
+	{
+		printf("Sin memoria para la imagen\n");
+		return 1;
+	}
+	if(medir() != 0)
+		return 1;
+	#if _SD_CACHE >= 4
+	regresion();
+	return fallas ? 1 : 0;
+	#else
+	return 0;
+	#endif
+}
@@ -0,0 +1,117 @@
+/**
+ * @file banco_perfiles.c
+ * @brief Banco de pruebas en la PC de los perfiles de configuración de ffconf.h (_FS_PROFILE) sobre el modelo de tarjeta
+ * de sd_modelo.c: reporta la RAM de los objetos FATFS y FIL y el rendimiento de f_read y f_write (datos útiles entre
+ * tiempo del bus) en trozos de un sector y de 100 bytes, y verifica los datos leídos y escritos. El tamaño del código y
+ * de las variables de ff.c lo reporta banco.sh con size. Se compila desde el directorio del módulo (ver banco.sh):
+ * gcc -std=c99 -D_SD_HOST -D_FS_PROFILE=2 -I. -o banco_perfiles host/banco_perfiles.c host/sd_modelo.c diskio.c ff.c
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "ff.h"
+#include "diskio.h"
+#include "host/sd_modelo.h"
+
+#define SECTORES	65536UL		// Imagen de 32 MB
+#define TOTAL		524288UL	// Bytes por medición
+
+static FATFS fs;
+static FIL f;
+static BYTE bufer[512];
+static unsigned fallas;
+
+static BYTE patron(DWORD p)
+{
+	return (BYTE)(p * 7 + p / 512);
+}
+
+static double lectura(const TCHAR *ruta, UINT trozo)
+{
+	// KB/s de f_read del archivo completo en trozos del tamaño dado; compara con el patrón
+	DWORD p = 0;
+	UINT br, i;
+	bool iguales = true;
+
+	sd_modelo_reiniciar();
+	if(f_open(&f, ruta, FA_READ) != FR_OK)
+		iguales = false;
+	else
+	{
+		while(p < TOTAL && f_read(&f, bufer, trozo, &br) == FR_OK && br != 0)
+		{
+			for(i = 0; i < br; i++, p++)
+				iguales &= bufer[i] == patron(p);
+		}
+		f_close(&f);
+	}
+	if(!iguales || p != TOTAL)
+	{
+		printf("  %s: datos leídos distintos\n", ruta);
+		fallas++;
+	}
+	return TOTAL / 1024.0 * 1e6 / sd_modelo_cont.tiempo_us;
+}
+
+#if !_FS_READONLY
+static double escritura(const TCHAR *ruta, UINT trozo)
+{
+	DWORD p = 0;
+	UINT bw, i, n;
+	double kbs;
+
+	sd_modelo_reiniciar();
+	if(f_open(&f, ruta, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+	{
+		fallas++;
+		return 0;
+	}
+	while(p < TOTAL)
+	{
+		n = TOTAL - p < trozo ? (UINT)(TOTAL - p) : trozo;
+		for(i = 0; i < n; i++)
+			bufer[i] = patron(p + i);
+		if(f_write(&f, bufer, n, &bw) != FR_OK || bw != n)
+			break;
+		p += n;
+	}
+	f_close(&f);
+	disk_ioctl(0, CTRL_SYNC, NULL);
+	kbs = TOTAL / 1024.0 * 1e6 / sd_modelo_cont.tiempo_us;
+	if(p != TOTAL)
+	{
+		printf("  %s: f_write falló\n", ruta);
+		fallas++;
+	}
+	lectura(ruta, 512);
+	return kbs;
+}
+#endif
+
+int main(void)
+{
+	if(!sd_modelo_init(SECTORES))
+	{
+		printf("Sin memoria para la imagen\n");
+		return 1;
+	}
+	sd_modelo_formatear();
+	if(!sd_modelo_archivo("LECTURA BIN", TOTAL) || f_mount(&fs, "", 1) != FR_OK)
+	{
+		printf("No se pudo montar la imagen\n");
+		return 1;
+	}
+	printf("_FS_PROFILE=%d: sizeof(FATFS) %u, sizeof(FIL) %u bytes\n", _FS_PROFILE, (unsigned)sizeof(FATFS),
+		(unsigned)sizeof(FIL));
+	printf("  f_read  %.0f KB/s (512 bytes) %.0f KB/s (100 bytes)\n", lectura("LECTURA.BIN", 512),
+		lectura("LECTURA.BIN", 100));
+	#if _FS_READONLY
+	printf("  f_write sin soporte (_FS_READONLY)\n");
+	#else
+	printf("  f_write %.0f KB/s (512 bytes) %.0f KB/s (100 bytes)\n", escritura("ESCRIT1.BIN", 512),
+		escritura("ESCRIT2.BIN", 100));
+	#endif
+	return fallas ? 1 : 0;
+}
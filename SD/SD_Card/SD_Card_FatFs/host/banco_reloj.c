@@ -0,0 +1,152 @@
+/**
+ * @file banco_reloj.c
+ * @brief Banco de pruebas en la PC de la negociación del reloj SPI de disk_initialize y del rendimiento de las
+ * transferencias de bloques de diskio.c sobre el modelo de tarjeta de sd_modelo.c. Para cada escenario (reloj del MSSP
+ * y tarjeta) verifica que la identificación sea a 400 kHz o menos y que el reloj final sea el esperado, comprueba que
+ * los datos leídos y escritos coincidan con la imagen y reporta el rendimiento de lectura y escritura (datos útiles
+ * entre tiempo del bus), también con el reloj de identificación como referencia. Con _SD_CRC verifica además que un
+ * bloque con CRC incorrecto se rechace. Se compila desde el directorio del módulo (ver banco.sh):
+ * gcc -std=c99 -D_SD_HOST -D_SD_HS=1 -D_SD_CRC=1 -I. -o banco_reloj host/banco_reloj.c host/sd_modelo.c diskio.c
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include "diskio.h"
+#include "host/sd_modelo.h"
+
+#define SECTORES	65536UL
+#define BLOQUE		64			// Sectores por disk_read/disk_write múltiple
+#define MEDICION	2048UL		// Sectores por medición (1 MB)
+
+typedef struct {
+	const char *nombre;
+	uint32_t fosc;				// Reloj del MSSP [Hz]
+	uint32_t reloj_max;			// Reloj máximo de la tarjeta en modo normal [Hz]
+	bool alta_velocidad;
+	uint32_t esperado;			// Reloj SPI esperado tras disk_initialize [Hz]
+} escenario_t;
+
+static const escenario_t escenarios[] = {
+	{ "PIC18 64 MHz, tarjeta de 25 MHz", 64000000UL, 25000000UL, false, 16000000UL },
+	{ "PIC18 64 MHz, tarjeta que falla sobre 5 MHz", 64000000UL, 5000000UL, false, 4000000UL },
+	#if _SD_HS
+	{ "MSSP de 160 MHz, tarjeta de alta velocidad", 160000000UL, 25000000UL, true, 40000000UL },
+	#else
+	{ "MSSP de 160 MHz, tarjeta de alta velocidad", 160000000UL, 25000000UL, true, 10000000UL },
+	#endif
+	{ "MSSP de 160 MHz, tarjeta sin CMD6", 160000000UL, 25000000UL, false, 10000000UL },
+};
+
+static BYTE bufer[BLOQUE * 512];
+static unsigned fallas;
+
+static void verificar(bool condicion, const char *descripcion)
+{
+	printf("  %s: %s\n", descripcion, condicion ? "ok" : "FALLA");
+	if(!condicion)
+		fallas++;
+}
+
+static double lectura(DWORD inicio, UINT n, bool *iguales)
+{
+	// KB/s de disk_read en bloques de n sectores; compara cada bloque con la imagen
+	DWORD s;
+
+	sd_modelo_reiniciar();
+	for(s = 0; s < MEDICION; s += n)
+	{
+		if(disk_read(0, bufer, inicio + s, n) != RES_OK || memcmp(bufer, sd_modelo_imagen[inicio + s], n * 512UL) != 0)
+			*iguales = false;
+	}
+	return MEDICION / 2.0 * 1e6 / sd_modelo_cont.tiempo_us;
+}
+
+static double escritura(DWORD inicio, UINT n, bool *iguales)
+{
+	DWORD s;
+	UINT i;
+
+	sd_modelo_reiniciar();
+	for(s = 0; s < MEDICION; s += n)
+	{
+		for(i = 0; i < n * 512; i++)
+			bufer[i] = (BYTE)(s + i * 3);
+		if(disk_write(0, bufer, inicio + s, n) != RES_OK)
+			*iguales = false;
+	}
+	disk_ioctl(0, CTRL_SYNC, NULL);
+	for(s = 0; s < MEDICION; s += n)
+	{
+		for(i = 0; i < n * 512; i++)
+			bufer[i] = (BYTE)(s + i * 3);
+		if(memcmp(bufer, sd_modelo_imagen[inicio + s], n * 512UL) != 0)
+			*iguales = false;
+	}
+	return MEDICION / 2.0 * 1e6 / sd_modelo_cont.tiempo_us;
+}
+
+static void rendimiento(void)
+{
+	bool iguales = true;
+	double l1, ln, e1, en;
+
+	l1 = lectura(10000, 1, &iguales);
+	ln = lectura(10000, BLOQUE, &iguales);
+	e1 = escritura(20000, 1, &iguales);
+	en = escritura(20000, BLOQUE, &iguales);
+	printf("  lectura %.0f KB/s (CMD17) %.0f KB/s (CMD18); escritura %.0f KB/s (CMD24) %.0f KB/s (CMD25)\n", l1, ln,
+		e1, en);
+	verificar(iguales, "Datos leídos y escritos iguales a la imagen");
+}
+
+int main(void)
+{
+	const escenario_t *e;
+	DWORD reloj, i;
+
+	if(!sd_modelo_init(SECTORES))
+	{
+		printf("Sin memoria para la imagen\n");
+		return 1;
+	}
+	for(i = 0; i < SECTORES; i++)
+		memset(sd_modelo_imagen[i], (int)(i * 13), 512);
+	printf("_SD_HS=%d _SD_CRC=%d _SD_CACHE=%d\n", _SD_HS, _SD_CRC, _SD_CACHE);
+	for(e = escenarios; e < escenarios + sizeof escenarios / sizeof escenarios[0]; e++)
+	{
+		printf("%s\n", e->nombre);
+		sd_modelo_fosc = e->fosc;
+		sd_modelo_tarjeta.reloj_max = e->reloj_max;
+		sd_modelo_tarjeta.alta_velocidad = e->alta_velocidad;
+		verificar(disk_initialize(0) == 0, "disk_initialize");
+		verificar(sd_modelo_cont.reloj_identificacion <= 400000UL, "Identificación a 400 kHz o menos");
+		disk_ioctl(0, MMC_GET_CLOCK, &reloj);
+		printf("  reloj SPI %.2f MHz (MMC_GET_CLOCK %.2f MHz)\n", sd_modelo_reloj() / 1e6, reloj / 1e6);
+		verificar(reloj == e->esperado && sd_modelo_reloj() == reloj, "Reloj negociado");
+		rendimiento();
+		if(e == escenarios)
+		{
+			// Referencia: todo el tráfico al reloj de identificación, como antes de la negociación
+			SSP1CON1 = 0x2A;
+			SSP1ADD = (uint8_t)(e->fosc / (4 * 400000UL) - 1);
+			printf("Mismo escenario sin subir el reloj (%.0f kHz)\n", sd_modelo_reloj() / 1e3);
+			rendimiento();
+		}
+	}
+
+	#if _SD_CRC
+	printf("Bloques con CRC incorrecto\n");
+	sd_modelo_fosc = 64000000UL;
+	sd_modelo_tarjeta.reloj_max = 25000000UL;
+	disk_initialize(0);
+	sd_modelo_tarjeta.crc_erroneo = true;
+	verificar(disk_read(0, bufer, 100, 1) == RES_ERROR, "CMD17 rechazado");
+	verificar(disk_read(0, bufer, 100, 4) == RES_ERROR, "CMD18 rechazado");
+	verificar(disk_ioctl(0, MMC_GET_CSD, bufer) == RES_ERROR, "CSD rechazado");
+	sd_modelo_tarjeta.crc_erroneo = false;
+	verificar(disk_initialize(0) == 0 && disk_read(0, bufer, 100, 4) == RES_OK, "CRC correcto aceptado");
+	#endif
+	return fallas ? 1 : 0;
+}
@@ -0,0 +1,93 @@
+/**
+ * @file datalog_lector.c
+ * @brief Lector en la PC de los archivos de datalog.c: valida el encabezado y los bloques de datos y escribe los
+ * registros en formato CSV (bloque, tipo, marca, datos en hexadecimal). Se compila con cualquier compilador de C99:
+ * gcc -std=c99 -o datalog_lector datalog_lector.c
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#define ENCABEZADO	14
+#define REGISTRO	6
+#define CARGA		(512 - ENCABEZADO)
+
+static uint16_t crc16(uint16_t crc, const uint8_t *datos, unsigned n)
+{
+	int i;
+
+	while(n--)
+	{
+		crc ^= (uint16_t)*datos++ << 8;
+		for(i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+	}
+	return crc;
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return (uint32_t)get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+int main(int argc, char *argv[])
+{
+	FILE *f;
+	uint8_t b[512];
+	uint32_t sesion, capacidad, indice, marca;
+	unsigned usados, pos, i, registros = 0;
+
+	if(argc != 2)
+	{
+		fprintf(stderr, "Uso: %s ARCHIVO\n", argv[0]);
+		return 2;
+	}
+	if((f = fopen(argv[1], "rb")) == NULL)
+	{
+		perror(argv[1]);
+		return 1;
+	}
+	if(fread(b, 1, 512, f) != 512 || memcmp(b, "DLOG", 4) != 0 || b[4] != 1 || crc16(0, b, 14) != get16(b + 14))
+	{
+		fprintf(stderr, "%s: no es un registro de datos\n", argv[1]);
+		fclose(f);
+		return 1;
+	}
+	sesion = get32(b + 6);
+	capacidad = get32(b + 10);
+	printf("bloque,tipo,marca,datos\n");
+	for(indice = 1; indice <= capacidad && fread(b, 1, 512, f) == 512; indice++)
+	{
+		// El registro termina en el primer bloque inválido
+		usados = get16(b + 10);
+		if(b[0] != 'D' || b[1] != 'L' || get32(b + 2) != sesion || get32(b + 6) != indice || usados > CARGA ||
+			crc16(crc16(0, b, 12), b + ENCABEZADO, usados) != get16(b + 12))
+			break;
+		for(pos = ENCABEZADO; pos + REGISTRO <= ENCABEZADO + usados; pos += REGISTRO + b[pos])
+		{
+			if(pos + REGISTRO + b[pos] > ENCABEZADO + usados)
+			{
+				fprintf(stderr, "Bloque %lu: registro truncado\n", (unsigned long)indice);
+				break;
+			}
+			marca = get32(b + pos + 2);
+			printf("%lu,%u,%lu,", (unsigned long)indice, b[pos + 1], (unsigned long)marca);
+			for(i = 0; i < b[pos]; i++)
+				printf("%02X", b[pos + REGISTRO + i]);
+			printf("\n");
+			registros++;
+		}
+	}
+	fclose(f);
+	fprintf(stderr, "%u registros en %lu bloques de %lu\n", registros, (unsigned long)(indice - 1),
+		(unsigned long)capacidad);
+	return 0;
+}
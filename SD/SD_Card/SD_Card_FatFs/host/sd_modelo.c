@@ -0,0 +1,475 @@
+/**
+ * @file sd_modelo.c
+ * @brief Modelo en la PC de una tarjeta SDHC en modo SPI sobre una imagen en memoria (ver sd_modelo.h). Responde a
+ * CMD0/6/8/9/10/12/16/17/18/24/25/55/58 y ACMD13/23/41 con direccionamiento por bloque, envía los bloques con su
+ * CRC16, señala ocupado mientras programa un bloque escrito y corrompe los datos si el reloj SPI excede el máximo de la
+ * tarjeta, de modo que la verificación de diskio.c lo detecte.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "sd_modelo.h"
+
+volatile uint8_t SSP1BUF, SSP1CON1, SSP1ADD;
+uint32_t sd_modelo_fosc = 64000000UL;
+sd_modelo_tarjeta_t sd_modelo_tarjeta;
+sd_modelo_contadores_t sd_modelo_cont;
+uint8_t (*sd_modelo_imagen)[512];
+
+#define SIN_ESPERA		0xFFFF
+
+/* Respuesta pendiente de la tarjeta; desde espera_pos los bytes salen hasta espera_hasta (latencia de lectura) */
+static uint8_t _cola[600];
+static uint16_t _qh, _qt, _espera_pos = SIN_ESPERA;
+static double _espera_hasta, _ocupado_hasta;
+
+static uint8_t _cmd[6];
+static int8_t _ncmd = -1;
+static bool _app, _alta, _corromper;
+
+static bool _lectura_continua;
+static uint32_t _sector_lectura;
+
+static uint8_t _escritura;				// 0: sin escritura, 24 o 25: comando en curso
+static int16_t _n;						// Bytes recibidos del bloque, -1 en espera del token
+static uint32_t _sector_escritura, _racha;
+static uint8_t _bloque[514];
+
+static uint16_t _crc16(const uint8_t *datos, uint16_t n)
+{
+	uint16_t crc = 0;
+	uint8_t i;
+
+	while(n--)
+	{
+		crc ^= (uint16_t)*datos++ << 8;
+		for(i = 0; i < 8; i++)
+			crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+	}
+	return crc;
+}
+
+static void _poner(uint8_t b)
+{
+	// Con el reloj fuera de especificación la tarjeta entrega datos erróneos (los tokens y respuestas nulas se conservan)
+	if(_corromper && b != 0xFE && b != 0xFF && b != 0x00)
+		b ^= 0x10;
+	_cola[_qt++] = b;
+}
+
+static void _poner_bloque(const uint8_t *datos, uint16_t n)
+{
+	uint16_t crc = _crc16(datos, n) ^ (sd_modelo_tarjeta.crc_erroneo ? 1 : 0);
+	uint16_t i;
+
+	_espera_pos = _qt;
+	_espera_hasta = sd_modelo_cont.tiempo_us + sd_modelo_tarjeta.t_lectura_us;
+	_poner(0xFE);
+	for(i = 0; i < n; i++)
+		_poner(datos[i]);
+	_poner((uint8_t)(crc >> 8));
+	_poner((uint8_t)crc);
+}
+
+uint32_t sd_modelo_reloj(void)
+{
+	switch(SSP1CON1 & 0x0F)
+	{
+		case 0x00:	return sd_modelo_fosc / 4;
+		case 0x01:	return sd_modelo_fosc / 16;
+		case 0x02:	return sd_modelo_fosc / 64;
+		default:	return sd_modelo_fosc / (4 * ((uint32_t)SSP1ADD + 1));
+	}
+}
+
+static void _comando(void)
+{
+	uint8_t c = _cmd[0] & 0x3F;
+	uint32_t arg = ((uint32_t)_cmd[1] << 24) | ((uint32_t)_cmd[2] << 16) | ((uint32_t)_cmd[3] << 8) | _cmd[4];
+	uint8_t r[64];
+	uint32_t cs;
+
+	_qh = _qt = 0;
+	_espera_pos = SIN_ESPERA;
+	_corromper = sd_modelo_reloj() > (_alta ? 2 : 1) * sd_modelo_tarjeta.reloj_max;
+	sd_modelo_cont.comandos[c]++;
+	_poner(0xFF);								// NCR
+	if(_app)
+	{
+		_app = false;
+		switch(c)
+		{
+			case 41:
+				_poner(0x00);
+				break;
+			case 23:
+				sd_modelo_cont.acmd23++;
+				sd_modelo_cont.acmd23_bloques = arg;
+				_poner(0x00);
+				break;
+			case 13:
+				memset(r, 0, 64);
+				r[10] = 0x90;					// AU_SIZE 4 MB
+				_poner(0x00);
+				_poner(0x00);					// R2
+				_poner_bloque(r, 64);
+				break;
+			default:
+				_poner(0x04);
+				break;
+		}
+		return;
+	}
+	if((c == 17 || c == 18 || c == 24 || c == 25) && arg >= sd_modelo_tarjeta.sectores)
+	{
+		_poner(0x40);							// Error de dirección
+		return;
+	}
+	switch(c)
+	{
+		case 0:
+			sd_modelo_cont.reloj_identificacion = sd_modelo_reloj();
+			_alta = false;
+			_lectura_continua = false;
+			_escritura = 0;
+			_poner(0x01);
+			break;
+		case 8:
+			_poner(0x01);
+			_poner(0x00);
+			_poner(0x00);
+			_poner(0x01);
+			_poner(0xAA);
+			break;
+		case 55:
+			_app = true;
+			_poner(0x00);
+			break;
+		case 58:
+			_poner(0x00);
+			_poner(0xC0);						// Encendida, CCS (SDHC)
+			_poner(0xFF);
+			_poner(0x80);
+			_poner(0x00);
+			break;
+		case 6:
+			memset(r, 0, 64);
+			r[16] = sd_modelo_tarjeta.alta_velocidad ? 0x01 : 0x0F;
+			if(sd_modelo_tarjeta.alta_velocidad && (arg >> 31) && (arg & 0x0F) == 1)
+				_alta = true;
+			_poner(0x00);
+			_poner_bloque(r, 64);
+			break;
+		case 9:
+			{
+				// CSD 2.0: TRAN_SPEED 25 MHz (50 MHz en alta velocidad), CCC con la clase 10 si admite CMD6
+				static const uint8_t csd[16] = { 0x40, 0x0E, 0x00, 0x32, 0x5B, 0x59, 0x00, 0x00, 0x00, 0x00, 0x7F, 0x80,
+					0x0A, 0x40, 0x00, 0x01 };
+
+				memcpy(r, csd, 16);
+				cs = sd_modelo_tarjeta.sectores / 1024 - 1;
+				r[7] = (uint8_t)((cs >> 16) & 0x3F);
+				r[8] = (uint8_t)(cs >> 8);
+				r[9] = (uint8_t)cs;
+				if(!sd_modelo_tarjeta.alta_velocidad)
+					r[4] &= (uint8_t)~0x40;
+				if(_alta)
+					r[3] = 0x5A;
+				_poner(0x00);
+				_poner_bloque(r, 16);
+			}
+			break;
+		case 10:
+			memset(r, 0, 16);
+			memcpy(r + 3, "MODEL", 5);
+			_poner(0x00);
+			_poner_bloque(r, 16);
+			break;
+		case 12:
+			_qh = _qt = 0;
+			_espera_pos = SIN_ESPERA;
+			_poner(0xFF);						// Byte de relleno
+			_poner(0x00);
+			_lectura_continua = false;
+			break;
+		case 16:
+			_poner(0x00);
+			break;
+		case 17:
+			_poner(0x00);
+			_poner_bloque(sd_modelo_imagen[arg], 512);
+			sd_modelo_cont.bloques_leidos++;
+			break;
+		case 18:
+			_poner(0x00);
+			_lectura_continua = true;
+			_sector_lectura = arg;
+			break;
+		case 24:
+		case 25:
+			_poner(0x00);
+			_escritura = c;
+			_n = -1;
+			_sector_escritura = arg;
+			_racha = 0;
+			break;
+		default:
+			_poner(0x04);						// Comando ilegal
+			break;
+	}
+}
+
+static bool _ocupada(void)
+{
+	return sd_modelo_cont.tiempo_us < _ocupado_hasta;
+}
+
+uint8_t SPI1_Exchange8bit(uint8_t dato)
+{
+	sd_modelo_cont.tiempo_us += 8e6 / sd_modelo_reloj();
+	sd_modelo_cont.bytes++;
+	if(_ncmd >= 0)
+	{
+		_cmd[_ncmd++] = dato;
+		if(_ncmd == 6)
+		{
+			_ncmd = -1;
+			_comando();
+		}
+		return 0xFF;
+	}
+	if(_escritura && _n >= 0)
+	{
+		// Bloque de datos y CRC (el CRC no se verifica en modo SPI)
+		_bloque[_n++] = dato;
+		if(_n == 514)
+		{
+			if(_sector_escritura < sd_modelo_tarjeta.sectores)
+				memcpy(sd_modelo_imagen[_sector_escritura], _bloque, 512);
+			_sector_escritura++;
+			sd_modelo_cont.bloques_escritos++;
+			_qh = _qt = 0;
+			_espera_pos = SIN_ESPERA;
+			_poner(0xE5);						// Datos aceptados
+			if(_escritura == 24)
+			{
+				_ocupado_hasta = sd_modelo_cont.tiempo_us + sd_modelo_tarjeta.t_escritura_us;
+				_escritura = 0;
+			}
+			else
+			{
+				_ocupado_hasta = sd_modelo_cont.tiempo_us + sd_modelo_tarjeta.t_racha_us;
+				if(++_racha > sd_modelo_cont.racha_max)
+					sd_modelo_cont.racha_max = _racha;
+			}
+			_n = -1;
+		}
+		return 0xFF;
+	}
+	if(_escritura)
+	{
+		if(_qh < _qt)
+			return _cola[_qh++];
+		if(_ocupada())
+			return 0x00;
+		if(dato == (_escritura == 24 ? 0xFE : 0xFC))
+		{
+			_n = 0;
+			return 0xFF;
+		}
+		if(dato == 0xFD && _escritura == 25)
+		{
+			_escritura = 0;
+			return 0xFF;
+		}
+		if((dato & 0xC0) != 0x40)
+			return 0xFF;
+		_escritura = 0;							// Un comando cancela la escritura
+	}
+	if((dato & 0xC0) == 0x40)
+	{
+		// El anfitrión solo envía 0xFF mientras recibe: cualquier otro valor de esta forma es un comando
+		_cmd[0] = dato;
+		_ncmd = 1;
+		return 0xFF;
+	}
+	if(_qh < _qt)
+	{
+		if(_qh >= _espera_pos && sd_modelo_cont.tiempo_us < _espera_hasta)
+			return 0xFF;
+		return _cola[_qh++];
+	}
+	_qh = _qt = 0;
+	_espera_pos = SIN_ESPERA;
+	if(_ocupada())
+		return 0x00;
+	if(_lectura_continua)
+	{
+		if(_sector_lectura < sd_modelo_tarjeta.sectores)
+		{
+			_poner_bloque(sd_modelo_imagen[_sector_lectura++], 512);
+			sd_modelo_cont.bloques_leidos++;
+		}
+	}
+	return 0xFF;
+}
+
+sd_modelo_stat_t *sd_modelo_transferir(void)
+{
+	static sd_modelo_stat_t stat = { 1 };
+
+	SSP1BUF = SPI1_Exchange8bit(SSP1BUF);
+	return &stat;
+}
+
+void SPI1_Initialize(void)
+{
+	SSP1CON1 = 0x22;							// Fosc/64
+	SSP1ADD = 0;
+}
+
+void sd_modelo_esperar(double us)
+{
+	sd_modelo_cont.tiempo_us += us;
+}
+
+bool sd_modelo_init(uint32_t sectores)
+{
+	free(sd_modelo_imagen);
+	sd_modelo_imagen = calloc(sectores, 512);
+	if(sd_modelo_imagen == NULL)
+		return false;
+	sd_modelo_tarjeta.sectores = sectores;
+	sd_modelo_tarjeta.reloj_max = 25000000UL;
+	sd_modelo_tarjeta.alta_velocidad = true;
+	sd_modelo_tarjeta.t_lectura_us = 100;
+	sd_modelo_tarjeta.t_escritura_us = 600;
+	sd_modelo_tarjeta.t_racha_us = 150;
+	sd_modelo_tarjeta.crc_erroneo = false;
+	_ocupado_hasta = 0;
+	sd_modelo_reiniciar();
+	return true;
+}
+
+void sd_modelo_reiniciar(void)
+{
+	_ocupado_hasta -= sd_modelo_cont.tiempo_us;
+	_espera_hasta -= sd_modelo_cont.tiempo_us;
+	memset(&sd_modelo_cont, 0, sizeof sd_modelo_cont);
+}
+
+static void _put16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+}
+
+static void _put32(uint8_t *p, uint32_t v)
+{
+	_put16(p, (uint16_t)v);
+	_put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t _get16(const uint8_t *p)
+{
+	return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t _get32(const uint8_t *p)
+{
+	return (uint32_t)_get16(p) | ((uint32_t)_get16(p + 2) << 16);
+}
+
+void sd_modelo_formatear(void)
+{
+	uint32_t total = sd_modelo_tarjeta.sectores, clusters, i;
+	uint16_t fatsz = 1, raiz = 32;				// 512 entradas de directorio raíz
+	uint8_t spc = 1, *b;
+
+	// Menor tamaño de cluster con menos de 65525 clusters; FAT de tamaño suficiente para todos ellos
+	while((total - 1 - raiz) / spc > 65524)
+		spc <<= 1;
+	do {
+		clusters = (total - 1 - 2UL * fatsz - raiz) / spc;
+		if((clusters + 2) * 2 <= (uint32_t)fatsz * 512)
+			break;
+		fatsz++;
+	} while(1);
+	memset(sd_modelo_imagen, 0, (size_t)(1 + 2UL * fatsz + raiz) * 512);
+	b = sd_modelo_imagen[0];
+	memcpy(b, "\xEB\x3C\x90MSDOS5.0", 11);
+	_put16(b + 11, 512);
+	b[13] = spc;
+	_put16(b + 14, 1);							// Sectores reservados
+	b[16] = 2;									// Número de FAT
+	_put16(b + 17, (uint16_t)(raiz * 16));
+	if(total < 0x10000)
+		_put16(b + 19, (uint16_t)total);
+	else
+		_put32(b + 32, total);
+	b[21] = 0xF8;
+	_put16(b + 22, fatsz);
+	_put16(b + 24, 63);
+	_put16(b + 26, 255);
+	b[36] = 0x80;
+	b[38] = 0x29;
+	_put32(b + 39, 0x20261019UL);
+	memcpy(b + 43, "NO NAME    FAT16   ", 19);
+	b[510] = 0x55;
+	b[511] = 0xAA;
+	for(i = 0; i < 2; i++)
+	{
+		b = sd_modelo_imagen[1 + i * fatsz];
+		_put16(b, 0xFFF8);
+		_put16(b + 2, 0xFFFF);
+	}
+}
+
+bool sd_modelo_archivo(const char *nombre, uint32_t bytes)
+{
+	const uint8_t *b = sd_modelo_imagen[0];
+	uint8_t spc = b[13], *e = NULL, *fat;
+	uint16_t fatsz = _get16(b + 22), libre = 2, c, n, i;
+	uint32_t raiz = 1 + 2UL * fatsz, datos = raiz + 32, p;
+
+	// Primera entrada libre del directorio raíz y primer cluster después del último ocupado
+	for(i = 0; i < 512; i++)
+	{
+		uint8_t *d = sd_modelo_imagen[raiz + i / 16] + (i % 16) * 32;
+
+		if(d[0] == 0x00 || d[0] == 0xE5)
+		{
+			if(e == NULL)
+				e = d;
+		}
+		else if(_get16(d + 26) >= 2)
+		{
+			c = (uint16_t)(_get16(d + 26) + (_get32(d + 28) + spc * 512UL - 1) / (spc * 512UL));
+			if(c > libre)
+				libre = c;
+		}
+	}
+	n = (uint16_t)((bytes + spc * 512UL - 1) / (spc * 512UL));
+	if(e == NULL || datos + ((uint32_t)libre - 2 + n) * spc > sd_modelo_tarjeta.sectores ||
+		(uint32_t)libre + n > (uint32_t)fatsz * 256)
+		return false;
+	memset(e, 0, 32);
+	memcpy(e, nombre, 11);
+	e[11] = 0x20;								// Archivo
+	_put16(e + 24, 0x5353);						// 19/10/2021
+	_put16(e + 26, n ? libre : 0);
+	_put32(e + 28, bytes);
+	for(i = 0; i < 2; i++)
+	{
+		for(c = libre; c < libre + n; c++)
+		{
+			fat = sd_modelo_imagen[1 + i * fatsz + c / 256] + (c % 256) * 2;
+			_put16(fat, c + 1 == libre + n ? 0xFFFF : (uint16_t)(c + 1));
+		}
+	}
+	for(p = 0; p < bytes; p++)
+		sd_modelo_imagen[datos + ((uint32_t)libre - 2) * spc + p / 512][p % 512] = (uint8_t)(p * 7 + p / 512);
+	return true;
+}
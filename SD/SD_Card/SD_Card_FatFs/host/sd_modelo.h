@@ -0,0 +1,108 @@
+/**
+ * @file sd_modelo.h
+ * @brief Modelo en la PC de una tarjeta SDHC en modo SPI sobre una imagen en memoria, para compilar diskio.c y ff.c en
+ * la PC con -D_SD_HOST. Sustituye a mcc_generated_files/mcc.h: registros del MSSP, SPI1_Initialize/SPI1_Exchange8bit,
+ * selección de la tarjeta y retardos. El modelo cuenta comandos, bloques y bytes del bus, y lleva el tiempo del bus
+ * (bytes al reloj SPI programado, latencia de lectura, tiempo de programación de la tarjeta y retardos de diskio.c).
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef SD_MODELO_H
+#define SD_MODELO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+	Registros del MSSP (SPI 1). Una escritura de SSP1BUF inicia un byte que se intercambia con la tarjeta al consultar
+	SSP1STATbits.BF, como en sd_put/sd_wait/sd_get de diskio.h.
+*/
+typedef struct {
+	unsigned BF : 1;
+} sd_modelo_stat_t;
+
+extern volatile uint8_t SSP1BUF, SSP1CON1, SSP1ADD;
+sd_modelo_stat_t *sd_modelo_transferir(void);
+#define SSP1STATbits		(*sd_modelo_transferir())
+
+void SPI1_Initialize(void);
+uint8_t SPI1_Exchange8bit(uint8_t dato);
+
+#define SD_CS_SetHigh()		((void)0)
+#define SD_CS_SetLow()		((void)0)
+
+void sd_modelo_esperar(double us);
+#define __delay_us(x)		sd_modelo_esperar(x)
+#define __delay_ms(x)		sd_modelo_esperar(1000.0 * (x))
+
+extern uint32_t sd_modelo_fosc;
+#define _XTAL_FREQ			sd_modelo_fosc
+
+/**
+ * @brief Características de la tarjeta modelada. Los tiempos son supuestos del modelo (valores típicos de tarjetas
+ * de clase 4 a 10), no mediciones.
+ */
+typedef struct {
+	uint32_t sectores;				// Capacidad en sectores de 512 bytes
+	uint32_t reloj_max;				// Reloj SPI máximo en modo normal [Hz] (TRAN_SPEED); el doble en alta velocidad
+	bool alta_velocidad;			// Admite CMD6 (clase de comandos 10)
+	double t_lectura_us;			// Latencia de lectura: del comando (o del bloque anterior) al token de datos
+	double t_escritura_us;			// Programación de un bloque escrito con CMD24
+	double t_racha_us;				// Programación de cada bloque de una escritura con CMD25
+	bool crc_erroneo;				// Envía los bloques con CRC16 incorrecto
+} sd_modelo_tarjeta_t;
+
+/**
+ * @brief Contadores del bus y tiempo acumulado
+ */
+typedef struct {
+	uint32_t comandos[64];			// Comandos por índice (CMDn y ACMDn juntos)
+	uint32_t acmd23;				// Preborrados ACMD23
+	uint32_t acmd23_bloques;		// Argumento del último ACMD23
+	uint32_t bloques_leidos;
+	uint32_t bloques_escritos;
+	uint32_t racha_max;				// Bloques de la escritura CMD25 más larga
+	uint32_t reloj_identificacion;	// Reloj SPI del último CMD0 [Hz]
+	uint64_t bytes;					// Bytes intercambiados por el bus
+	double tiempo_us;				// Tiempo del bus: bytes, esperas de la tarjeta y retardos
+} sd_modelo_contadores_t;
+
+extern sd_modelo_tarjeta_t sd_modelo_tarjeta;
+extern sd_modelo_contadores_t sd_modelo_cont;
+extern uint8_t (*sd_modelo_imagen)[512];
+
+/**
+ * @brief Reserva la imagen (en ceros) y establece una tarjeta SDHC de 25 MHz con CMD6
+ * @param sectores Capacidad en sectores
+ * @return (bool) false si no hay memoria
+ */
+bool sd_modelo_init(uint32_t sectores);
+
+/**
+ * @brief Pone en cero los contadores y el tiempo
+ */
+void sd_modelo_reiniciar(void);
+
+/**
+ * @brief Reloj SPI programado en SSP1CON1/SSP1ADD
+ * @return (uint32_t) Frecuencia en [Hz]
+ */
+uint32_t sd_modelo_reloj(void);
+
+/**
+ * @brief Da formato FAT16 sin particiones a la imagen (sector 0 como sector de arranque), para los perfiles de FatFs
+ * sin f_mkfs. Requiere entre 4200 y 4 millones de sectores.
+ */
+void sd_modelo_formatear(void);
+
+/**
+ * @brief Crea en el directorio raíz de la imagen formateada un archivo en clusters contiguos, con el byte de la
+ * posición p igual a (uint8_t)(p * 7 + p / 512). Permite medir la lectura en los perfiles de sólo lectura.
+ * @param nombre Nombre 8.3 en el formato de la entrada de directorio (11 caracteres, con espacios)
+ * @param bytes Tamaño del archivo
+ * @return (bool) false si no hay espacio en el directorio raíz o en la imagen
+ */
+bool sd_modelo_archivo(const char *nombre, uint32_t bytes);
+
+#endif	/* SD_MODELO_H */
@@ -46,6 +46,7 @@ SUBSTITUTE GOODS, TECHNOLOGY, SERVICES, OR ANY CLAIMS BY THIRD PARTIES
 
 #include "mcc_generated_files/mcc.h"
 #include "ff.h"
+#include "diskio.h"
 
 FATFS FatFs;	/* FatFs work area needed for each volume */
 FIL Fil;		/* File object needed for each open file */
@@ -90,6 +91,14 @@ void main(void) {
 
 	if (f_mount(&FatFs, "", 1) == FR_OK) {	/* Mount SD */
 
+#if _SD_CACHE
+		{	DWORD fat[2];		/* Keep the FAT area in the sector cache */
+			fat[0] = FatFs.fatbase;
+			fat[1] = FatFs.fsize * FatFs.n_fats;
+			disk_ioctl(0, MMC_CACHE_PIN, fat);
+		}
+#endif
+
 		if (f_open(&Fil, "test.txt", FA_OPEN_ALWAYS | FA_READ | FA_WRITE) == FR_OK) 	/* Open or create a file */
 
 		{	if ((Fil.fsize != 0) && (f_lseek(&Fil, Fil.fsize) != FR_OK)) goto endSD;	/* Jump to the end of the file */
@@ -1035,6 +1035,87 @@ float spi2_readFloat()
 #endif
 
 
+/*
+    Funciones de transferencia de bloques vía SPI. Acceden directamente a SSPxBUF sin llamada a función por byte,
+    por lo que el tiempo entre bytes se reduce al mínimo que permite el reloj SPI.
+    Parámetros:
+    - buffer: Apuntador a datos a transmitir (writeBuffer) o a zona de almacenamiento de datos recibidos (readBuffer)
+    - len: Cantidad de bytes a transferir
+    Retorno: vacío (void)
+    Nota: readBuffer transmite 0xFF como dato de relleno, valor esperado por memorias y tarjetas SD en reposo.
+*/
+#if defined (SPI_V1) || defined (SPI_V4)
+void spi_writeBuffer(const uint8_t *buffer, uint16_t len)
+{
+    uint8_t dato_basura = SSPBUF;   //Lectura de buffer para limpiar bandera de BF (Buffer Full)
+    while(len--)
+    {
+        SSPBUF = *(buffer++);       //Carga registro con dato a enviar
+        while(!SSPSTATbits.BF){}    //Espera mientras se transmite el dato
+        dato_basura = SSPBUF;       //Limpia BF para el siguiente dato
+    }
+}
+
+void spi_readBuffer(uint8_t *buffer, uint16_t len)
+{
+    uint8_t dato_basura = SSPBUF;   //Lectura de buffer para limpiar bandera de BF (Buffer Full)
+    while(len--)
+    {
+        SSPBUF = 0xFF;              //Carga dato de relleno para realizar transferencia
+        while(!SSPSTATbits.BF){}    //Espera mientras se recibe el dato
+        *(buffer++) = SSPBUF;       //Almacena dato recibido
+    }
+}
+#endif
+
+#if defined (SPI_V2) || defined (SPI_V3) || defined (SPI_V5) || defined (SPI_V5_1) || defined (SPI_V5_2) || defined (SPI_V6)
+void spi1_writeBuffer(const uint8_t *buffer, uint16_t len)
+{
+    uint8_t dato_basura = SSP1BUF;  //Lectura de buffer para limpiar bandera de BF (Buffer Full)
+    while(len--)
+    {
+        SSP1BUF = *(buffer++);      //Carga registro con dato a enviar
+        while(!SSP1STATbits.BF){}   //Espera mientras se transmite el dato
+        dato_basura = SSP1BUF;      //Limpia BF para el siguiente dato
+    }
+}
+
+void spi1_readBuffer(uint8_t *buffer, uint16_t len)
+{
+    uint8_t dato_basura = SSP1BUF;  //Lectura de buffer para limpiar bandera de BF (Buffer Full)
+    while(len--)
+    {
+        SSP1BUF = 0xFF;             //Carga dato de relleno para realizar transferencia
+        while(!SSP1STATbits.BF){}   //Espera mientras se recibe el dato
+        *(buffer++) = SSP1BUF;      //Almacena dato recibido
+    }
+}
+#endif
+
+#if defined (SPI_V3) || defined (SPI_V5) || defined (SPI_V5_1) || defined (SPI_V6)
+void spi2_writeBuffer(const uint8_t *buffer, uint16_t len)
+{
+    uint8_t dato_basura = SSP2BUF;  //Lectura de buffer para limpiar bandera de BF (Buffer Full)
+    while(len--)
+    {
+        SSP2BUF = *(buffer++);      //Carga registro con dato a enviar
+        while(!SSP2STATbits.BF){}   //Espera mientras se transmite el dato
+        dato_basura = SSP2BUF;      //Limpia BF para el siguiente dato
+    }
+}
+
+void spi2_readBuffer(uint8_t *buffer, uint16_t len)
+{
+    uint8_t dato_basura = SSP2BUF;  //Lectura de buffer para limpiar bandera de BF (Buffer Full)
+    while(len--)
+    {
+        SSP2BUF = 0xFF;             //Carga dato de relleno para realizar transferencia
+        while(!SSP2STATbits.BF){}   //Espera mientras se recibe el dato
+        *(buffer++) = SSP2BUF;      //Almacena dato recibido
+    }
+}
+#endif
+
 /*
     Funciones para habilitar/deshabilitar el módulo MSSP SPI con fines de ahorro de energía
 */
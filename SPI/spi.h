@@ -71,6 +71,8 @@ void spi_writeInt32(uint32_t dato);			//Escritura de dato entero de 32 bits
 uint32_t spi_readInt32(uint32_t dato);		//Lectura de dato entero de 32 bits
 void spi_writeFloat(float dato);			//Escritura de dato flotante de 32(24) bits
 float spi_readFloat(void);					//Lectura de dato flotante de 32(24) bits
+void spi_writeBuffer(const uint8_t *buffer, uint16_t len);	//Escritura de bloque de datos
+void spi_readBuffer(uint8_t *buffer, uint16_t len);		//Lectura de bloque de datos
 
 void spi_enable(void);							//Habilitación de módulo SSP
 void spi_disable(void);							//Deshabilitación de módulo 
@@ -92,6 +94,8 @@ void spi1_writeInt32(uint32_t dato);			//Escritura de dato entero de 32 bits
 uint32_t spi1_readInt32(uint32_t dato);		//Lectura de dato entero de 32 bits
 void spi1_writeFloat(float dato);			//Escritura de dato flotante de 32(24) bits
 float spi1_readFloat(void);					//Lectura de dato flotante de 32(24) bits
+void spi1_writeBuffer(const uint8_t *buffer, uint16_t len);	//Escritura de bloque de datos
+void spi1_readBuffer(uint8_t *buffer, uint16_t len);		//Lectura de bloque de datos
 
 void spi1_enable(void);							//Habilitación de módulo SSP
 void spi1_disable(void);							//Deshabilitación de módulo 
@@ -115,6 +119,8 @@ void spi2_writeInt32(uint32_t dato);			//Escritura de dato entero de 32 bits
 uint32_t spi2_readInt32(uint32_t dato);		//Lectura de dato entero de 32 bits
 void spi2_writeFloat(float dato);			//Escritura de dato flotante de 32(24) bits
 float spi2_readFloat(void);					//Lectura de dato flotante de 32(24) bits
+void spi2_writeBuffer(const uint8_t *buffer, uint16_t len);	//Escritura de bloque de datos
+void spi2_readBuffer(uint8_t *buffer, uint16_t len);		//Lectura de bloque de datos
 
 void spi2_enable(void);							//Habilitación de módulo SSP
 void spi2_disable(void);							//Deshabilitación de módulo
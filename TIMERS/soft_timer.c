@@ -0,0 +1,251 @@
+/**
+ * @file soft_timer.c
+ * @brief Servicio de temporizadores por software multiplexados sobre el Timer0: rueda de tiempo (timing wheel) con inicio y
+ * paro en tiempo constante, modos de un disparo y periódico, funciones de notificación y modo sin tick periódico (tickless)
+ * que programa el Timer0 directamente para la siguiente expiración.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "soft_timer.h"
+
+#define SOFT_TIMER_MASCARA	(SOFT_TIMER_RANURAS - 1)
+
+static soft_timer_t *_soft_timer_ranuras[SOFT_TIMER_RANURAS];	// Listas de temporizadores por ranura
+static soft_timer_t *_soft_timer_cursor = NULL;					// Siguiente temporizador a procesar en la ranura en curso
+static volatile uint8_t _soft_timer_pos = 0;					// Última ranura procesada
+static volatile uint32_t _soft_timer_ticks = 0;					// Ticks procesados
+static volatile uint16_t _soft_timer_salto = 0;					// Ticks del periodo actual del Timer0 (0 dentro de la interrupción)
+
+/*
+	Inserción al inicio de la lista de la ranura que corresponde a 'retardo' ticks después de la última ranura procesada
+*/
+static void _soft_timer_insertar(soft_timer_t *t, uint24_t retardo)
+{
+	uint8_t ranura = (uint8_t)((_soft_timer_pos + retardo) & SOFT_TIMER_MASCARA);
+	t->rondas = (uint16_t)((retardo - 1) / SOFT_TIMER_RANURAS);
+	t->ranura = ranura;
+	t->anterior = NULL;
+	t->siguiente = _soft_timer_ranuras[ranura];
+	if(t->siguiente != NULL)
+	{
+		t->siguiente->anterior = t;
+	}
+	_soft_timer_ranuras[ranura] = t;
+	t->activo = true;
+}
+
+/*
+	Retiro de la lista de su ranura
+*/
+static void _soft_timer_desenlazar(soft_timer_t *t)
+{
+	if(_soft_timer_cursor == t)
+	{
+		_soft_timer_cursor = t->siguiente;	// El recorrido de la ranura en curso continúa con el siguiente
+	}
+	if(t->anterior != NULL)
+	{
+		t->anterior->siguiente = t->siguiente;
+	}
+	else
+	{
+		_soft_timer_ranuras[t->ranura] = t->siguiente;
+	}
+	if(t->siguiente != NULL)
+	{
+		t->siguiente->anterior = t->anterior;
+	}
+	t->siguiente = NULL;
+	t->anterior = NULL;
+	t->activo = false;
+}
+
+/*
+	Recarga relativa del Timer0: suma 'cuentas' a su valor sin perder la fase del tick. Escribir TMR0L borra el preescalador
+	e inhibe el conteo dos ciclos, y el Timer0 avanza entre la lectura y la escritura. La escritura se sincroniza con un
+	incremento del Timer0 (preescalador en cero) y el valor escrito incluye las cuentas de la secuencia fija hasta la
+	escritura (SOFT_TIMER_AJUSTE); el error residual es menor a media cuenta por recarga y nulo sin preescala.
+*/
+static void _soft_timer_recargar(uint16_t cuentas)
+{
+	uint8_t l = TMR0L;
+	uint16_t valor;
+	#if (SOFT_TIMER_PREESCALA > 1)
+	uint8_t previo = l;
+	while((l = TMR0L) == previo)
+	{
+	}
+	#endif
+	valor = make16(TMR0H, l) + cuentas + SOFT_TIMER_AJUSTE;	// TMR0H se actualizó con la lectura de TMR0L
+	TMR0H = make8(valor, 1);
+	TMR0L = make8(valor, 0);
+}
+
+/*
+	Ticks completos transcurridos desde la última ranura procesada. Debe llamarse con TMR0IE deshabilitado.
+*/
+static uint16_t _soft_timer_transcurridos(void)
+{
+	uint16_t cuenta;
+	if(_soft_timer_salto == 0)
+	{
+		return 0;		// Dentro de la interrupción: la ranura en curso es el tiempo actual
+	}
+	cuenta = get_timer0();
+	if(INTCONbits.TMR0IF)
+	{
+		return _soft_timer_salto;	// Desborde pendiente de atender
+	}
+	// El Timer0 se cargó con -(salto * cuentas) en la última frontera de tick
+	cuenta += (uint16_t)(_soft_timer_salto * SOFT_TIMER_CUENTAS);
+	return cuenta / SOFT_TIMER_CUENTAS;
+}
+
+/*
+	Procesamiento de una ranura: expiración, reinserción de periódicos y notificación
+*/
+static void _soft_timer_procesar(uint8_t ranura)
+{
+	soft_timer_t *t = _soft_timer_ranuras[ranura];
+	while(t != NULL)
+	{
+		_soft_timer_cursor = t->siguiente;
+		if(t->rondas != 0)
+		{
+			t->rondas--;
+		}
+		else
+		{
+			_soft_timer_desenlazar(t);
+			if(t->periodo != 0)
+			{
+				_soft_timer_insertar(t, t->periodo);	// Antes de notificar, para que la notificación pueda detenerlo
+			}
+			if(t->callback != NULL)
+			{
+				t->callback(t->contexto);
+			}
+		}
+		t = _soft_timer_cursor;
+	}
+}
+
+void soft_timer_init(void)
+{
+	uint16_t i;
+	INTCONbits.TMR0IE = 0;
+	for(i = 0; i < SOFT_TIMER_RANURAS; i++)
+	{
+		_soft_timer_ranuras[i] = NULL;
+	}
+	_soft_timer_cursor = NULL;
+	_soft_timer_pos = 0;
+	_soft_timer_ticks = 0;
+	_soft_timer_salto = 1;
+	timer0_init(TIMER0_16BIT | TIMER0_INTERNAL | SOFT_TIMER_T0_DIV);
+	set_timer0((uint16_t)(0 - SOFT_TIMER_CUENTAS));
+	INTCONbits.TMR0IE = 1;
+	T0CONbits.TMR0ON = 1;
+}
+
+void soft_timer_create(soft_timer_t *t, soft_timer_callback_t callback, void *contexto)
+{
+	t->siguiente = NULL;
+	t->anterior = NULL;
+	t->callback = callback;
+	t->contexto = contexto;
+	t->periodo = 0;
+	t->rondas = 0;
+	t->ranura = 0;
+	t->activo = false;
+}
+
+void soft_timer_start(soft_timer_t *t, uint16_t ticks, bool periodico)
+{
+	uint16_t transcurridos;
+	bool ie = INTCONbits.TMR0IE;
+	if(ticks == 0)
+	{
+		ticks = 1;
+	}
+	INTCONbits.TMR0IE = 0;
+	if(t->activo)
+	{
+		_soft_timer_desenlazar(t);
+	}
+	transcurridos = _soft_timer_transcurridos();
+	t->periodo = periodico ? ticks : 0;
+	_soft_timer_insertar(t, (uint24_t)transcurridos + ticks);
+	#if defined (SOFT_TIMER_TICKLESS)
+	// Si la nueva expiración ocurre antes del fin del salto programado, se acorta el periodo del Timer0
+	if(_soft_timer_salto != 0 && !INTCONbits.TMR0IF && (uint24_t)transcurridos + ticks < _soft_timer_salto)
+	{
+		uint16_t nuevo = transcurridos + ticks;
+		_soft_timer_recargar((uint16_t)((_soft_timer_salto - nuevo) * SOFT_TIMER_CUENTAS));
+		_soft_timer_salto = nuevo;
+	}
+	#endif
+	INTCONbits.TMR0IE = ie;
+}
+
+void soft_timer_stop(soft_timer_t *t)
+{
+	bool ie = INTCONbits.TMR0IE;
+	INTCONbits.TMR0IE = 0;
+	if(t->activo)
+	{
+		_soft_timer_desenlazar(t);
+	}
+	INTCONbits.TMR0IE = ie;
+}
+
+bool soft_timer_isActive(const soft_timer_t *t)
+{
+	return t->activo;
+}
+
+uint32_t soft_timer_getTicks(void)
+{
+	uint32_t ticks;
+	bool ie = INTCONbits.TMR0IE;
+	INTCONbits.TMR0IE = 0;
+	ticks = _soft_timer_ticks + _soft_timer_transcurridos();
+	INTCONbits.TMR0IE = ie;
+	return ticks;
+}
+
+void soft_timer_interruptHandler(void)
+{
+	uint16_t pasos;
+	uint16_t salto = 1;
+	if(!(INTCONbits.TMR0IF && INTCONbits.TMR0IE))
+	{
+		return;
+	}
+	INTCONbits.TMR0IF = 0;
+	pasos = _soft_timer_salto;
+	_soft_timer_salto = 0;
+	while(pasos != 0)
+	{
+		pasos--;
+		_soft_timer_pos = (_soft_timer_pos + 1) & SOFT_TIMER_MASCARA;
+		_soft_timer_ticks++;
+		_soft_timer_procesar(_soft_timer_pos);
+	}
+	_soft_timer_cursor = NULL;
+	#if defined (SOFT_TIMER_TICKLESS)
+	// Salto hasta la siguiente ranura ocupada; sin temporizadores activos, el salto máximo
+	while(salto <= SOFT_TIMER_RANURAS && _soft_timer_ranuras[(_soft_timer_pos + salto) & SOFT_TIMER_MASCARA] == NULL)
+	{
+		salto++;
+	}
+	if(salto > SOFT_TIMER_RANURAS || salto > SOFT_TIMER_MAX_SALTO)
+	{
+		salto = SOFT_TIMER_MAX_SALTO;
+	}
+	#endif
+	// Recarga relativa: las cuentas transcurridas desde el desborde se conservan
+	_soft_timer_recargar((uint16_t)(0 - salto * SOFT_TIMER_CUENTAS));
+	_soft_timer_salto = salto;
+}
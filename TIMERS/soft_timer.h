@@ -0,0 +1,188 @@
+/**
+ * @file soft_timer.h
+ * @brief Servicio de temporizadores por software multiplexados sobre el Timer0: rueda de tiempo (timing wheel) con inicio y
+ * paro en tiempo constante, modos de un disparo y periódico, funciones de notificación y modo sin tick periódico (tickless)
+ * que programa el Timer0 directamente para la siguiente expiración.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef SOFT_TIMER_H
+#define	SOFT_TIMER_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "../../pconfig.h"
+#include "timers.h"
+
+/**
+ * @brief Duración del tick en microsegundos. Puede redefinirse en pconfig.h
+ */
+#ifndef SOFT_TIMER_TICK_US
+#define SOFT_TIMER_TICK_US		1000
+#endif
+
+/**
+ * @brief Número de ranuras de la rueda de tiempo (potencia de 2). Un temporizador con retardo mayor que el número de
+ * ranuras da vueltas adicionales a la rueda; más ranuras reducen el trabajo por tick con muchos temporizadores.
+ */
+#ifndef SOFT_TIMER_RANURAS
+#define SOFT_TIMER_RANURAS		16
+#endif
+
+/*
+	Con SOFT_TIMER_TICKLESS definido en pconfig.h el Timer0 no interrumpe en cada tick: se programa para la siguiente
+	ranura ocupada de la rueda (hasta SOFT_TIMER_MAX_SALTO ticks), lo que reduce las interrupciones en reposo.
+*/
+
+#if !defined (_XTAL_FREQ)
+#error "soft_timer requiere _XTAL_FREQ"
+#endif
+
+/* Ciclos de instrucción por tick */
+#define SOFT_TIMER_CICLOS_TICK	((_XTAL_FREQ) / 4000UL * (SOFT_TIMER_TICK_US) / 1000UL)
+
+/*
+	Preescala del Timer0: la menor que permite representar un tick en 16 bits (máxima precisión). Puede fijarse en pconfig.h
+	con SOFT_TIMER_PREESCALA (1, 2, 4, ..., 256); en modo tickless una preescala mayor permite saltos más largos.
+*/
+#ifndef SOFT_TIMER_PREESCALA
+#if (SOFT_TIMER_CICLOS_TICK <= 65535UL)
+#define SOFT_TIMER_PREESCALA	1
+#elif (SOFT_TIMER_CICLOS_TICK <= 2 * 65535UL)
+#define SOFT_TIMER_PREESCALA	2
+#elif (SOFT_TIMER_CICLOS_TICK <= 4 * 65535UL)
+#define SOFT_TIMER_PREESCALA	4
+#elif (SOFT_TIMER_CICLOS_TICK <= 8 * 65535UL)
+#define SOFT_TIMER_PREESCALA	8
+#elif (SOFT_TIMER_CICLOS_TICK <= 16 * 65535UL)
+#define SOFT_TIMER_PREESCALA	16
+#elif (SOFT_TIMER_CICLOS_TICK <= 32 * 65535UL)
+#define SOFT_TIMER_PREESCALA	32
+#elif (SOFT_TIMER_CICLOS_TICK <= 64 * 65535UL)
+#define SOFT_TIMER_PREESCALA	64
+#elif (SOFT_TIMER_CICLOS_TICK <= 128 * 65535UL)
+#define SOFT_TIMER_PREESCALA	128
+#else
+#define SOFT_TIMER_PREESCALA	256
+#endif
+#endif
+
+#if (SOFT_TIMER_PREESCALA == 1)
+#define SOFT_TIMER_T0_DIV		TIMER0_DIV_1
+#elif (SOFT_TIMER_PREESCALA == 2)
+#define SOFT_TIMER_T0_DIV		TIMER0_DIV_2
+#elif (SOFT_TIMER_PREESCALA == 4)
+#define SOFT_TIMER_T0_DIV		TIMER0_DIV_4
+#elif (SOFT_TIMER_PREESCALA == 8)
+#define SOFT_TIMER_T0_DIV		TIMER0_DIV_8
+#elif (SOFT_TIMER_PREESCALA == 16)
+#define SOFT_TIMER_T0_DIV		TIMER0_DIV_16
+#elif (SOFT_TIMER_PREESCALA == 32)
+#define SOFT_TIMER_T0_DIV		TIMER0_DIV_32
+#elif (SOFT_TIMER_PREESCALA == 64)
+#define SOFT_TIMER_T0_DIV		TIMER0_DIV_64
+#elif (SOFT_TIMER_PREESCALA == 128)
+#define SOFT_TIMER_T0_DIV		TIMER0_DIV_128
+#elif (SOFT_TIMER_PREESCALA == 256)
+#define SOFT_TIMER_T0_DIV		TIMER0_DIV_256
+#else
+#error "SOFT_TIMER_PREESCALA debe ser potencia de 2 entre 1 y 256"
+#endif
+
+/* Cuentas del Timer0 por tick y máximo número de ticks por periodo del Timer0 */
+#define SOFT_TIMER_CUENTAS		(SOFT_TIMER_CICLOS_TICK / SOFT_TIMER_PREESCALA)
+#define SOFT_TIMER_MAX_SALTO	(65535UL / SOFT_TIMER_CUENTAS)
+
+#if (SOFT_TIMER_CUENTAS == 0) || (SOFT_TIMER_CUENTAS > 65535UL)
+#error "SOFT_TIMER_TICK_US no representable con SOFT_TIMER_PREESCALA"
+#endif
+#if (SOFT_TIMER_RANURAS & (SOFT_TIMER_RANURAS - 1)) != 0 || (SOFT_TIMER_RANURAS > 256)
+#error "SOFT_TIMER_RANURAS debe ser potencia de 2 no mayor que 256"
+#endif
+
+/*
+	Ciclos de instrucción entre la lectura de TMR0L y la escritura de TMR0L en la recarga relativa del Timer0 (secuencia fija
+	tras la sincronización con un incremento). Depende del compilador y su nivel de optimización: medir con el cronómetro del
+	simulador de MPLAB y definir en pconfig.h.
+*/
+#ifndef SOFT_TIMER_CICLOS_RECARGA
+#define SOFT_TIMER_CICLOS_RECARGA	14
+#endif
+
+/* Cuentas perdidas en la recarga: secuencia de lectura a escritura más los dos ciclos de conteo inhibido tras escribir TMR0 */
+#define SOFT_TIMER_AJUSTE		((SOFT_TIMER_CICLOS_RECARGA + 2 + SOFT_TIMER_PREESCALA / 2) / SOFT_TIMER_PREESCALA)
+
+/* Conversión de milisegundos a ticks, redondeada hacia arriba. Constante si ms es constante */
+#define SOFT_TIMER_MS(ms)		((uint16_t)(((uint32_t)(ms) * 1000UL + (SOFT_TIMER_TICK_US) - 1) / (SOFT_TIMER_TICK_US)))
+
+/**
+ * @brief Función de notificación de expiración. Se ejecuta en contexto de interrupción, por lo que debe ser breve
+ * (p.ej. activar una bandera o un evento). Puede iniciar o detener temporizadores, incluido el propio.
+ * @param contexto Apuntador registrado en soft_timer_create
+ */
+typedef void (*soft_timer_callback_t)(void *contexto);
+
+/**
+ * @brief Temporizador por software. La aplicación reserva la estructura (típicamente estática) y no debe modificar sus campos.
+ */
+typedef struct soft_timer_t {
+	struct soft_timer_t *siguiente;		// Lista doblemente enlazada de la ranura
+	struct soft_timer_t *anterior;
+	soft_timer_callback_t callback;
+	void *contexto;
+	uint16_t periodo;					// Ticks entre expiraciones en modo periódico, 0 en modo de un disparo
+	uint16_t rondas;					// Vueltas completas de la rueda pendientes
+	uint8_t ranura;
+	bool activo;
+} soft_timer_t;
+
+/**
+ * @brief Configura el Timer0 en modo de 16 bits, reinicia la rueda y habilita la interrupción del Timer0 (TMR0IE).
+ * La habilitación global de interrupciones queda a cargo de la aplicación.
+ */
+void soft_timer_init(void);
+
+/**
+ * @brief Inicializa un temporizador detenido. No debe llamarse sobre un temporizador activo (detenerlo antes con soft_timer_stop).
+ * @param t Temporizador
+ * @param callback Función de notificación (NULL si solo se consulta con soft_timer_isActive)
+ * @param contexto Apuntador que se entrega a la función de notificación
+ */
+void soft_timer_create(soft_timer_t *t, soft_timer_callback_t callback, void *contexto);
+
+/**
+ * @brief Inicia (o reinicia) un temporizador. Tiempo constante.
+ * @param t Temporizador
+ * @param ticks Ticks hasta la expiración (mínimo 1; SOFT_TIMER_MS convierte desde milisegundos)
+ * @param periodico true para repetir cada ticks, false para un disparo
+ */
+void soft_timer_start(soft_timer_t *t, uint16_t ticks, bool periodico);
+
+/**
+ * @brief Detiene un temporizador. Tiempo constante. No tiene efecto si el temporizador no está activo.
+ * @param t Temporizador
+ */
+void soft_timer_stop(soft_timer_t *t);
+
+/**
+ * @brief Indica si un temporizador está activo. Un temporizador de un disparo deja de estar activo al expirar.
+ * @param t Temporizador
+ * @return (bool) true si el temporizador está activo
+ */
+bool soft_timer_isActive(const soft_timer_t *t);
+
+/**
+ * @brief Número de ticks transcurridos desde soft_timer_init
+ * @return (uint32_t) Ticks
+ */
+uint32_t soft_timer_getTicks(void);
+
+/**
+ * @brief Función de manejo de interrupción del Timer0. Debe llamarse desde la rutina de interrupción.
+ */
+void soft_timer_interruptHandler(void);
+
+#endif	/* SOFT_TIMER_H */
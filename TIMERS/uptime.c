@@ -0,0 +1,146 @@
+/**
+ * @file uptime.c
+ * @brief Reloj monotónico de 64 bits en microsegundos: un temporizador de 16 bits de conteo libre (Timer1, Timer3 o Timer5)
+ * extendido por un contador de desbordes por software. Lectura atómica sin deshabilitar interrupciones, conversión a [us]
+ * con factores de punto fijo calculados a partir de _XTAL_FREQ y funciones de tiempo transcurrido de bajo costo.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#include "uptime.h"
+
+/*
+	Registros del temporizador seleccionado. Modo de lectura de 16 bits: la lectura de TMRxL captura TMRxH.
+*/
+#if (UPTIME_TIMER == 1)
+#define _UPTIME_IF			TMR1IF
+#define _UPTIME_IE			TMR1IE
+#define _UPTIME_ON			T1CONbits.TMR1ON
+#define _uptime_leer()		get_timer1()
+#if defined (TMR_V1) || defined (TMR_V2) || defined (TMR_V3) || defined (TMR_V4) || defined (TMR_V5)
+#define _uptime_config()	timer1_init(TIMER1_INTERNAL | TIMER1_OSCEN_OFF | TIMER1_16BIT_RW | UPTIME_DIV)
+#elif defined (TMR_V6) || defined (TMR_V7) || defined (TMR_V7_1) || defined (TMR_V7_2) || defined (TMR_V7_3) ||\
+	defined (TMR_V7_4) || defined (TMR_V7_5)
+#define _uptime_config()	timer1_init(TIMER1_INTERNAL_INST_CLK | TIMER1_OSCEN_OFF | TIMER1_16BIT_RW | UPTIME_DIV, 0)
+#else
+#error "Timer1 no disponible para uptime en esta versión"
+#endif
+
+#elif (UPTIME_TIMER == 3)
+#define _UPTIME_IF			TMR3IF
+#define _UPTIME_IE			TMR3IE
+#define _UPTIME_ON			T3CONbits.TMR3ON
+#define _uptime_leer()		get_timer3()
+#if defined (TMR_V2) || defined (TMR_V4)
+#define _uptime_config()	timer3_init(TIMER3_INTERNAL | TIMER3_16BIT_RW | UPTIME_DIV)
+#elif defined (TMR_V6) || defined (TMR_V7) || defined (TMR_V7_1) || defined (TMR_V7_2) || defined (TMR_V7_3) ||\
+	defined (TMR_V7_4) || defined (TMR_V7_5)
+#define _uptime_config()	timer3_init(TIMER3_INTERNAL_INST_CLK | TIMER3_OSCEN_OFF | TIMER3_16BIT_RW | UPTIME_DIV, 0)
+#else
+#error "Timer3 no disponible para uptime en esta versión"
+#endif
+
+#elif (UPTIME_TIMER == 5)
+#define _UPTIME_IF			TMR5IF
+#define _UPTIME_IE			TMR5IE
+#define _UPTIME_ON			T5CONbits.TMR5ON
+#define _uptime_leer()		get_timer5()
+#if defined (TMR_V7) || defined (TMR_V7_1) || defined (TMR_V7_3) || defined (TMR_V7_4)
+#define _uptime_config()	timer5_init(TIMER5_INTERNAL_INST_CLK | TIMER5_OSCEN_OFF | TIMER5_16BIT_RW | UPTIME_DIV, 0)
+#else
+#error "Timer5 no disponible para uptime en esta versión (en TMR_V5 el Timer5 tiene registro de periodo)"
+#endif
+
+#else
+#error "UPTIME_TIMER debe ser 1, 3 o 5"
+#endif
+
+static volatile uint32_t _uptime_desbordes = 0;		// Parte alta del conteo
+
+/*
+	Lectura consistente de parte alta y cuenta del temporizador. Si la interrupción de desborde se atiende durante la lectura,
+	el contador cambia y se repite (una lectura parcial de sus 4 bytes también se detecta así). Con interrupciones
+	deshabilitadas el contador no cambia, pero el desborde puede estar pendiente: una cuenta en la mitad baja con la bandera
+	activa indica que el desborde ocurrió antes de leerla.
+*/
+static uint16_t _uptime_leerCuentas(uint32_t *alto)
+{
+	uint32_t desbordes;
+	uint16_t cuenta;
+	bool pendiente;
+	do
+	{
+		desbordes = _uptime_desbordes;
+		cuenta = _uptime_leer();
+		pendiente = _UPTIME_IF;
+	} while(desbordes != _uptime_desbordes);
+	if(pendiente && cuenta < 0x8000)
+	{
+		desbordes++;
+	}
+	*alto = desbordes;
+	return cuenta;
+}
+
+void uptime_init(void)
+{
+	_UPTIME_IE = 0;
+	_uptime_config();
+	_uptime_desbordes = 0;
+	_UPTIME_IE = 1;
+	_UPTIME_ON = 1;
+}
+
+uint64_t uptime_getTicks(void)
+{
+	uint32_t alto;
+	uint16_t cuenta = _uptime_leerCuentas(&alto);
+	return ((uint64_t)alto << 16) | cuenta;
+}
+
+uint32_t uptime_getTicks32(void)
+{
+	uint32_t alto;
+	uint16_t cuenta = _uptime_leerCuentas(&alto);
+	return (alto << 16) | cuenta;
+}
+
+uint64_t uptime_ticksToUs(uint64_t cuentas)
+{
+	/*
+		us = cuentas * Q24 / 2^24, separando cuentas = alto * 2^16 + bajo para no desbordar 64 bits:
+		alto * 2^16 * Q24 / 2^24 = (alto * Q24) / 2^8; los 8 bits que se descartan se suman a la parte baja.
+	*/
+	uint64_t alto = (cuentas >> 16) * UPTIME_US_Q24;
+	uint64_t bajo = (uint64_t)(uint16_t)cuentas * UPTIME_US_Q24;
+	return (alto >> 8) + ((((alto & 0xFF) << 16) + bajo) >> 24);
+}
+
+uint64_t uptime_getUs(void)
+{
+	return uptime_ticksToUs(uptime_getTicks());
+}
+
+uint32_t uptime_elapsed(uint32_t desde)
+{
+	return uptime_getTicks32() - desde;
+}
+
+uint32_t uptime_elapsedUs(uint32_t desde)
+{
+	return (uint32_t)(((uint64_t)uptime_elapsed(desde) * UPTIME_US_Q24) >> 24);
+}
+
+bool uptime_expired(uint32_t desde, uint32_t cuentas)
+{
+	return uptime_elapsed(desde) >= cuentas;
+}
+
+void uptime_interruptHandler(void)
+{
+	if(_UPTIME_IF && _UPTIME_IE)
+	{
+		_UPTIME_IF = 0;
+		_uptime_desbordes++;
+	}
+}
@@ -0,0 +1,128 @@
+/**
+ * @file uptime.h
+ * @brief Reloj monotónico de 64 bits en microsegundos: un temporizador de 16 bits de conteo libre (Timer1, Timer3 o Timer5)
+ * extendido por un contador de desbordes por software. Lectura atómica sin deshabilitar interrupciones, conversión a [us]
+ * con factores de punto fijo calculados a partir de _XTAL_FREQ y funciones de tiempo transcurrido de bajo costo.
+ * @author Ing. José Roberto Parra Trewartha
+ * @version 1.0
+*/
+
+#ifndef UPTIME_H
+#define	UPTIME_H
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "../../pconfig.h"
+#include "timers.h"
+
+/**
+ * @brief Temporizador de 16 bits utilizado (1, 3 o 5). Puede redefinirse en pconfig.h
+ */
+#ifndef UPTIME_TIMER
+#define UPTIME_TIMER		1
+#endif
+
+/**
+ * @brief Preescala del temporizador (1, 2, 4 u 8). Una preescala mayor reduce la frecuencia de desbordes a costa de resolución.
+ */
+#ifndef UPTIME_PREESCALA
+#define UPTIME_PREESCALA	1
+#endif
+
+#if !defined (_XTAL_FREQ)
+#error "uptime requiere _XTAL_FREQ"
+#endif
+
+/* Los bits de preescala ocupan la misma posición en T1CON, T3CON y T5CON */
+#if (UPTIME_PREESCALA == 1)
+#define UPTIME_DIV			TIMER1_DIV_1
+#elif (UPTIME_PREESCALA == 2)
+#define UPTIME_DIV			TIMER1_DIV_2
+#elif (UPTIME_PREESCALA == 4)
+#define UPTIME_DIV			TIMER1_DIV_4
+#elif (UPTIME_PREESCALA == 8)
+#define UPTIME_DIV			TIMER1_DIV_8
+#else
+#error "UPTIME_PREESCALA debe ser 1, 2, 4 u 8"
+#endif
+
+/* Frecuencia de conteo del temporizador [Hz] */
+#define UPTIME_FRECUENCIA	((_XTAL_FREQ) / 4UL / (UPTIME_PREESCALA))
+
+/*
+	Factor de conversión de cuentas a microsegundos en punto fijo Q24 (us por cuenta * 2^24), redondeado. El error relativo
+	es menor a 2^-24 / (us por cuenta), muy por debajo de la tolerancia del cristal.
+*/
+#define UPTIME_US_Q24		((uint32_t)((4000000ULL * (UPTIME_PREESCALA) * 16777216ULL + (_XTAL_FREQ) / 2) / (_XTAL_FREQ)))
+
+/* Conversión de microsegundos a cuentas, redondeada hacia arriba (para plazos). Constante si us es constante */
+#define UPTIME_US(us)		((uint32_t)(((uint64_t)(us) * UPTIME_FRECUENCIA + 999999UL) / 1000000UL))
+
+/* Conversión de milisegundos a cuentas, redondeada hacia arriba */
+#define UPTIME_MS(ms)		((uint32_t)(((uint64_t)(ms) * UPTIME_FRECUENCIA + 999UL) / 1000UL))
+
+/**
+ * @brief Configura el temporizador en modo de conteo libre de 16 bits con reloj de instrucciones, reinicia el contador
+ * de desbordes, habilita su interrupción y lo enciende. La habilitación global de interrupciones queda a cargo de la aplicación.
+ */
+void uptime_init(void);
+
+/**
+ * @brief Cuentas del temporizador desde uptime_init (48 bits significativos). Lectura sin deshabilitar interrupciones:
+ * se repite si un desborde se atiende durante la lectura, y contempla un desborde pendiente si se llama con interrupciones
+ * deshabilitadas (p.ej. desde otra rutina de interrupción).
+ * @return (uint64_t) Cuentas
+ */
+uint64_t uptime_getTicks(void);
+
+/**
+ * @brief 32 bits bajos de las cuentas, de menor costo que uptime_getTicks. Base para medir intervalos cortos
+ * (hasta 2^32 cuentas, p.ej. 429 s a 40 MHz sin preescala) con uptime_elapsed y uptime_expired.
+ * @return (uint32_t) Cuentas
+ */
+uint32_t uptime_getTicks32(void);
+
+/**
+ * @brief Microsegundos desde uptime_init. Monotónico.
+ * @return (uint64_t) Tiempo en [us]
+ */
+uint64_t uptime_getUs(void);
+
+/**
+ * @brief Convierte cuentas a microsegundos con el factor UPTIME_US_Q24
+ * @param cuentas Cuentas del temporizador (hasta 48 bits)
+ * @return (uint64_t) Tiempo en [us]
+ */
+uint64_t uptime_ticksToUs(uint64_t cuentas);
+
+/**
+ * @brief Cuentas transcurridas desde una marca de uptime_getTicks32. Correcta a través del desborde de 32 bits.
+ * @param desde Marca de tiempo
+ * @return (uint32_t) Cuentas transcurridas
+ */
+uint32_t uptime_elapsed(uint32_t desde);
+
+/**
+ * @brief Microsegundos transcurridos desde una marca de uptime_getTicks32
+ * @param desde Marca de tiempo
+ * @return (uint32_t) Tiempo transcurrido en [us]
+ */
+uint32_t uptime_elapsedUs(uint32_t desde);
+
+/**
+ * @brief Indica si transcurrió un plazo desde una marca de uptime_getTicks32
+ * @param desde Marca de tiempo
+ * @param cuentas Plazo en cuentas (UPTIME_US y UPTIME_MS convierten desde [us] y [ms])
+ * @return (bool) true si el plazo transcurrió
+ */
+bool uptime_expired(uint32_t desde, uint32_t cuentas);
+
+/**
+ * @brief Función de manejo de interrupción por desborde del temporizador. Debe llamarse desde la rutina de interrupción
+ * de mayor prioridad que lea el reloj (con prioridades, las lecturas desde la rutina de alta prioridad requieren que
+ * este manejador también se atienda en alta prioridad).
+ */
+void uptime_interruptHandler(void);
+
+#endif	/* UPTIME_H */